@@ -1,9 +1,12 @@
 #include "Authenticator.h"
+#include "Logger.h"
   
-  Authenticator::Authenticator() {
-        auth_message = R"({
+  Authenticator::Authenticator() {}
+
+    void Authenticator::send_authcall(client* c, websocketpp::connection_hdl hdl, int64_t id) {
+        std::string auth_message = R"({
             "jsonrpc": "2.0",
-            "id": 9929,
+            "id": )" + std::to_string(id) + R"(,
             "method": "public/auth",
             "params": {
                 "grant_type": "client_credentials",
@@ -11,12 +14,9 @@
                 "client_secret": ")" + client_secret + R"("
             }
         })";
-    }
-
-    void Authenticator::send_authcall(client* c, websocketpp::connection_hdl hdl) {
         websocketpp::lib::error_code ec;
         c->send(hdl, auth_message, websocketpp::frame::opcode::text, ec);
         if (ec) {
-            std::cout << "Error sending authentication message: " << ec.message() << std::endl;
+            LOG_ERROR("Error sending authentication message: {}", ec.message());
         }
     }
\ No newline at end of file
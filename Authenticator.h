@@ -17,7 +17,6 @@ private:
     const std::string client_id = get_client_id();
     const std::string client_secret = get_client_secret();
 
-    std::string auth_message;
 
     std::string get_client_id() {
         const char* client_id = std::getenv("CLIENT_ID");
@@ -42,5 +41,6 @@ private:
 public:
   Authenticator();
 
-  void send_authcall(client* c,websocketpp::connection_hdl hdl);
+  // id comes from the OrderManager's sequence, so the answer can't be taken for one of its requests
+  void send_authcall(client* c,websocketpp::connection_hdl hdl, int64_t id);
 };
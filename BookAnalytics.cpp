@@ -0,0 +1,241 @@
+#include "BookAnalytics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOOK_ANALYTICS_AVX2 1
+#endif
+
+static_assert(sizeof(BookLevel) == 16 && offsetof(BookLevel, amount) == 8,
+              "Kernels read levels as (price, amount) pairs of raw int64");
+
+// Kernels work in raw fixed-point units held in doubles and take a side as the book stores
+// it: end points one past the best level, so the i-th best level is end[-1 - i].
+struct SideSums {
+    double amount = 0.0;        // Raw amount
+    double notional = 0.0;      // Raw price times raw amount
+};
+
+struct Kernels {
+    const char* name;
+    // Sums over the best n levels
+    SideSums (*sums)(const BookLevel* end, size_t n);
+    // out[i] = amount of the best i + 1 levels, times scale, for i < n
+    void (*cumulative)(const BookLevel* end, size_t n, double scale, double* out);
+    // How many of the best n levels together hold less than size, with their sums in taken
+    size_t (*levelsBelow)(const BookLevel* end, size_t n, double size, SideSums& taken);
+};
+
+static SideSums sumsScalar(const BookLevel* end, size_t n) {
+    SideSums sums;
+    for (size_t i = 0; i < n; ++i) {
+        const BookLevel& level = end[-1 - static_cast<ptrdiff_t>(i)];
+        double amount = static_cast<double>(level.amount.raw);
+        sums.amount += amount;
+        sums.notional += static_cast<double>(level.price.raw) * amount;
+    }
+    return sums;
+}
+
+static void cumulativeScalar(const BookLevel* end, size_t n, double scale, double* out) {
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        total += static_cast<double>(end[-1 - static_cast<ptrdiff_t>(i)].amount.raw);
+        out[i] = total * scale;
+    }
+}
+
+static size_t levelsBelowScalar(const BookLevel* end, size_t n, double size, SideSums& taken) {
+    for (size_t i = 0; i < n; ++i) {
+        const BookLevel& level = end[-1 - static_cast<ptrdiff_t>(i)];
+        double amount = static_cast<double>(level.amount.raw);
+        if (taken.amount + amount >= size) return i;
+        taken.amount += amount;
+        taken.notional += static_cast<double>(level.price.raw) * amount;
+    }
+    return n;
+}
+
+static const Kernels scalarKernels = {"scalar", sumsScalar, cumulativeScalar, levelsBelowScalar};
+
+#ifdef BOOK_ANALYTICS_AVX2
+#define AVX2_KERNEL __attribute__((target("avx2,fma")))
+
+// Exact int64 to double over the whole range (AVX2 has no instruction for it): the
+// high and low parts are spliced into the mantissas of two biased doubles and recombined
+AVX2_KERNEL static inline __m256d int64ToDouble(__m256i x) {
+    __m256i high = _mm256_srai_epi32(x, 16);
+    high = _mm256_blend_epi16(high, _mm256_setzero_si256(), 0x33);
+    high = _mm256_add_epi64(high, _mm256_castpd_si256(_mm256_set1_pd(442721857769029238784.)));    // 3 * 2^67
+    __m256i low = _mm256_blend_epi16(x, _mm256_castpd_si256(_mm256_set1_pd(0x0010000000000000)), 0x88);   // 2^52
+    __m256d value = _mm256_sub_pd(_mm256_castsi256_pd(high), _mm256_set1_pd(442726361368656609280.));  // 3 * 2^67 + 2^52
+    return _mm256_add_pd(value, _mm256_castsi256_pd(low));
+}
+
+// The four levels below end, deinterleaved. Lanes hold end[-4], end[-2], end[-3], end[-1].
+AVX2_KERNEL static inline void loadFour(const BookLevel* end, __m256d& prices, __m256d& amounts) {
+    __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(end - 4));
+    __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(end - 2));
+    prices = int64ToDouble(_mm256_unpacklo_epi64(first, second));
+    amounts = int64ToDouble(_mm256_unpackhi_epi64(first, second));
+}
+
+AVX2_KERNEL static inline double horizontalSum(__m256d v) {
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+AVX2_KERNEL static SideSums sumsAvx2(const BookLevel* end, size_t n) {
+    __m256d amounts = _mm256_setzero_pd();
+    __m256d notionals = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d price, amount;
+        loadFour(end - i, price, amount);
+        amounts = _mm256_add_pd(amounts, amount);
+        notionals = _mm256_fmadd_pd(price, amount, notionals);
+    }
+    SideSums sums = sumsScalar(end - i, n - i);
+    sums.amount += horizontalSum(amounts);
+    sums.notional += horizontalSum(notionals);
+    return sums;
+}
+
+AVX2_KERNEL static void cumulativeAvx2(const BookLevel* end, size_t n, double scale, double* out) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d factor = _mm256_set1_pd(scale);
+    __m256d carry = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d price, amount;
+        loadFour(end - i, price, amount);
+        amount = _mm256_permute4x64_pd(amount, _MM_SHUFFLE(0, 2, 1, 3));   // Best first
+        // In-register prefix sum: add the vector shifted by one lane, then by two
+        amount = _mm256_add_pd(amount, _mm256_blend_pd(_mm256_permute4x64_pd(amount, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1));
+        amount = _mm256_add_pd(amount, _mm256_blend_pd(_mm256_permute4x64_pd(amount, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x3));
+        amount = _mm256_add_pd(amount, carry);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(amount, factor));
+        carry = _mm256_permute4x64_pd(amount, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    double total = _mm256_cvtsd_f64(carry);
+    for (; i < n; ++i) {
+        total += static_cast<double>(end[-1 - static_cast<ptrdiff_t>(i)].amount.raw);
+        out[i] = total * scale;
+    }
+}
+
+AVX2_KERNEL static size_t levelsBelowAvx2(const BookLevel* end, size_t n, double size, SideSums& taken) {
+    __m256d notionals = _mm256_setzero_pd();
+    size_t i = 0;
+    // Whole blocks of four while they all fit below size; the block that crosses it is finished level by level
+    for (; i + 4 <= n; i += 4) {
+        __m256d price, amount;
+        loadFour(end - i, price, amount);
+        double block = horizontalSum(amount);
+        if (taken.amount + block >= size) break;
+        taken.amount += block;
+        notionals = _mm256_fmadd_pd(price, amount, notionals);
+    }
+    taken.notional += horizontalSum(notionals);
+    return i + levelsBelowScalar(end - i, n - i, size, taken);
+}
+
+static const Kernels avx2Kernels = {"avx2", sumsAvx2, cumulativeAvx2, levelsBelowAvx2};
+#endif
+
+static const Kernels* pickKernels() {
+#ifdef BOOK_ANALYTICS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return &avx2Kernels;
+#endif
+    return &scalarKernels;
+}
+
+static std::atomic<const Kernels*> activeKernels{pickKernels()};
+
+static const Kernels& selected() {
+    return *activeKernels.load(std::memory_order_relaxed);
+}
+
+const char* BookAnalytics::kernels() {
+    return selected().name;
+}
+
+void BookAnalytics::forceScalar(bool scalar) {
+    activeKernels.store(scalar ? &scalarKernels : pickKernels(), std::memory_order_relaxed);
+}
+
+static const BookLevel* sideEnd(const std::vector<BookLevel>& levels) {
+    return levels.data() + levels.size();
+}
+
+void BookAnalytics::cumulativeDepth(const OrderBook& book, BookSide side, size_t levels, std::vector<double>& out) {
+    const std::vector<BookLevel>& sideLevels = book.sideLevels(side);
+    out.resize(std::min(levels, sideLevels.size()));
+    selected().cumulative(sideEnd(sideLevels), out.size(), 1.0 / FixedScale, out.data());
+}
+
+bool BookAnalytics::priceToFill(const OrderBook& book, BookSide side, double size, double& averagePrice,
+                                double& worstPrice) {
+    const std::vector<BookLevel>& levels = book.sideLevels(side);
+    if (size <= 0.0 || levels.empty()) return false;
+    double rawSize = size * FixedScale;
+    SideSums taken;
+    size_t whole = selected().levelsBelow(sideEnd(levels), levels.size(), rawSize, taken);
+    if (whole == levels.size()) return false;
+    // The rest comes out of the next level
+    const BookLevel& last = sideEnd(levels)[-1 - static_cast<ptrdiff_t>(whole)];
+    double notional = taken.notional + static_cast<double>(last.price.raw) * (rawSize - taken.amount);
+    averagePrice = notional / rawSize / FixedScale;
+    worstPrice = last.price.toDouble();
+    return true;
+}
+
+static double imbalanceOf(const SideSums& bids, const SideSums& asks) {
+    double total = bids.amount + asks.amount;
+    return total > 0.0 ? (bids.amount - asks.amount) / total : 0.0;
+}
+
+double BookAnalytics::imbalance(const OrderBook& book, size_t levels) {
+    const std::vector<BookLevel>& bids = book.sideLevels(BookSide::Bid);
+    const std::vector<BookLevel>& asks = book.sideLevels(BookSide::Ask);
+    return imbalanceOf(selected().sums(sideEnd(bids), std::min(levels, bids.size())),
+                       selected().sums(sideEnd(asks), std::min(levels, asks.size())));
+}
+
+BookSignals BookAnalytics::compute(const OrderBook& book, size_t levels, double fillSize) {
+    BookSignals out;
+    const std::vector<BookLevel>& bids = book.sideLevels(BookSide::Bid);
+    const std::vector<BookLevel>& asks = book.sideLevels(BookSide::Ask);
+    if (bids.empty() || asks.empty() || levels == 0) return out;
+
+    const Kernels& k = selected();
+    out.bidLevels = std::min(levels, bids.size());
+    out.askLevels = std::min(levels, asks.size());
+    SideSums bidSums = k.sums(sideEnd(bids), out.bidLevels);
+    SideSums askSums = k.sums(sideEnd(asks), out.askLevels);
+    out.bidDepth = bidSums.amount / FixedScale;
+    out.askDepth = askSums.amount / FixedScale;
+    out.imbalance = imbalanceOf(bidSums, askSums);
+
+    double bestBid = bids.back().price.toDouble(), bestAsk = asks.back().price.toDouble();
+    double bidTop = bids.back().amount.toDouble(), askTop = asks.back().amount.toDouble();
+    out.microprice = bidTop + askTop > 0.0 ? (bestBid * askTop + bestAsk * bidTop) / (bidTop + askTop)
+                                           : (bestBid + bestAsk) / 2;
+
+    double bidVwap = bidSums.amount > 0.0 ? bidSums.notional / bidSums.amount / FixedScale : bestBid;
+    double askVwap = askSums.amount > 0.0 ? askSums.notional / askSums.amount / FixedScale : bestAsk;
+    double depth = bidSums.amount + askSums.amount;
+    out.weightedMid = depth > 0.0 ? (bidVwap * askSums.amount + askVwap * bidSums.amount) / depth : (bidVwap + askVwap) / 2;
+    out.weightedSpread = askVwap - bidVwap;
+
+    if (fillSize > 0.0) {
+        double worst;
+        if (!priceToFill(book, BookSide::Ask, fillSize, out.buyPrice, worst)) out.buyPrice = 0.0;
+        if (!priceToFill(book, BookSide::Bid, fillSize, out.sellPrice, worst)) out.sellPrice = 0.0;
+    }
+    out.valid = true;
+    return out;
+}
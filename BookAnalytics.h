@@ -0,0 +1,49 @@
+#pragma once
+#include<cstddef>
+#include<vector>
+#include "OrderBook.h"
+
+// Signals of one book over its top levels. Prices in price units, amounts in amount units.
+struct BookSignals {
+    size_t bidLevels = 0;           // Levels used on each side (fewer than asked for on a thin book)
+    size_t askLevels = 0;
+    double bidDepth = 0.0;          // Total amount over those levels
+    double askDepth = 0.0;
+    double imbalance = 0.0;         // (bidDepth - askDepth) / (bidDepth + askDepth), in [-1, 1]
+    double microprice = 0.0;        // Best bid and ask weighted by the opposite side's top amount
+    double weightedMid = 0.0;       // Each side's VWAP over its levels, weighted by the opposite side's depth
+    double weightedSpread = 0.0;    // Ask VWAP minus bid VWAP over the levels
+    double buyPrice = 0.0;          // Average price to buy fillSize from the asks; 0 if they hold less
+    double sellPrice = 0.0;         // Average price to sell fillSize into the bids; 0 if they hold less
+    bool valid = false;             // Both sides have levels
+};
+
+// Book signals computed straight from OrderBook's level arrays.
+//
+// The per-level work (fixed-point to double, sums, prefix sums) runs in
+// kernels picked once at startup: AVX2, four levels per instruction, when the
+// CPU has it, otherwise plain scalar loops. Both give the same results up to
+// floating-point rounding. OrderBook keeps the best level at the back of each
+// side, so kernels walk the arrays from the end and never copy or reorder them.
+//
+// All functions are pure reads of the book; callers provide the locking.
+class BookAnalytics {
+public:
+    // Kernel set in use: "avx2" or "scalar"
+    static const char* kernels();
+    // Use the scalar kernels even where AVX2 is available (comparisons, benchmarks)
+    static void forceScalar(bool scalar);
+
+    // out[i] = total amount of the best i + 1 levels of side, for up to levels levels
+    static void cumulativeDepth(const OrderBook& book, BookSide side, size_t levels, std::vector<double>& out);
+
+    // Average and worst price of taking size from side (asks to buy, bids to sell).
+    // False if the side holds less than size.
+    static bool priceToFill(const OrderBook& book, BookSide side, double size, double& averagePrice, double& worstPrice);
+
+    // (bid - ask) / (bid + ask) of the amounts over the top levels of each side; 0 on an empty book
+    static double imbalance(const OrderBook& book, size_t levels);
+
+    // Every signal at once, sharing the side sums. fillSize 0 skips the fill prices.
+    static BookSignals compute(const OrderBook& book, size_t levels, double fillSize);
+};
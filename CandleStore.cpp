@@ -0,0 +1,235 @@
+#include "CandleStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int64_t timeframeMs(Timeframe timeframe) {
+    switch (timeframe) {
+    case Timeframe::Second: return 1000;
+    case Timeframe::Minute: return 60 * 1000;
+    case Timeframe::FiveMinutes: return 5 * 60 * 1000;
+    case Timeframe::Hour: return 60 * 60 * 1000;
+    default: return 1000;
+    }
+}
+
+const char* timeframeName(Timeframe timeframe) {
+    switch (timeframe) {
+    case Timeframe::Second: return "1s";
+    case Timeframe::Minute: return "1m";
+    case Timeframe::FiveMinutes: return "5m";
+    case Timeframe::Hour: return "1h";
+    default: return "?";
+    }
+}
+
+// File layout: this header, then capacity open times, then capacity of each double
+// field (open, high, low, close, volume, vwap), then capacity trade counts
+struct CandleFileHeader {
+    char magic[8];
+    uint32_t capacity;
+    uint32_t reserved;
+    int64_t timeframeMs;
+    uint64_t count;             // Finished candles held
+    char instrument[64];        // Zero-padded
+};
+
+static const char CandleMagic[8] = {'D', 'R', 'B', 'C', 'N', 'D', 'L', '1'};
+constexpr int FieldCount = 6;
+
+static size_t seriesBytes(size_t capacity) {
+    return sizeof(CandleFileHeader) +
+           capacity * (sizeof(int64_t) + FieldCount * sizeof(double) + sizeof(uint32_t));
+}
+
+CandleSeries::CandleSeries(Timeframe timeframe, size_t capacity)
+    : timeframe(timeframe), capacity(std::max<size_t>(capacity, 2)) {}
+
+CandleSeries::~CandleSeries() {
+    unmap();
+}
+
+void CandleSeries::unmap() {
+    if (mapping) ::munmap(mapping, mappedBytes);
+    mapping = nullptr;
+    header = nullptr;
+}
+
+size_t CandleSeries::open(const std::string& path, std::string_view instrument) {
+    std::lock_guard<std::mutex> guard(lock);
+    unmap();
+    size_t bytes = seriesBytes(capacity);
+    if (!path.empty()) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        struct stat info;
+        if (fd >= 0 && ::fstat(fd, &info) == 0 &&
+            (static_cast<size_t>(info.st_size) == bytes || ::ftruncate(fd, bytes) == 0)) {
+            void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) mapping = mapped;
+        }
+        if (fd >= 0) ::close(fd);
+        if (!mapping) LOG_WARN("Could not map {}: {}; keeping its candles in memory", path, std::strerror(errno));
+    }
+    if (!mapping) {
+        void* mapped = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) return 0;
+        mapping = mapped;
+    }
+    mappedBytes = bytes;
+    layout(std::string(instrument));
+    return header->count;
+}
+
+void CandleSeries::layout(const std::string& instrument) {
+    char* base = static_cast<char*>(mapping);
+    header = reinterpret_cast<CandleFileHeader*>(base);
+    base += sizeof(CandleFileHeader);
+    openTimes = reinterpret_cast<int64_t*>(base);
+    base += capacity * sizeof(int64_t);
+    for (double*& field : fields) {
+        field = reinterpret_cast<double*>(base);
+        base += capacity * sizeof(double);
+    }
+    tradeCounts = reinterpret_cast<uint32_t*>(base);
+
+    // Anything but this instrument's candles in this timeframe at this capacity starts over
+    bool valid = std::memcmp(header->magic, CandleMagic, sizeof(header->magic)) == 0 &&
+                 header->capacity == capacity && header->timeframeMs == timeframeMs(timeframe) &&
+                 header->count <= capacity && instrument.size() < sizeof(header->instrument) &&
+                 std::strncmp(header->instrument, instrument.c_str(), sizeof(header->instrument)) == 0;
+    if (!valid) {
+        std::memset(header, 0, sizeof(CandleFileHeader));
+        std::memcpy(header->magic, CandleMagic, sizeof(header->magic));
+        header->capacity = static_cast<uint32_t>(capacity);
+        header->timeframeMs = timeframeMs(timeframe);
+        std::memcpy(header->instrument, instrument.data(), std::min(instrument.size(), sizeof(header->instrument) - 1));
+    }
+    building = Candle();
+    notional = 0.0;
+}
+
+void CandleSeries::add(int64_t timestampMs, double price, double amount) {
+    int64_t interval = timeframeMs(timeframe);
+    int64_t start = timestampMs - timestampMs % interval;
+    std::lock_guard<std::mutex> guard(lock);
+    if (!header) return;
+    if (building.trades > 0 && start > building.openTimeMs) {
+        finish();
+    }
+    if (building.trades == 0) {
+        building = Candle{start, price, price, price, price, 0.0, price, 0};
+        notional = 0.0;
+        closeTimeMs = timestampMs;
+    }
+    // A late trade (start before the candle's) is folded into the current candle, without
+    // becoming its close
+    building.high = std::max(building.high, price);
+    building.low = std::min(building.low, price);
+    if (timestampMs >= closeTimeMs) {
+        building.close = price;
+        closeTimeMs = timestampMs;
+    }
+    building.volume += amount;
+    notional += price * amount;
+    building.vwap = building.volume > 0.0 ? notional / building.volume : price;
+    ++building.trades;
+}
+
+void CandleSeries::finish() {
+    size_t count = header->count;
+    if (count == capacity) {
+        // Full: drop the older half, moving the rest down so columns stay contiguous
+        size_t keep = capacity / 2;
+        size_t drop = count - keep;
+        std::memmove(openTimes, openTimes + drop, keep * sizeof(int64_t));
+        for (double* field : fields) std::memmove(field, field + drop, keep * sizeof(double));
+        std::memmove(tradeCounts, tradeCounts + drop, keep * sizeof(uint32_t));
+        count = keep;
+    }
+    openTimes[count] = building.openTimeMs;
+    const double values[FieldCount] = {building.open, building.high, building.low, building.close, building.volume,
+                                       building.vwap};
+    for (int i = 0; i < FieldCount; ++i) fields[i][count] = values[i];
+    tradeCounts[count] = building.trades;
+    header->count = count + 1;       // Last, so a reader of the file never sees a half-written candle counted
+    building.trades = 0;
+}
+
+CandleColumns CandleSeries::columns() const {
+    CandleColumns out;
+    if (!header) return out;
+    out.count = header->count;
+    out.openTimeMs = openTimes;
+    out.open = fields[0];
+    out.high = fields[1];
+    out.low = fields[2];
+    out.close = fields[3];
+    out.volume = fields[4];
+    out.vwap = fields[5];
+    out.trades = tradeCounts;
+    return out;
+}
+
+bool CandleSeries::current(Candle& out) const {
+    if (building.trades == 0) return false;
+    out = building;
+    return true;
+}
+
+void CandleStore::setDirectory(const std::string& path) {
+    if (!path.empty() && ::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_WARN("Could not create candle directory {}: {}", path, std::strerror(errno));
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    directory = path;
+}
+
+CandleStore::InstrumentCandles& CandleStore::create(InstrumentId instrument, std::string_view name) {
+    auto candles = std::make_unique<InstrumentCandles>();
+    // Names become file names; keep path separators out
+    std::string fileName(name);
+    std::replace(fileName.begin(), fileName.end(), '/', '_');
+    size_t loaded = 0;
+    for (int i = 0; i < static_cast<int>(Timeframe::Count); ++i) {
+        Timeframe timeframe = static_cast<Timeframe>(i);
+        candles->series[i] = std::make_unique<CandleSeries>(timeframe, capacity);
+        std::string path = directory.empty() ? "" : directory + "/" + fileName + "." + timeframeName(timeframe) + ".candles";
+        loaded += candles->series[i]->open(path, name);
+    }
+    if (loaded > 0) LOG_INFO("Loaded {} candles of {} from the last session", loaded, name);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    if (instrument >= instruments.size()) instruments.resize(instrument + 1);
+    instruments[instrument] = std::move(candles);
+    return *instruments[instrument];
+}
+
+static int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void CandleStore::addTrade(InstrumentId instrument, std::string_view name, int64_t timestampMs, int64_t tradeSeq,
+                           Price price, Qty amount) {
+    if (instrument == NoInstrument) return;
+    // Only this thread adds instruments, so it can look them up without the lock
+    InstrumentCandles* candles = instrument < instruments.size() ? instruments[instrument].get() : nullptr;
+    if (!candles) candles = &create(instrument, name);
+    if (tradeSeq >= 0 && !candles->recent.add(tradeSeq)) return;
+    if (timestampMs <= 0) timestampMs = wallClockMs();
+    for (const auto& series : candles->series) {
+        series->add(timestampMs, price.toDouble(), amount.toDouble());
+    }
+}
+
+const CandleSeries* CandleStore::find(InstrumentId instrument, Timeframe timeframe) const {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (instrument >= instruments.size() || !instruments[instrument]) return nullptr;
+    return instruments[instrument]->series[static_cast<int>(timeframe)].get();
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "FixedPoint.h"
+#include "InstrumentRegistry.h"
+#include "RecentTradeSeqs.h"
+
+enum class Timeframe : uint8_t {
+    Second,
+    Minute,
+    FiveMinutes,
+    Hour,
+    Count
+};
+
+int64_t timeframeMs(Timeframe timeframe);
+const char* timeframeName(Timeframe timeframe);     // "1s", "1m", "5m", "1h"
+
+// A candle being built, or one finished candle
+struct Candle {
+    int64_t openTimeMs = 0;     // Start of its interval, exchange time
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double volume = 0.0;        // Sum of trade amounts
+    double vwap = 0.0;          // Sum of price * amount over volume
+    uint32_t trades = 0;
+};
+
+// Finished candles of one instrument and timeframe, one array per field,
+// oldest first. Points straight into the store; valid only inside read().
+struct CandleColumns {
+    size_t count = 0;
+    const int64_t* openTimeMs = nullptr;
+    const double* open = nullptr;
+    const double* high = nullptr;
+    const double* low = nullptr;
+    const double* close = nullptr;
+    const double* volume = nullptr;
+    const double* vwap = nullptr;
+    const uint32_t* trades = nullptr;
+};
+
+struct CandleFileHeader;
+
+// The candles of one instrument in one timeframe.
+//
+// Finished candles live in a mapped file laid out as a header and one column
+// per field, so charts and signals read a field as a plain array and the next
+// session starts with this one's history. When the columns fill up the older
+// half is dropped by moving the newer half down, which keeps every column
+// contiguous and ordered. Without a file the same layout is mapped anonymously.
+class CandleSeries {
+public:
+    CandleSeries(Timeframe timeframe, size_t capacity);
+    ~CandleSeries();
+    CandleSeries(const CandleSeries&) = delete;
+    CandleSeries& operator=(const CandleSeries&) = delete;
+
+    // Map path (created, or reset if it holds something else), or memory when path is
+    // empty or can't be used. Returns the finished candles it already held.
+    size_t open(const std::string& path, std::string_view instrument);
+
+    // A trade at timestampMs; finishes the current candle when it falls past its interval
+    void add(int64_t timestampMs, double price, double amount);
+
+    // Caller holds mutex()
+    CandleColumns columns() const;
+    bool current(Candle& out) const;
+    std::mutex& mutex() const { return lock; }
+
+private:
+    Timeframe timeframe;
+    size_t capacity;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    CandleFileHeader* header = nullptr;
+    int64_t* openTimes = nullptr;
+    double* fields[6] = {};         // open, high, low, close, volume, vwap
+    uint32_t* tradeCounts = nullptr;
+
+    Candle building;                // trades == 0: nothing since the last finished candle
+    double notional = 0.0;          // Sum of price * amount of building
+    int64_t closeTimeMs = 0;        // Of the trade building.close is from
+    mutable std::mutex lock;
+
+    void unmap();
+    void layout(const std::string& instrument);
+    void finish();
+};
+
+// Candles in every Timeframe for each instrument that trades, built
+// incrementally from trades.* and our own fills.
+//
+// The same trade can come from both (and a fill from both its order's
+// response and user.trades), so trades are applied once per trade_seq, which
+// the exchange numbers per instrument, checked against the last RecentTrades
+// seqs rather than the highest: an ack may deliver a fill ahead of the
+// trades.* batch holding the trades just before it. Only the dispatcher thread adds trades;
+// any thread may read().
+class CandleStore {
+public:
+    static constexpr size_t DefaultCapacity = 8192;     // Finished candles kept per instrument and timeframe
+
+    explicit CandleStore(size_t capacityPerSeries = DefaultCapacity) : capacity(capacityPerSeries) {}
+
+    // Keep finished candles in files under directory, from the next instrument on.
+    // Set before trades arrive.
+    void setDirectory(const std::string& path);
+
+    // Writer thread only. tradeSeq < 0 when unknown (never deduplicated).
+    void addTrade(InstrumentId instrument, std::string_view name, int64_t timestampMs, int64_t tradeSeq, Price price,
+                  Qty amount);
+
+    // Call fn(columns, current) with the finished candles and the one in progress (null if
+    // none) under the series' lock. False if the instrument has no candles.
+    template <typename Fn>
+    bool read(InstrumentId instrument, Timeframe timeframe, Fn&& fn) const {
+        const CandleSeries* series = find(instrument, timeframe);
+        if (!series) return false;
+        std::lock_guard<std::mutex> guard(series->mutex());
+        Candle building;
+        bool hasCurrent = series->current(building);
+        fn(series->columns(), hasCurrent ? &building : nullptr);
+        return true;
+    }
+
+private:
+    static constexpr size_t RecentTrades = 256;   // A trades.* batch's worth, and more
+
+    struct InstrumentCandles {
+        std::unique_ptr<CandleSeries> series[static_cast<int>(Timeframe::Count)];
+        RecentTradeSeqs<RecentTrades> recent;
+    };
+
+    size_t capacity;
+    std::string directory;
+    mutable std::mutex mutex;       // Guards adding instruments, and other threads' lookups
+    std::vector<std::unique_ptr<InstrumentCandles>> instruments;   // Indexed by InstrumentId
+
+    const CandleSeries* find(InstrumentId instrument, Timeframe timeframe) const;
+    InstrumentCandles& create(InstrumentId instrument, std::string_view name);
+};
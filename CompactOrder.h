@@ -0,0 +1,87 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<functional>
+#include<string_view>
+#include<type_traits>
+#include "types.hpp"
+#include "FixedPoint.h"
+#include "InstrumentRegistry.h"
+
+// Exchange-assigned id stored inline (Deribit order and trade ids are short,
+// e.g. "ETH-584849853"), so records carrying one never touch the heap.
+struct ShortId {
+    static constexpr size_t Capacity = 23;
+
+    char text[Capacity] = {};
+    uint8_t length = 0;
+
+    ShortId() = default;
+    explicit ShortId(std::string_view s) { assign(s); }
+
+    // Ids longer than Capacity are truncated
+    void assign(std::string_view s) {
+        length = static_cast<uint8_t>(s.size() < Capacity ? s.size() : Capacity);
+        std::memcpy(text, s.data(), length);
+    }
+
+    std::string_view view() const { return std::string_view(text, length); }
+    bool empty() const { return length == 0; }
+
+    bool operator==(const ShortId& other) const {
+        return length == other.length && std::memcmp(text, other.text, length) == 0;
+    }
+    bool operator!=(const ShortId& other) const { return !(*this == other); }
+};
+
+struct ShortIdHash {
+    size_t operator()(const ShortId& id) const { return std::hash<std::string_view>{}(id.view()); }
+};
+
+using OrderId = ShortId;
+using TradeId = ShortId;
+
+constexpr uint32_t NoFill = UINT32_MAX;
+
+// One fill. Fills of an order form a backwards chain through prevFill.
+struct CompactFill {
+    TradeId tradeId;
+    int64_t price = 0;                 // Fixed-point, see FixedPoint.h
+    int64_t amount = 0;
+    int64_t fee = 0;
+    int64_t timestamp = 0;             // Exchange time, ms
+    int64_t tradeSeq = -1;
+    uint32_t prevFill = NoFill;        // Earlier fill of the same order
+    uint32_t feeCurrency = StringInterner::None;
+    OrderSide side = OrderSide::Buy;
+};
+
+// Hot-path order record: fixed size, no owning pointers, cheap to copy.
+// Strings are interned ids; prices and amounts are fixed-point.
+struct CompactOrder {
+    enum Flags : uint8_t {
+        HasPrice = 1,
+        HasTriggerPrice = 2
+    };
+
+    OrderId id;
+    int64_t price = 0;                 // Limit price
+    int64_t averagePrice = 0;          // Of what has filled so far; 0 before the first fill
+    int64_t triggerPrice = 0;
+    int64_t amount = 0;
+    int64_t filledAmount = 0;
+    InstrumentId instrument = NoInstrument;
+    uint32_t label = StringInterner::None;
+    uint32_t lastFill = NoFill;        // Newest fill, see OrderStore
+    OrderSide side = OrderSide::Buy;
+    OrderType type = OrderType::limit;
+    InstrumentType instrumentType = InstrumentType::Futures;
+    TriggerType trigger = TriggerType::None;
+    uint8_t flags = 0;
+
+    bool hasPrice() const { return flags & HasPrice; }
+    bool hasTriggerPrice() const { return flags & HasTriggerPrice; }
+};
+
+static_assert(std::is_trivially_copyable<CompactOrder>::value, "CompactOrder is copied as raw bytes");
+static_assert(sizeof(CompactOrder) <= 88, "Keep CompactOrder within 88 bytes");
@@ -0,0 +1,34 @@
+#pragma once
+#include<atomic>
+#include<cstdint>
+
+// Change notices from the threads that own the data to the one that draws it.
+//
+// Writers only set bits, so a burst of updates between two frames costs one
+// atomic OR per update (none once the bit is already set) and collapses into
+// a single redraw. The UI takes and clears every bit at once when it is about
+// to draw.
+class DirtyFlags {
+public:
+    enum Panel : uint32_t {
+        Book = 1,
+        Orders = 2,
+        Positions = 4,
+        Trades = 8,
+        Prices = 16,
+        All = 31
+    };
+
+    void mark(uint32_t panels) {
+        // Read first: the common case is already set, and a plain load keeps the line shared
+        if ((bits.load(std::memory_order_relaxed) & panels) != panels) {
+            bits.fetch_or(panels, std::memory_order_release);
+        }
+    }
+
+    // Panels changed since the last take
+    uint32_t take() { return bits.exchange(0, std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> bits{0};
+};
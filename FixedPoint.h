@@ -0,0 +1,102 @@
+#pragma once
+#include<charconv>
+#include<cmath>
+#include<cstdint>
+#include<functional>
+#include<string>
+
+// Prices, amounts and fees are held as integers in units of 1e-8 so that
+// compact records stay trivially copyable and sums don't drift. The scale is
+// fine enough for every Deribit tick size and contract size.
+constexpr int64_t FixedScale = 100000000;
+constexpr int FixedDigits = 8;          // Decimal places of FixedScale
+
+inline int64_t toFixed(double value) {
+    return static_cast<int64_t>(std::llround(value * static_cast<double>(FixedScale)));
+}
+
+inline double fromFixed(int64_t value) {
+    return static_cast<double>(value) / static_cast<double>(FixedScale);
+}
+
+// Shortest exact decimal text of a fixed-point value ("64000.5", "-0.0001", "40").
+// out needs room for 22 characters; returns the end of what was written.
+inline char* formatFixed(char* out, int64_t value) {
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    if (value < 0) *out++ = '-';
+    out = std::to_chars(out, out + 20, magnitude / FixedScale).ptr;
+    uint64_t fraction = magnitude % FixedScale;
+    if (fraction == 0) return out;
+    *out++ = '.';
+    for (uint64_t unit = FixedScale / 10; fraction != 0; unit /= 10) {
+        *out++ = static_cast<char>('0' + fraction / unit);
+        fraction %= unit;
+    }
+    return out;
+}
+
+enum class Rounding {
+    Down,       // Toward negative infinity
+    Up,         // Toward positive infinity
+    Nearest     // Half away from zero
+};
+
+// value rounded to a multiple of step (step > 0)
+inline int64_t roundToStep(int64_t value, int64_t step, Rounding mode) {
+    int64_t remainder = value % step;
+    if (remainder == 0) return value;
+    int64_t below = remainder > 0 ? value - remainder : value - remainder - step;
+    switch (mode) {
+        case Rounding::Down: return below;
+        case Rounding::Up: return below + step;
+        default: {
+            int64_t offset = value - below;
+            bool up = value < 0 ? offset * 2 > step : offset * 2 >= step;
+            return up ? below + step : below;
+        }
+    }
+}
+
+// Fixed-point quantity of one kind. The tag keeps prices and amounts from
+// being mixed up; comparisons, hashing and sums are plain integer operations.
+template <typename Tag>
+struct Fixed {
+    int64_t raw = 0;            // Units of 1 / FixedScale
+
+    static constexpr Fixed fromRaw(int64_t value) { return Fixed{value}; }
+    static Fixed fromDouble(double value) { return Fixed{toFixed(value)}; }
+    double toDouble() const { return fromFixed(raw); }
+
+    std::string toString() const {
+        char text[24];
+        return std::string(text, formatFixed(text, raw));
+    }
+
+    Fixed rounded(Fixed step, Rounding mode) const { return Fixed{roundToStep(raw, step.raw, mode)}; }
+
+    bool isZero() const { return raw == 0; }
+
+    constexpr bool operator==(Fixed other) const { return raw == other.raw; }
+    constexpr bool operator!=(Fixed other) const { return raw != other.raw; }
+    constexpr bool operator<(Fixed other) const { return raw < other.raw; }
+    constexpr bool operator<=(Fixed other) const { return raw <= other.raw; }
+    constexpr bool operator>(Fixed other) const { return raw > other.raw; }
+    constexpr bool operator>=(Fixed other) const { return raw >= other.raw; }
+
+    constexpr Fixed operator+(Fixed other) const { return Fixed{raw + other.raw}; }
+    constexpr Fixed operator-(Fixed other) const { return Fixed{raw - other.raw}; }
+    constexpr Fixed operator-() const { return Fixed{-raw}; }
+    Fixed& operator+=(Fixed other) { raw += other.raw; return *this; }
+    Fixed& operator-=(Fixed other) { raw -= other.raw; return *this; }
+};
+
+struct PriceTag {};
+struct QtyTag {};
+
+using Price = Fixed<PriceTag>;      // Quote currency per contract unit
+using Qty = Fixed<QtyTag>;          // Order/position amount, in the instrument's amount units
+
+struct FixedHash {
+    template <typename Tag>
+    size_t operator()(Fixed<Tag> value) const { return std::hash<int64_t>{}(value.raw); }
+};
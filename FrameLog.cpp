@@ -0,0 +1,169 @@
+#include "FrameLog.h"
+#include "MessagePipeline.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char Magic[8] = {'F', 'R', 'A', 'M', 'E', 'L', 'O', 'G'};
+constexpr uint32_t Version = 1;
+constexpr size_t WriteBuffer = 1 << 20;
+constexpr char Padding[8] = {};
+
+size_t padded(size_t length) {
+    return (length + 7) & ~static_cast<size_t>(7);
+}
+}
+
+FrameLogWriter::~FrameLogWriter() {
+    close();
+}
+
+bool FrameLogWriter::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lock(mutex);
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Could not open capture file " << path << std::endl;
+        return false;
+    }
+    buffer.resize(WriteBuffer);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    FrameLogHeader header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.headerSize = sizeof(FrameLogHeader);
+    header.startRealtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.startSteadyNs = MessagePipeline::nowNs();
+    std::fwrite(&header, sizeof(header), 1, file);
+    frames = 0;
+    return true;
+}
+
+void FrameLogWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+void FrameLogWriter::append(FrameDirection direction, int64_t timestampNs, std::string_view payload) {
+    FrameRecordHeader record{};
+    record.timestampNs = timestampNs;
+    record.length = static_cast<uint32_t>(payload.size());
+    record.direction = static_cast<uint8_t>(direction);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) return;
+    std::fwrite(&record, sizeof(record), 1, file);
+    std::fwrite(payload.data(), 1, payload.size(), file);
+    std::fwrite(Padding, 1, padded(payload.size()) - payload.size(), file);
+    ++frames;
+}
+
+void FrameLogWriter::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) std::fflush(file);
+}
+
+FrameLogReader::~FrameLogReader() {
+    close();
+}
+
+bool FrameLogReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open capture file " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FrameLogHeader)) {
+        std::cerr << "Capture file " << path << " is empty or unreadable" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Could not map capture file " << path << std::endl;
+        return false;
+    }
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+    size = info.st_size;
+
+    if (std::memcmp(header().magic, Magic, sizeof(Magic)) != 0 || header().version != Version) {
+        std::cerr << "Capture file " << path << " has an unknown format" << std::endl;
+        close();
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void FrameLogReader::close() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+}
+
+void FrameLogReader::rewind() {
+    offset = data ? header().headerSize : 0;
+}
+
+bool FrameLogReader::next(FrameView& frame) {
+    if (!data || offset + sizeof(FrameRecordHeader) > size) return false;
+    FrameRecordHeader record;
+    std::memcpy(&record, data + offset, sizeof(record));
+    size_t payloadStart = offset + sizeof(record);
+    if (payloadStart + record.length > size) return false;
+
+    frame.timestampNs = record.timestampNs;
+    frame.direction = static_cast<FrameDirection>(record.direction);
+    frame.payload = std::string_view(data + payloadStart, record.length);
+    offset = payloadStart + padded(record.length);
+    return true;
+}
+
+bool replayFrameLog(const std::string& path, MessagePipeline& pipeline, double speed, ReplayStats& stats) {
+    FrameLogReader reader;
+    if (!reader.open(path)) return false;
+
+    FrameView frame;
+    int64_t firstNs = -1;
+    int64_t startNs = MessagePipeline::nowNs();
+    while (reader.next(frame)) {
+        if (frame.direction != FrameDirection::Inbound) continue;
+
+        if (speed > 0) {
+            if (firstNs < 0) firstNs = frame.timestampNs;
+            int64_t due = startNs + static_cast<int64_t>((frame.timestampNs - firstNs) / speed);
+            int64_t wait = due - MessagePipeline::nowNs();
+            // Sleep through long gaps, spin the last stretch to keep bursts tight
+            if (wait > 2000000) std::this_thread::sleep_for(std::chrono::nanoseconds(wait - 1000000));
+            while (MessagePipeline::nowNs() < due) {
+            }
+        }
+
+        InboundFrame inbound;
+        inbound.rxNs = MessagePipeline::nowNs();
+        inbound.payload.assign(frame.payload);
+        pipeline.push(std::move(inbound));
+        ++stats.frames;
+        stats.bytes += frame.payload.size();
+    }
+    pipeline.flush();
+    stats.elapsedNs = MessagePipeline::nowNs() - startNs;
+    return true;
+}
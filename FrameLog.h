@@ -0,0 +1,102 @@
+#pragma once
+#include<cstdint>
+#include<cstdio>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<vector>
+
+class MessagePipeline;
+
+enum class FrameDirection : uint8_t {
+    Inbound = 0,
+    Outbound = 1
+};
+
+// On-disk layout: one FrameLogHeader, then records of
+// FrameRecordHeader + payload, each padded to 8 bytes so a mapped file
+// can be walked in place.
+struct FrameLogHeader {
+    char magic[8];                 // "FRAMELOG"
+    uint32_t version;
+    uint32_t headerSize;
+    int64_t startRealtimeNs;       // Wall clock when capture started
+    int64_t startSteadyNs;         // steady_clock at the same moment (record timestamps use it)
+};
+
+struct FrameRecordHeader {
+    int64_t timestampNs;           // steady_clock: receive time (inbound) or send time (outbound)
+    uint32_t length;               // Payload bytes
+    uint8_t direction;             // FrameDirection
+    uint8_t reserved[3];
+};
+
+// One record of a mapped log; payload points into the mapping
+struct FrameView {
+    int64_t timestampNs = 0;
+    FrameDirection direction = FrameDirection::Inbound;
+    std::string_view payload;
+};
+
+// Append-only capture of websocket traffic.
+//
+// Frames are copied into a large stdio buffer under a mutex (inbound frames
+// come from the dispatcher thread, outbound ones from whichever thread sends),
+// so capturing costs a memcpy per frame rather than a syscall.
+class FrameLogWriter {
+public:
+    FrameLogWriter() = default;
+    ~FrameLogWriter();
+    FrameLogWriter(const FrameLogWriter&) = delete;
+    FrameLogWriter& operator=(const FrameLogWriter&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void append(FrameDirection direction, int64_t timestampNs, std::string_view payload);
+    void flush();
+
+    uint64_t framesWritten() const { return frames; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<char> buffer;
+    std::mutex mutex;
+    uint64_t frames = 0;
+};
+
+// Read-only, memory-mapped view of a capture
+class FrameLogReader {
+public:
+    FrameLogReader() = default;
+    ~FrameLogReader();
+    FrameLogReader(const FrameLogReader&) = delete;
+    FrameLogReader& operator=(const FrameLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const FrameLogHeader& header() const { return *reinterpret_cast<const FrameLogHeader*>(data); }
+
+    // Next record; false at the end (or at a record cut short by a crash)
+    bool next(FrameView& frame);
+    void rewind();
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+};
+
+// Outcome of a replay run
+struct ReplayStats {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    int64_t elapsedNs = 0;
+};
+
+// Push every inbound frame of a capture into the pipeline, exactly as on_message
+// does, and wait until all of them are dispatched. speed 0 replays as fast as the
+// pipeline takes frames; otherwise the recorded gaps are kept, divided by speed.
+bool replayFrameLog(const std::string& path, MessagePipeline& pipeline, double speed, ReplayStats& stats);
@@ -2,23 +2,26 @@
 #include <algorithm>
 #include<numeric>
 
+using namespace ftxui;
+
 std::vector<int> GraphUtils::NormalizeData(const std::vector<double>& data, int height){
     std::vector<int> normalized;
     if(data.empty()) return normalized;
 
-    double minVal=FindMin(data);
-    double maxVal=FindMax(data);
-    double range=maxVal - minVal;
+    auto [minIt,maxIt]=std::minmax_element(data.begin(),data.end());
+    NormalizeInto(data,*minIt,*maxIt,height,normalized);
+    return normalized;
+}
 
+void GraphUtils::NormalizeInto(const std::vector<double>& data,double minVal,double maxVal,int height,std::vector<int>& out){
+    double range=maxVal - minVal;
     if(range==0) range=1; // Prevent division by zero
-    for(auto value:data){
-        double normalizedValue=(value - minVal) / range;
-        int scaled_Val=static_cast<int>(normalizedValue * (height - 1)+0.5);
-        normalized.push_back(scaled_Val);
-    }
-    return normalized;
+    double scale=(height - 1) / range;
 
-    
+    out.resize(data.size());
+    for(size_t i=0;i<data.size();++i){
+        out[i]=static_cast<int>((data[i] - minVal) * scale+0.5);
+    }
 }
 
 
@@ -32,28 +35,24 @@ double GraphUtils::FindMax(const std::vector<double>& data){
     return *std::max_element(data.begin(),data.end());
 }
 
-ftxui::Element GraphUtils::PlotLineGraph(const std::vector<double> &data,const std::string &title,int width, int height){
-    auto graph_func=[data,height](int graph_width)->std::vector<int>{
-        if(data.empty()) return {};
-
-        std::vector<double> sampled_data;
+std::vector<double> GraphUtils::SampleForWidth(const std::vector<double>& data,int width){
+    std::vector<double> sampled_data;
+    downsampleMinMax(data.data(),data.size(),nullptr,0,static_cast<size_t>(std::max(width,1)),sampled_data);
+    return sampled_data;
+}
 
-        if(data.size()<= static_cast<size_t>(graph_width)){
-            sampled_data=data;
+// Buffers reused by every render on this (the UI) thread
+struct GraphScratch{
+    std::vector<double> sampled;
+    std::vector<int> scaled;
+};
 
-        }
-        else{
-            double step=static_cast<double>(data.size())/graph_width;
-            for(int i=0;i<graph_width;++i){
-                size_t index=static_cast<size_t>(i*step);
-                sampled_data.push_back(data[index]);
-            }
-        }
-        return NormalizeData(sampled_data,height);
-    };
-
-    ftxui::Element graph=ftxui::graph(graph_func)|color(ftxui::Color::Cyan);
+static GraphScratch& graphScratch(){
+    thread_local GraphScratch scratch;
+    return scratch;
+}
 
+static ftxui::Element titled(ftxui::Element graph,const std::string& title){
     if(!title.empty()){
         return vbox(
             {
@@ -66,11 +65,45 @@ ftxui::Element GraphUtils::PlotLineGraph(const std::vector<double> &data,const s
     return graph;
 }
 
-Element GraphUtils::PlotBarGraph(const std::vector<std::pair<std::string, double>>& data,
+ftxui::Element GraphUtils::PlotLineGraph(const std::vector<double> &data,const std::string &title,int width, int height){
+    // Downsampling first keeps the normalising pass to one column's worth of points; the
+    // returned copy of the scaled columns is the one allocation GraphFunction's signature forces
+    const std::vector<double>* points=&data;
+    auto graph_func=[points,height](int graph_width,int /*graph_height*/)->std::vector<int>{
+        if(points->empty()) return {};
+
+        GraphScratch& scratch=graphScratch();
+        downsampleMinMax(points->data(),points->size(),nullptr,0,static_cast<size_t>(std::max(graph_width,1)),scratch.sampled);
+        auto [minIt,maxIt]=std::minmax_element(scratch.sampled.begin(),scratch.sampled.end());
+        NormalizeInto(scratch.sampled,*minIt,*maxIt,height,scratch.scaled);
+        return scratch.scaled;
+    };
+
+    return titled(ftxui::graph(graph_func)|color(ftxui::Color::Cyan),title);
+}
+
+ftxui::Element GraphUtils::PlotLineGraph(const PriceSeries& series,const std::string& title,int height){
+    const PriceSeries* source=&series;
+    auto graph_func=[source,height](int graph_width,int /*graph_height*/)->std::vector<int>{
+        GraphScratch& scratch=graphScratch();
+        source->downsample(static_cast<size_t>(std::max(graph_width,1)),scratch.sampled);
+        if(scratch.sampled.empty()) return {};
+
+        // From the sample itself: the series may take a price between downsample() and any
+        // later read, and the scale has to bound exactly the points being drawn
+        auto [minIt,maxIt]=std::minmax_element(scratch.sampled.begin(),scratch.sampled.end());
+        NormalizeInto(scratch.sampled,*minIt,*maxIt,height,scratch.scaled);
+        return scratch.scaled;
+    };
+
+    return titled(ftxui::graph(graph_func)|color(ftxui::Color::Cyan),title);
+}
+
+ftxui::Element GraphUtils::PlotBarGraph(const std::vector<std::pair<std::string, double>>& data,
                                 const std::string& title){
 
 
-    ftxui::Element bars;        
+    ftxui::Elements bars;
     
     if(!title.empty()){
         bars.push_back(text(title)|bold|center);
@@ -79,11 +112,11 @@ Element GraphUtils::PlotBarGraph(const std::vector<std::pair<std::string, double
 
     if(data.empty()){
         bars.push_back(text("No data available")|center);
-        return vbos(bars)|border;
+        return vbox(bars)|border;
     }
 
     double max_val=0;
-    for const auto& pair:data){
+    for(const auto& pair:data){
         if(pair.second>max_val) max_val=pair.second;
     }
 
@@ -94,9 +127,9 @@ Element GraphUtils::PlotBarGraph(const std::vector<std::pair<std::string, double
         bars.push_back(
             hbox(
                 {
-                    text(label+":")|flex(1),
-                    gauge(ratio)|color(Color::Green)|flex(3),
-                    text(" "+std::to_string(static_cast<int>(value)))|flex(1)
+                    text(label+":")|size(WIDTH,EQUAL,16),
+                    gauge(ratio)|color(Color::Green)|flex,
+                    text(" "+std::to_string(static_cast<int>(value)))|size(WIDTH,EQUAL,12)
                 }
             )
         );
@@ -108,15 +141,20 @@ Element GraphUtils::PlotBarGraph(const std::vector<std::pair<std::string, double
 }
 
 
+static ftxui::Element priceFooter(double curr,double min_price,double max_price){
+    return hbox({
+        text("Current: $"+std::to_string(static_cast<int>(curr)))|flex,
+        text("Min: $"+std::to_string(static_cast<int>(min_price)))|flex,
+        text("Max: $"+std::to_string(static_cast<int>(max_price)))| flex
+    });
+}
+
 ftxui::Element GraphUtils::PlotPriceMovement(const std::vector<double>& prices,const std::string& title){
     if(prices.empty()){
         return text("No price data available")|center|border;
     }
 
-    double curr=prices.back();
-    double min_price=FindMin(prices);
-    double max_price=FindMax(prices);
-
+    auto [minIt,maxIt]=std::minmax_element(prices.begin(),prices.end());
     auto graph=PlotLineGraph(prices,title);
 
     //now to add some more price info
@@ -124,10 +162,20 @@ ftxui::Element GraphUtils::PlotPriceMovement(const std::vector<double>& prices,c
     return vbox({
         graph,
         separator(),
-        hbox({
-            text("Current: $"+std::to_string(static_cast<int>(curr)))|flex(1),
-            text("Min: $"+std::to_string(static_cast<int>(min_price)))|flex(1),
-            text("Max: $"+std::to_string(static_cast<int>(max_price)))| flex(1)
-        })
+        priceFooter(prices.back(),*minIt,*maxIt)
+    })|border;
+}
+
+ftxui::Element GraphUtils::PlotPriceMovement(const PriceSeries& series,const std::string& title){
+    // Current, min and max are O(1) reads however long the history is
+    SeriesSummary summary=series.summary();
+    if(summary.count==0){
+        return text("No price data available")|center|border;
+    }
+
+    return vbox({
+        PlotLineGraph(series,title),
+        separator(),
+        priceFooter(summary.last,summary.min,summary.max)
     })|border;
 }
\ No newline at end of file
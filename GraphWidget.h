@@ -3,24 +3,38 @@
 #include<vector>
 #include<string>
 #include<map>
+#include<unordered_map>
+#include<utility>
 #include<cmath>
 #include "FTXUI/include/ftxui/component/component.hpp"
 #include "FTXUI/include/ftxui/dom/elements.hpp"
+#include "PriceSeries.h"
 
 class GraphUtils{
 public:
     static ftxui::Element PlotPositionSizes(const std::unordered_map<std::string,double> &positions);
 
+    // data is read when the element is rendered, not copied: keep it alive and unchanged until then
     static ftxui::Element PlotLineGraph(const std::vector<double>& data,const std::string& title="",int width=50,int height=10);
 
+    // Live chart of a price history, downsampled to the graph's width on every render
+    static ftxui::Element PlotLineGraph(const PriceSeries& series,const std::string& title="",int height=10);
+
     static ftxui::Element PlotBarGraph(const std::vector<std::pair<std::string,double>>& data,const std::string& title="");
 
     static ftxui::Element PlotPriceMovement(const std::vector<double>& prices,const std::string& title="Price Movement");
 
+    static ftxui::Element PlotPriceMovement(const PriceSeries& series,const std::string& title="Price Movement");
+
     static ftxui::Element PlotOrderSizeDistribution(const std::vector<double>& order_sizes);
 
-private:
+    // The data pipeline behind PlotLineGraph, exposed for benchmarks
+    static std::vector<double> SampleForWidth(const std::vector<double>& data,int width);
     static std::vector<int> NormalizeData(const std::vector<double>& data,int height);
+    // Scale data into 0..height-1 against [minVal, maxVal], reusing out's storage
+    static void NormalizeInto(const std::vector<double>& data,double minVal,double maxVal,int height,std::vector<int>& out);
+
+private:
     static double FindMin(const std::vector<double>& data);
     static double FindMax(const std::vector<double>& data);
 
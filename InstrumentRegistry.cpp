@@ -0,0 +1,93 @@
+#include "InstrumentRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Snapshot layout: a header, then one fixed-size record per instrument, read in place
+struct InstrumentSnapshotHeader {
+    char magic[8];
+    uint32_t recordSize;        // Changes whenever InstrumentSpec does, invalidating old files
+    uint32_t count;
+    int64_t savedAtMs;
+};
+
+struct InstrumentSnapshotRecord {
+    char name[64];              // Zero-padded
+    InstrumentSpec spec;
+};
+
+static const char SnapshotMagic[8] = {'D', 'R', 'B', 'I', 'N', 'S', 'T', '2'};
+
+static int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool InstrumentRegistry::saveSnapshot(const std::string& path) const {
+    std::vector<InstrumentSnapshotRecord> records;
+    records.reserve(size());
+    for (InstrumentId id = 0; id < size(); ++id) {
+        InstrumentSnapshotRecord record = {};
+        std::string_view instrument = name(id);
+        if (instrument.size() >= sizeof(record.name) || !spec(id, record.spec)) continue;
+        std::memcpy(record.name, instrument.data(), instrument.size());
+        records.push_back(record);
+    }
+
+    InstrumentSnapshotHeader header = {};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.recordSize = sizeof(InstrumentSnapshotRecord);
+    header.count = static_cast<uint32_t>(records.size());
+    header.savedAtMs = wallClockMs();
+
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(records.data(), sizeof(InstrumentSnapshotRecord), records.size(), file) == records.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t InstrumentRegistry::loadSnapshot(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(InstrumentSnapshotHeader)) {
+        ::close(fd);
+        return 0;
+    }
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return 0;
+
+    const char* base = static_cast<const char*>(mapped);
+    InstrumentSnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    size_t loaded = 0;
+    if (std::memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) == 0 &&
+        header.recordSize == sizeof(InstrumentSnapshotRecord) &&
+        sizeof(header) + static_cast<size_t>(header.count) * sizeof(InstrumentSnapshotRecord) <= length) {
+        const auto* records = reinterpret_cast<const InstrumentSnapshotRecord*>(base + sizeof(header));
+        int64_t nowMs = wallClockMs();
+        for (uint32_t i = 0; i < header.count; ++i) {
+            const InstrumentSnapshotRecord& record = records[i];
+            if (record.spec.expirationMs != 0 && record.spec.expirationMs <= nowMs) continue;
+            InstrumentId id = intern(std::string_view(record.name, strnlen(record.name, sizeof(record.name))));
+            if (id == NoInstrument) break;
+            setSpec(id, record.spec);
+            ++loaded;
+        }
+    }
+    ::munmap(mapped, length);
+    return loaded;
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include<atomic>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<string>
+#include<string_view>
+#include<type_traits>
+#include "FixedPoint.h"
+#include "StringInterner.h"
+#include "types.hpp"
+
+using InstrumentId = uint32_t;
+constexpr InstrumentId NoInstrument = StringInterner::None;
+
+enum class OptionKind : uint8_t {
+    None,
+    Call,
+    Put
+};
+
+// Trading rules and terms of an instrument, from public/get_instrument(s)
+struct InstrumentSpec {
+    Price tickSize;             // Prices must be a multiple of this
+    Qty contractSize;           // Amount units per contract
+    Qty minTradeAmount;         // Smallest order; amounts must be a multiple of it
+    Price strike;               // Options only
+    int64_t expirationMs = 0;   // Exchange time (ms); far in the future for perpetuals
+    InstrumentType kind = InstrumentType::Futures;   // Combos count as their legs' kind
+    OptionKind optionKind = OptionKind::None;
+    bool inverse = false;       // Amount is USD notional, settled in the base coin (instrument_type "reversed")
+};
+
+static_assert(std::is_trivially_copyable<InstrumentSpec>::value, "Specs are stored as raw words and written to disk");
+static_assert(sizeof(InstrumentSpec) % 8 == 0, "Specs are stored as whole 64-bit words");
+
+// Dense ids for instrument names.
+//
+// Everything past the JSON boundary refers to instruments by InstrumentId, so
+// hot structures hold four bytes instead of a std::string, compare with a
+// single integer compare and keep per-instrument state in arrays indexed by
+// id. Ids are assigned in first-seen order and never reused.
+//
+// Each id also has a slot for the instrument's spec. Specs are written by one
+// thread at a time (the cache load at startup, then the dispatcher) and read
+// lock-free from any thread; a refresh that changes a spec is picked up by the
+// next read, never seen half-written.
+//
+// The whole set of specs can be saved to a snapshot file and mapped back in on
+// the next start, so order entry has tick sizes before the first response
+// from the exchange arrives.
+class InstrumentRegistry {
+public:
+    explicit InstrumentRegistry(uint32_t capacity = 16384) : names(capacity), specs(new SpecSlot[capacity]) {}
+
+    InstrumentId intern(std::string_view name) { return names.intern(name); }
+    InstrumentId find(std::string_view name) const { return names.find(name); }
+    std::string_view name(InstrumentId id) const { return names.name(id); }
+    uint32_t size() const { return names.size(); }
+    uint32_t capacity() const { return names.capacity(); }
+
+    bool hasSpec(InstrumentId id) const {
+        return id < names.capacity() && specs[id].state.load(std::memory_order_acquire) == Loaded;
+    }
+
+    // Copy id's spec into out. False until one is loaded.
+    bool spec(InstrumentId id, InstrumentSpec& out) const {
+        if (!hasSpec(id)) return false;
+        const SpecSlot& slot = specs[id];
+        uint64_t words[SpecWords];
+        uint32_t before, after;
+        do {
+            before = slot.sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < SpecWords; ++i) words[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        std::memcpy(&out, words, sizeof(out));
+        return true;
+    }
+
+    // Store (or replace) id's spec
+    void setSpec(InstrumentId id, const InstrumentSpec& spec) {
+        if (id >= names.capacity()) return;
+        SpecSlot& slot = specs[id];
+        uint64_t words[SpecWords];
+        std::memcpy(words, &spec, sizeof(spec));
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < SpecWords; ++i) slot.words[i].store(words[i], std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        slot.state.store(Loaded, std::memory_order_release);
+    }
+
+    // True for the one caller that should fetch id's spec; false once it is requested or loaded
+    bool claimSpecRequest(InstrumentId id) {
+        if (id >= names.capacity()) return false;
+        uint8_t expected = Missing;
+        return specs[id].state.compare_exchange_strong(expected, Requested, std::memory_order_relaxed);
+    }
+
+    // The request failed: let the next caller try again
+    void releaseSpecRequest(InstrumentId id) {
+        if (id >= names.capacity()) return;
+        uint8_t expected = Requested;
+        specs[id].state.compare_exchange_strong(expected, Missing, std::memory_order_relaxed);
+    }
+
+    // Write every instrument with a spec to path (through a temporary file, so a
+    // crash never leaves a torn snapshot). False on I/O errors.
+    bool saveSnapshot(const std::string& path) const;
+
+    // Map a snapshot written by saveSnapshot() and load its specs, skipping
+    // instruments that have expired since. Returns how many were loaded; 0 when
+    // the file is missing or not a snapshot of this layout.
+    size_t loadSnapshot(const std::string& path);
+
+private:
+    enum : uint8_t { Missing, Requested, Loaded };
+    static constexpr size_t SpecWords = sizeof(InstrumentSpec) / 8;
+
+    struct SpecSlot {
+        std::atomic<uint32_t> sequence{0};          // Odd while the words are being written
+        std::atomic<uint8_t> state{Missing};
+        std::atomic<uint64_t> words[SpecWords] = {};
+    };
+
+    StringInterner names;
+    std::unique_ptr<SpecSlot[]> specs;
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include<atomic>
+#include<cstddef>
+#include<cstdint>
+
+// Log-linear latency histogram in the style of HdrHistogram.
+//
+// Values below 128 get a bucket each; above that every power of two is split
+// into 64 equal sub-buckets, so any recorded value is reported within 1/64
+// (~1.6%) of its true size, from nanoseconds up to the full int64 range, in a
+// fixed 30 KB of counters. Recording is a handful of relaxed atomic adds, so
+// any thread may record while another reads percentiles; a reader racing a
+// writer may see a count one sample ahead of the buckets, never a torn value.
+class LatencyHistogram {
+public:
+    static constexpr int SubBucketBits = 6;
+    static constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;           // Per power of two
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    void record(int64_t value) {
+        uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+        buckets[indexOf(v)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(v, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (v > seen && !maximum.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+    double mean() const {
+        uint64_t n = count();
+        return n ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0.0;
+    }
+
+    // Smallest value v such that at least q (0..1) of the samples are <= v,
+    // reported as the upper edge of its bucket. 0 when empty.
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * n + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > n) rank = n;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = upperEdge(i);
+                uint64_t top = max();
+                return upper < top ? upper : top;
+            }
+        }
+        return max();
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> buckets[BucketCount] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static size_t indexOf(uint64_t v) {
+        if (v < 2 * SubBuckets) return static_cast<size_t>(v);
+        int shift = 63 - __builtin_clzll(v) - SubBucketBits;     // v >> shift lands in [64, 128)
+        return static_cast<size_t>((shift + 1) * SubBuckets + ((v >> shift) - SubBuckets));
+    }
+
+    static uint64_t upperEdge(size_t index) {
+        if (index < 2 * SubBuckets) return index;
+        int shift = static_cast<int>(index / SubBuckets) - 1;
+        uint64_t sub = index % SubBuckets + SubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+};
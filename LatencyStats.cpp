@@ -0,0 +1,62 @@
+#include "LatencyStats.h"
+#include <cstdio>
+
+const char* latencyStageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Build: return "Build";
+        case LatencyStage::Send: return "Send";
+        case LatencyStage::Wire: return "Wire";
+        case LatencyStage::Exchange: return "  Exchange";
+        case LatencyStage::Network: return "  Network";
+        case LatencyStage::Queue: return "Queue";
+        case LatencyStage::Parse: return "Parse";
+        case LatencyStage::Dispatch: return "Dispatch";
+        case LatencyStage::RoundTrip: return "Round trip";
+        default: return "?";
+    }
+}
+
+void LatencyStats::recordRequest(const RequestTimes& request, const ReceiveTimes& response, int64_t doneNs) {
+    recordSpan(LatencyStage::Build, request.startNs, request.encodedNs);
+    recordSpan(LatencyStage::Send, request.encodedNs, request.sentNs);
+    recordSpan(LatencyStage::Wire, request.sentNs, response.rxNs);
+    if (response.exchangeNs > 0 && request.sentNs && response.rxNs) {
+        int64_t wireNs = response.rxNs - request.sentNs;
+        stages[static_cast<int>(LatencyStage::Exchange)].record(response.exchangeNs);
+        stages[static_cast<int>(LatencyStage::Network)].record(wireNs > response.exchangeNs ? wireNs - response.exchangeNs : 0);
+    }
+    recordSpan(LatencyStage::Queue, response.rxNs, response.dequeuedNs);
+    recordSpan(LatencyStage::Parse, response.dequeuedNs, response.decodedNs);
+    recordSpan(LatencyStage::Dispatch, response.decodedNs, doneNs);
+    recordSpan(LatencyStage::RoundTrip, request.startNs, doneNs);
+}
+
+LatencySummary LatencyStats::summary(LatencyStage stage) const {
+    const LatencyHistogram& h = histogram(stage);
+    LatencySummary s;
+    s.count = h.count();
+    s.meanNs = h.mean();
+    s.p50Ns = h.percentile(0.50);
+    s.p99Ns = h.percentile(0.99);
+    s.p999Ns = h.percentile(0.999);
+    s.maxNs = h.max();
+    return s;
+}
+
+void LatencyStats::reset() {
+    for (auto& stage : stages) stage.reset();
+}
+
+void LatencyStats::dump(std::ostream& out) const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-11s %9s %10s %10s %10s %10s\n", "Stage (us)", "count", "p50", "p99", "p99.9", "max");
+    out << line;
+    for (int i = 0; i < static_cast<int>(LatencyStage::Count); ++i) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        LatencySummary s = summary(stage);
+        std::snprintf(line, sizeof(line), "%-11s %9llu %10.1f %10.1f %10.1f %10.1f\n", latencyStageName(stage),
+                      static_cast<unsigned long long>(s.count), s.p50Ns / 1000.0, s.p99Ns / 1000.0, s.p999Ns / 1000.0,
+                      s.maxNs / 1000.0);
+        out << line;
+    }
+}
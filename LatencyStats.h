@@ -0,0 +1,67 @@
+#pragma once
+#include<cstdint>
+#include<ostream>
+#include "LatencyHistogram.h"
+
+// Stages of an order request's round trip, in the order they happen
+enum class LatencyStage {
+    Build,       // placeOrder/cancelOrder/modifyOrder called -> request encoded
+    Send,        // encoded -> handed to the websocket (sendApiRequest)
+    Wire,        // handed to the websocket -> response frame received by the I/O thread
+    Exchange,    //   part of Wire spent inside the exchange (its usOut - usIn)
+    Network,     //   the rest of Wire: both directions on the network
+    Queue,       // received -> picked up by the dispatcher
+    Parse,       // picked up -> top level decoded
+    Dispatch,    // decoded -> processApiResponse done with it, caller about to be completed
+    RoundTrip,   // called -> completed
+    Count
+};
+
+const char* latencyStageName(LatencyStage stage);
+
+// steady_clock stamps of a request, kept with it while it is in flight (0 = not stamped)
+struct RequestTimes {
+    int64_t startNs = 0;
+    int64_t encodedNs = 0;
+    int64_t sentNs = 0;
+};
+
+// steady_clock stamps of the response frame, from the receive path
+struct ReceiveTimes {
+    int64_t rxNs = 0;
+    int64_t dequeuedNs = 0;
+    int64_t decodedNs = 0;
+    int64_t exchangeNs = 0;   // The exchange's own processing time, from usIn/usOut (0 if unstamped)
+};
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double meanNs = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+// Per-stage histograms of order round trips. Shared by the order manager
+// (which records from the dispatcher thread) and any number of readers.
+class LatencyStats {
+public:
+    // Record every stage both sides stamped, ending at doneNs
+    void recordRequest(const RequestTimes& request, const ReceiveTimes& response, int64_t doneNs);
+
+    const LatencyHistogram& histogram(LatencyStage stage) const { return stages[static_cast<int>(stage)]; }
+    LatencySummary summary(LatencyStage stage) const;
+
+    void reset();
+
+    // Table of p50/p99/p99.9 per stage, in microseconds
+    void dump(std::ostream& out) const;
+
+private:
+    LatencyHistogram stages[static_cast<int>(LatencyStage::Count)];
+
+    void recordSpan(LatencyStage stage, int64_t fromNs, int64_t toNs) {
+        if (fromNs && toNs) stages[static_cast<int>(stage)].record(toNs - fromNs);
+    }
+};
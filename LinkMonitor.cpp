@@ -0,0 +1,80 @@
+#include "LinkMonitor.h"
+#include <algorithm>
+#include <chrono>
+
+static int64_t wallClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void LinkMonitor::reset(int64_t nowNs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Probe& probe : probes) probe = Probe();
+    nextProbe = 0;
+    sampleCount = 0;
+    lastRttUs = smoothedRttUs = jitterUs = exchangeUs = 0;
+    lastFrameNs.store(nowNs, std::memory_order_relaxed);
+}
+
+bool LinkMonitor::isTestRequest(std::string_view payload) {
+    // {"jsonrpc":"2.0","method":"heartbeat","params":{"type":"test_request"}}; anything long is something else
+    return payload.size() < 128 && payload.find("\"test_request\"") != std::string_view::npos;
+}
+
+void LinkMonitor::probeSent(int64_t id, int64_t sentNs) {
+    if (id == 0) return;
+    int64_t sentWallUs = wallClockUs();
+    std::lock_guard<std::mutex> lock(mutex);
+    // The oldest probe gives way; if it is still unanswered it was lost anyway
+    probes[nextProbe] = Probe{id, sentNs, sentWallUs};
+    nextProbe = (nextProbe + 1) % Window;
+}
+
+bool LinkMonitor::probeAnswered(int64_t id, int64_t rxNs, int64_t usIn, int64_t usOut) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Probe* probe = std::find_if(probes, probes + Window, [id](const Probe& p) { return p.id == id; });
+    if (probe == probes + Window) return false;
+    Probe sent = *probe;
+    *probe = Probe();
+    if (usIn == 0 || usOut < usIn || rxNs < sent.sentNs) return true;   // Unstamped answer: nothing to learn
+
+    int64_t elapsedUs = (rxNs - sent.sentNs) / 1000;
+    int64_t receivedWallUs = sent.sentWallUs + elapsedUs;
+    exchangeUs = usOut - usIn;
+    lastRttUs = std::max<int64_t>(0, elapsedUs - exchangeUs);
+    int64_t offsetUs = ((usIn - sent.sentWallUs) + (usOut - receivedWallUs)) / 2;
+
+    if (sampleCount == 0) {
+        smoothedRttUs = lastRttUs;
+        jitterUs = lastRttUs / 2;
+    } else {
+        int64_t deviation = lastRttUs > smoothedRttUs ? lastRttUs - smoothedRttUs : smoothedRttUs - lastRttUs;
+        jitterUs += (deviation - jitterUs) / 4;
+        smoothedRttUs += (lastRttUs - smoothedRttUs) / 8;
+    }
+    samples[sampleCount % Window] = Sample{lastRttUs, offsetUs};
+    ++sampleCount;
+    return true;
+}
+
+LinkStats LinkMonitor::stats(int64_t nowNs) const {
+    LinkStats out;
+    int64_t last = lastFrameNs.load(std::memory_order_relaxed);
+    out.silentMs = last ? (nowNs - last) / 1000000 : 0;
+    out.stale = isStale(nowNs);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    out.samples = sampleCount;
+    out.lastRttUs = lastRttUs;
+    out.smoothedRttUs = smoothedRttUs;
+    out.jitterUs = jitterUs;
+    out.exchangeUs = exchangeUs;
+    int kept = static_cast<int>(std::min<int64_t>(sampleCount, Window));
+    if (kept > 0) {
+        const Sample* best = std::min_element(samples, samples + kept,
+                                              [](const Sample& a, const Sample& b) { return a.rttUs < b.rttUs; });
+        out.minRttUs = best->rttUs;
+        out.clockOffsetUs = best->offsetUs;
+    }
+    return out;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include<atomic>
+#include<cstdint>
+#include<mutex>
+#include<string_view>
+
+// Health and timing of the link to the exchange
+struct LinkStats {
+    int64_t samples = 0;          // Probes answered on this connection
+    int64_t lastRttUs = 0;        // Network round trip of the latest probe, exchange time taken out
+    int64_t smoothedRttUs = 0;    // Moving average (1/8 weight per sample, like TCP's SRTT)
+    int64_t jitterUs = 0;         // Mean deviation from it (like TCP's RTTVAR)
+    int64_t minRttUs = 0;         // Best of the recent samples
+    int64_t clockOffsetUs = 0;    // Exchange clock minus ours, from the best recent sample
+    int64_t exchangeUs = 0;       // usOut - usIn of the latest probe: time spent inside the exchange
+    int64_t silentMs = 0;         // Since the last frame of any kind
+    bool stale = false;           // Silent for longer than the stale limit
+};
+
+// Round trip and clock offset estimates from public/test probes, and stale
+// link detection.
+//
+// Each probe is stamped when it goes out and when its answer is received; the
+// answer carries the exchange's own receive and send times (usIn, usOut). As
+// in NTP, round trip = (received - sent) - (usOut - usIn), and clock offset =
+// ((usIn - sent) + (usOut - received)) / 2. Offsets are taken from the fastest
+// of the last few probes, whose errors are the smallest. Subtracting the
+// exchange's time from the wire time is what separates network latency from
+// matching-engine latency.
+//
+// The I/O thread stamps every frame and sends probes; the dispatcher thread
+// reports answers; anyone may read stats().
+class LinkMonitor {
+public:
+    static constexpr int Window = 8;              // Recent samples kept; also the most probes in flight
+
+    explicit LinkMonitor(int64_t staleAfterMs = 15000) : staleAfterNs(staleAfterMs * 1000000) {}
+
+    // A new connection: forget the last one's probes and samples
+    void reset(int64_t nowNs);
+
+    // I/O thread: a frame arrived at steady rxNs
+    void frameReceived(int64_t rxNs) { lastFrameNs.store(rxNs, std::memory_order_relaxed); }
+
+    // Cheap enough for the I/O thread: is this the exchange asking for a public/test?
+    static bool isTestRequest(std::string_view payload);
+
+    // Probe request id went out at steady sentNs
+    void probeSent(int64_t id, int64_t sentNs);
+
+    // If id is an outstanding probe, take its answer (received at steady rxNs, with the
+    // exchange's usIn/usOut) and return true
+    bool probeAnswered(int64_t id, int64_t rxNs, int64_t usIn, int64_t usOut);
+
+    // No frame for longer than the stale limit: the connection should be replaced
+    bool isStale(int64_t nowNs) const {
+        int64_t last = lastFrameNs.load(std::memory_order_relaxed);
+        return last != 0 && nowNs - last > staleAfterNs;
+    }
+
+    LinkStats stats(int64_t nowNs) const;
+
+private:
+    struct Probe {
+        int64_t id = 0;           // 0: free
+        int64_t sentNs = 0;       // steady_clock
+        int64_t sentWallUs = 0;   // system_clock, to compare with the exchange's stamps
+    };
+    struct Sample {
+        int64_t rttUs = 0;
+        int64_t offsetUs = 0;
+    };
+
+    const int64_t staleAfterNs;
+    std::atomic<int64_t> lastFrameNs{0};
+
+    mutable std::mutex mutex;     // Guards everything below
+    Probe probes[Window];
+    int nextProbe = 0;
+    Sample samples[Window];
+    int64_t sampleCount = 0;
+    int64_t lastRttUs = 0;
+    int64_t smoothedRttUs = 0;
+    int64_t jitterUs = 0;
+    int64_t exchangeUs = 0;
+};
@@ -0,0 +1,259 @@
+#include "Logger.h"
+#include <cctype>
+#include <charconv>
+#include <ctime>
+
+namespace {
+constexpr size_t FileBuffer = 1 << 20;
+
+const char* baseName(const char* path) {
+    const char* slash = std::strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// Decode one argument at in, append it to line; returns the next argument
+const char* appendArg(std::string& line, const char* in) {
+    char text[32];
+    LogArgTag tag = static_cast<LogArgTag>(*in++);
+    if (tag == LogArgTag::String) {
+        uint32_t length;
+        std::memcpy(&length, in, 4);
+        line.append(in + 4, length);
+        return in + 4 + length;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, in, 8);
+    switch (tag) {
+        case LogArgTag::Int:
+            line.append(text, std::to_chars(text, text + sizeof(text), static_cast<int64_t>(bits)).ptr);
+            break;
+        case LogArgTag::Uint:
+            line.append(text, std::to_chars(text, text + sizeof(text), bits).ptr);
+            break;
+        case LogArgTag::Double: {
+            double value;
+            std::memcpy(&value, &bits, 8);
+            line.append(text, std::to_chars(text, text + sizeof(text), value).ptr);
+            break;
+        }
+        case LogArgTag::Bool:
+            line.append(bits ? "true" : "false");
+            break;
+        case LogArgTag::Char:
+            line.push_back(static_cast<char>(bits));
+            break;
+        default:
+            break;
+    }
+    return in + 8;
+}
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+LogLevel parseLogLevel(std::string_view name) {
+    std::string lower;
+    for (char c : name) lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    if (lower == "trace") return LogLevel::Trace;
+    if (lower == "debug") return LogLevel::Debug;
+    if (lower == "warn" || lower == "warning") return LogLevel::Warn;
+    if (lower == "error") return LogLevel::Error;
+    if (lower == "off") return LogLevel::Off;
+    return LogLevel::Info;
+}
+
+LogRing::LogRing(size_t capacity, uint32_t threadIndex) : threadIndex(threadIndex) {
+    size_t size = 64;
+    while (size < capacity) size <<= 1;
+    buffer.reset(new char[size]);
+    mask = size - 1;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+bool Logger::start(const std::string& path, size_t ringSize) {
+    stop();
+    file = std::fopen(path.c_str(), "a");
+    if (!file) {
+        std::fprintf(stderr, "Could not open log file %s\n", path.c_str());
+        return false;
+    }
+    fileBuffer.resize(FileBuffer);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+    ringBytes = ringSize;
+    startSteadyNs = nowNs();
+    startRealtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        writerStop = false;
+    }
+    writer = std::thread(&Logger::run, this);
+    running.store(true, std::memory_order_release);
+    return true;
+}
+
+void Logger::stop() {
+    if (!writer.joinable()) return;
+    running.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        writerStop = true;
+    }
+    wakeCv.notify_one();
+    writer.join();
+
+    std::string line;
+    drainAll(line);
+    std::fclose(file);
+    file = nullptr;
+}
+
+void Logger::setThreadName(const char* name) {
+    LogRing& ring = threadRing();
+    std::strncpy(ring.threadName, name, sizeof(ring.threadName) - 1);
+}
+
+LogRing& Logger::threadRing() {
+    thread_local std::shared_ptr<LogRing> ring;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ring = std::make_shared<LogRing>(ringBytes, ++nextThreadIndex);
+        rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void Logger::run() {
+    std::string line;
+    line.reserve(4096);
+    bool unflushed = false;
+    while (true) {
+        if (drainAll(line) > 0) {
+            unflushed = true;
+            continue;
+        }
+        // Idle: push what was written to the file, then nap
+        if (unflushed) {
+            std::fflush(file);
+            unflushed = false;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (wakeCv.wait_for(lock, std::chrono::milliseconds(1), [this] { return writerStop; })) break;
+    }
+}
+
+size_t Logger::drainAll(std::string& line) {
+    std::vector<std::shared_ptr<LogRing>> current;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        // Rings whose thread has exited are dropped once they are empty
+        for (size_t i = 0; i < rings.size();) {
+            if (rings[i].use_count() == 1 && rings[i]->empty()) {
+                rings[i] = std::move(rings.back());
+                rings.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        current = rings;
+    }
+
+    size_t records = 0;
+    for (const std::shared_ptr<LogRing>& ring : current) {
+        records += ring->drain([&](const LogRing::RecordHeader& header, const char* args) {
+            format(line, *ring, header, args);
+            std::fwrite(line.data(), 1, line.size(), file);
+        });
+        if (uint64_t dropped = ring->takeDropped()) {
+            std::fprintf(file, "WARN  [T%u] log ring full, %llu records dropped\n", ring->threadIndex,
+                         static_cast<unsigned long long>(dropped));
+        }
+    }
+    return records;
+}
+
+void Logger::format(std::string& line, const LogRing& ring, const LogRing::RecordHeader& header, const char* args) {
+    line.clear();
+    int64_t realtimeNs = startRealtimeNs + (header.timestampNs - startSteadyNs);
+    std::time_t seconds = static_cast<std::time_t>(realtimeNs / 1000000000);
+    std::tm local;
+    localtime_r(&seconds, &local);
+    char prefix[96];
+    size_t length = std::strftime(prefix, sizeof(prefix), "%H:%M:%S", &local);
+    length += std::snprintf(prefix + length, sizeof(prefix) - length, ".%06d %-5s ",
+                            static_cast<int>(realtimeNs % 1000000000 / 1000), logLevelName(header.site->level));
+    line.append(prefix, length);
+    if (ring.threadName[0]) {
+        line.append("[").append(ring.threadName).append("] ");
+    } else {
+        line.append("[T").append(std::to_string(ring.threadIndex)).append("] ");
+    }
+    line.append(baseName(header.site->file));
+    if (header.site->line > 0) {
+        line.append(":").append(std::to_string(header.site->line));
+    }
+    line.append(": ");
+
+    const char* in = args;
+    const char* end = args + header.argBytes;
+    for (const char* f = header.site->format; *f; ++f) {
+        if (f[0] == '{' && f[1] == '}' && in < end) {
+            in = appendArg(line, in);
+            ++f;
+        } else {
+            line.push_back(*f);
+        }
+    }
+    // Arguments without a placeholder still show up
+    while (in < end) {
+        line.push_back(' ');
+        in = appendArg(line, in);
+    }
+    line.push_back('\n');
+}
+
+LogStream::Buffer::Buffer(LogLevel level, const char* source) : site{level, source, 0, "{}"} {}
+
+LogStream::Buffer::int_type LogStream::Buffer::overflow(int_type ch) {
+    if (ch == traits_type::eof()) return traits_type::not_eof(ch);
+    if (ch == '\n') {
+        emit();
+    } else {
+        line.push_back(static_cast<char>(ch));
+    }
+    return ch;
+}
+
+int LogStream::Buffer::sync() {
+    if (!line.empty()) emit();
+    return 0;
+}
+
+void LogStream::Buffer::emit() {
+    if (logger().enabled(site.level)) {
+        logger().write(site, line);
+    }
+    line.clear();
+}
+
+LogStream::LogStream(LogLevel level, const char* source) : std::ostream(nullptr), buffer(level, source) {
+    rdbuf(&buffer);
+}
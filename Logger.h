@@ -0,0 +1,299 @@
+#pragma once
+#include<atomic>
+#include<chrono>
+#include<condition_variable>
+#include<cstdint>
+#include<cstdio>
+#include<cstring>
+#include<memory>
+#include<mutex>
+#include<ostream>
+#include<streambuf>
+#include<string>
+#include<string_view>
+#include<thread>
+#include<type_traits>
+#include<vector>
+
+enum class LogLevel : uint8_t {
+    Trace = 0,
+    Debug = 1,
+    Info = 2,
+    Warn = 3,
+    Error = 4,
+    Off = 5
+};
+
+// Statements below this level are compiled out entirely (arguments are not even
+// evaluated). Build with -DLOG_COMPILE_LEVEL=0 to get trace/debug output back.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL 2
+#endif
+
+const char* logLevelName(LogLevel level);
+// "debug", "info", ... (case-insensitive); Info when unknown
+LogLevel parseLogLevel(std::string_view name);
+
+// Static description of one LOG_* statement; records only point at it
+struct LogSite {
+    LogLevel level;
+    const char* file;
+    int line;
+    const char* format;      // "{}" marks where each argument goes
+};
+
+// Per-thread single-producer/single-consumer byte ring of binary log records.
+//
+// The owning thread appends records without locks or allocation; the logger's
+// writer thread is the only consumer. A full ring drops the record (and counts
+// it) instead of blocking the producer.
+class LogRing {
+public:
+    struct RecordHeader {
+        uint32_t size;           // Whole record, padded to 8; a null site marks padding before a wrap
+        uint32_t argBytes;
+        const LogSite* site;
+        int64_t timestampNs;     // steady_clock
+    };
+
+    explicit LogRing(size_t capacity, uint32_t threadIndex);
+
+    // Producer: room for a record of size bytes (multiple of 8), or null when full
+    char* reserve(size_t size) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t offset = t & mask;
+        size_t contiguous = mask + 1 - offset;
+        size_t need = contiguous < size ? contiguous + size : size;
+        if (t + need - cachedHead > mask + 1) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t + need - cachedHead > mask + 1) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        pendingAdvance = need;
+        if (contiguous < size) {
+            // Pad out the end and start the record at the beginning
+            if (contiguous >= sizeof(RecordHeader)) {
+                RecordHeader pad{static_cast<uint32_t>(contiguous), 0, nullptr, 0};
+                std::memcpy(buffer.get() + offset, &pad, sizeof(pad));
+            }
+            return buffer.get();
+        }
+        return buffer.get() + offset;
+    }
+
+    // Producer: publish the reserved record
+    void commit() { tail.store(tail.load(std::memory_order_relaxed) + pendingAdvance, std::memory_order_release); }
+
+    // Consumer: hand every complete record to fn(header, args); returns how many
+    template <typename Fn>
+    size_t drain(Fn&& fn) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t records = 0;
+        while (h < t) {
+            size_t offset = h & mask;
+            size_t contiguous = mask + 1 - offset;
+            if (contiguous < sizeof(RecordHeader)) {
+                h += contiguous;
+                continue;
+            }
+            RecordHeader header;
+            std::memcpy(&header, buffer.get() + offset, sizeof(header));
+            if (header.site) {
+                fn(header, buffer.get() + offset + sizeof(header));
+                ++records;
+            }
+            h += header.size;
+        }
+        head.store(h, std::memory_order_release);
+        return records;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    uint64_t takeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+    uint32_t threadIndex;
+    char threadName[16] = {};
+
+private:
+    static constexpr size_t CacheLine = 64;
+
+    std::unique_ptr<char[]> buffer;
+    size_t mask;
+    alignas(CacheLine) std::atomic<size_t> head{0};   // Consumer
+    alignas(CacheLine) std::atomic<size_t> tail{0};   // Producer
+    size_t cachedHead = 0;
+    size_t pendingAdvance = 0;
+    std::atomic<uint64_t> dropped{0};
+};
+
+// Argument encoding: a tag byte, then 8 bytes for numbers or a 4-byte length and the bytes for strings
+enum class LogArgTag : uint8_t { Int = 1, Uint, Double, Bool, Char, String };
+
+constexpr size_t LogMaxString = 4096;   // Longer strings are cut
+
+inline size_t logClip(size_t length) { return length < LogMaxString ? length : LogMaxString; }
+
+template <typename T>
+size_t logArgSize(const T& value) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        return 1 + 8;
+    } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        return 1 + 4 + logClip(std::string_view(value).size());
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "Unsupported log argument type");
+        return 0;
+    }
+}
+
+template <typename T>
+char* logArgPut(char* out, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        *out++ = static_cast<char>(LogArgTag::Bool);
+        uint64_t v = value;
+        std::memcpy(out, &v, 8);
+    } else if constexpr (std::is_same_v<T, char>) {
+        *out++ = static_cast<char>(LogArgTag::Char);
+        uint64_t v = static_cast<unsigned char>(value);
+        std::memcpy(out, &v, 8);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        *out++ = static_cast<char>(LogArgTag::Double);
+        double v = value;
+        std::memcpy(out, &v, 8);
+    } else if constexpr (std::is_enum_v<T>) {
+        *out++ = static_cast<char>(LogArgTag::Int);
+        int64_t v = static_cast<int64_t>(value);
+        std::memcpy(out, &v, 8);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        *out++ = static_cast<char>(LogArgTag::Int);
+        int64_t v = value;
+        std::memcpy(out, &v, 8);
+    } else if constexpr (std::is_integral_v<T>) {
+        *out++ = static_cast<char>(LogArgTag::Uint);
+        uint64_t v = value;
+        std::memcpy(out, &v, 8);
+    } else {
+        std::string_view s(value);
+        uint32_t length = static_cast<uint32_t>(logClip(s.size()));
+        *out++ = static_cast<char>(LogArgTag::String);
+        std::memcpy(out, &length, 4);
+        std::memcpy(out + 4, s.data(), length);
+        return out + 4 + length;
+    }
+    return out + 8;
+}
+
+// Asynchronous logger.
+//
+// LOG_* statements encode their arguments as binary into the calling thread's
+// LogRing (no formatting, no locks, no syscalls) and return. A background
+// writer thread drains every ring, formats the records and appends them to the
+// log file, so nothing on the network or dispatcher threads waits on I/O and
+// nothing is written to the terminal the FTXUI screen owns.
+class Logger {
+public:
+    static Logger& instance();
+
+    // Start the writer thread appending to path. Records are only taken while running.
+    bool start(const std::string& path, size_t ringBytes = 1 << 20);
+    // Drain every ring, write the rest out and join the writer
+    void stop();
+
+    void setLevel(LogLevel level) { minLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+    LogLevel level() const { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+
+    bool enabled(LogLevel level) const {
+        return running.load(std::memory_order_relaxed) &&
+               static_cast<uint8_t>(level) >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Name the calling thread in its records (first 15 characters)
+    void setThreadName(const char* name);
+
+    template <typename... Args>
+    void write(const LogSite& site, const Args&... args) {
+        size_t argBytes = (size_t(0) + ... + logArgSize(args));
+        size_t size = (sizeof(LogRing::RecordHeader) + argBytes + 7) & ~size_t(7);
+        LogRing& ring = threadRing();
+        char* record = ring.reserve(size);
+        if (!record) return;
+        LogRing::RecordHeader header{static_cast<uint32_t>(size), static_cast<uint32_t>(argBytes), &site, nowNs()};
+        std::memcpy(record, &header, sizeof(header));
+        char* out = record + sizeof(header);
+        ((out = logArgPut(out, args)), ...);
+        static_cast<void>(out);
+        ring.commit();
+    }
+
+private:
+    Logger() = default;
+    ~Logger();
+
+    std::atomic<bool> running{false};
+    std::atomic<uint8_t> minLevel{static_cast<uint8_t>(LogLevel::Info)};
+    size_t ringBytes = 1 << 20;
+
+    std::mutex ringsMutex;                          // Guards rings (threads register rarely)
+    std::vector<std::shared_ptr<LogRing>> rings;
+    uint32_t nextThreadIndex = 0;
+
+    std::FILE* file = nullptr;
+    std::vector<char> fileBuffer;
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    bool writerStop = false;
+    int64_t startSteadyNs = 0;
+    int64_t startRealtimeNs = 0;
+
+    LogRing& threadRing();
+    void run();
+    size_t drainAll(std::string& line);
+    void format(std::string& line, const LogRing& ring, const LogRing::RecordHeader& header, const char* args);
+};
+
+inline Logger& logger() { return Logger::instance(); }
+
+// An ostream whose lines become log records, for libraries that insist on
+// writing to a stream (websocketpp's access and error logs)
+class LogStream : public std::ostream {
+public:
+    LogStream(LogLevel level, const char* source);
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(LogLevel level, const char* source);
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+    private:
+        LogSite site;
+        std::string line;
+        void emit();
+    };
+    Buffer buffer;
+};
+
+#define LOG_AT(level, fmt, ...)                                                          \
+    do {                                                                                  \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILE_LEVEL) {                     \
+            if (logger().enabled(level)) {                                                \
+                static constexpr LogSite logSite{level, __FILE__, __LINE__, fmt};         \
+                logger().write(logSite, ##__VA_ARGS__);                                   \
+            }                                                                             \
+        }                                                                                 \
+    } while (0)
+
+#define LOG_TRACE(fmt, ...) LOG_AT(LogLevel::Trace, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LOG_AT(LogLevel::Debug, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LogLevel::Info, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LogLevel::Warn, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LogLevel::Error, fmt, ##__VA_ARGS__)
@@ -0,0 +1,286 @@
+#include "MessageDecoder.h"
+#include "FixedPoint.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+JsonCursor::JsonCursor(std::string_view json)
+    : pos(json.data()), end(json.data() + json.size()) {}
+
+void JsonCursor::skipWhitespace() {
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+        ++pos;
+    }
+}
+
+char JsonCursor::peek() {
+    skipWhitespace();
+    return pos < end ? *pos : '\0';
+}
+
+bool JsonCursor::push() {
+    if (depth == MaxDepth) return fail();
+    first[depth++] = true;
+    return true;
+}
+
+bool JsonCursor::beginObject() {
+    if (failed || peek() != '{') return fail();
+    ++pos;
+    return push();
+}
+
+bool JsonCursor::beginArray() {
+    if (failed || peek() != '[') return fail();
+    ++pos;
+    return push();
+}
+
+bool JsonCursor::nextMember(std::string_view& key) {
+    if (failed || depth == 0) return false;
+    if (peek() == '}') {
+        ++pos;
+        --depth;
+        return false;
+    }
+    if (!first[depth - 1]) {
+        if (peek() != ',') return fail();
+        ++pos;
+    }
+    first[depth - 1] = false;
+    if (!readString(key)) return false;
+    if (peek() != ':') return fail();
+    ++pos;
+    return true;
+}
+
+bool JsonCursor::nextElement() {
+    if (failed || depth == 0) return false;
+    if (peek() == ']') {
+        ++pos;
+        --depth;
+        return false;
+    }
+    if (!first[depth - 1]) {
+        if (peek() != ',') return fail();
+        ++pos;
+    }
+    first[depth - 1] = false;
+    return true;
+}
+
+bool JsonCursor::skipString() {
+    // pos is on the opening quote
+    for (++pos; pos < end; ++pos) {
+        if (*pos == '\\') {
+            ++pos;
+        } else if (*pos == '"') {
+            ++pos;
+            return true;
+        }
+    }
+    return fail();
+}
+
+bool JsonCursor::readString(std::string_view& out) {
+    if (failed || peek() != '"') return fail();
+    const char* start = pos + 1;
+    if (!skipString()) return false;
+    out = std::string_view(start, static_cast<size_t>(pos - 1 - start));
+    return true;
+}
+
+bool JsonCursor::readDouble(double& out) {
+    if (failed) return false;
+    skipWhitespace();
+    auto [ptr, ec] = std::from_chars(pos, end, out);
+    if (ec != std::errc()) return fail();
+    pos = ptr;
+    return true;
+}
+
+bool JsonCursor::readInt(int64_t& out) {
+    if (failed) return false;
+    skipWhitespace();
+    auto [ptr, ec] = std::from_chars(pos, end, out);
+    if (ec != std::errc()) return fail();
+    if (ptr < end && (*ptr == '.' || *ptr == 'e' || *ptr == 'E')) {
+        // Integral field sent with a fraction/exponent, e.g. 1e3
+        double value;
+        if (!readDouble(value)) return false;
+        out = static_cast<int64_t>(value);
+        return true;
+    }
+    pos = ptr;
+    return true;
+}
+
+bool JsonCursor::readFixed(int64_t& out) {
+    if (failed) return false;
+    skipWhitespace();
+    const char* p = pos;
+    bool negative = p < end && *p == '-';
+    if (negative) ++p;
+
+    const char* wholeStart = p;
+    int64_t whole = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        if (p - wholeStart < 11) whole = whole * 10 + (*p - '0');
+    }
+    if (p == wholeStart) return fail();
+    size_t wholeDigits = p - wholeStart;
+
+    int64_t fraction = 0;
+    int places = 0;
+    bool roundUp = false;
+    if (p < end && *p == '.') {
+        const char* fractionStart = ++p;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (places < FixedDigits) {
+                fraction = fraction * 10 + (*p - '0');
+                ++places;
+            } else if (p - fractionStart == FixedDigits) {
+                roundUp = *p >= '5';     // Finer than FixedScale: round half away from zero
+            }
+        }
+        if (p == fractionStart) return fail();
+    }
+
+    if ((p < end && (*p == 'e' || *p == 'E')) || wholeDigits > 10) {
+        // Exponent, or too large to scale in 64 bits
+        double value;
+        if (!readDouble(value)) return false;
+        if (std::abs(value) >= 9e10) return fail();   // Beyond 64 bits of 1e-8 units
+        out = toFixed(value);
+        return true;
+    }
+    for (; places < FixedDigits; ++places) fraction *= 10;
+    int64_t value = whole * FixedScale + fraction + roundUp;
+    out = negative ? -value : value;
+    pos = p;
+    return true;
+}
+
+bool JsonCursor::readBool(bool& out) {
+    char c = peek();
+    if (c == 't' && end - pos >= 4 && std::memcmp(pos, "true", 4) == 0) {
+        out = true;
+        pos += 4;
+        return true;
+    }
+    if (c == 'f' && end - pos >= 5 && std::memcmp(pos, "false", 5) == 0) {
+        out = false;
+        pos += 5;
+        return true;
+    }
+    return fail();
+}
+
+bool JsonCursor::readNull() {
+    if (peek() == 'n' && end - pos >= 4 && std::memcmp(pos, "null", 4) == 0) {
+        pos += 4;
+        return true;
+    }
+    return fail();
+}
+
+bool JsonCursor::skipValue() {
+    if (failed) return false;
+    char c = peek();
+    if (c == '"') return skipString();
+    if (c == '{' || c == '[') {
+        // Structural scan: count brackets, hop over strings, decode nothing
+        int nesting = 0;
+        while (pos < end) {
+            char ch = *pos;
+            if (ch == '"') {
+                if (!skipString()) return false;
+                continue;
+            }
+            ++pos;
+            if (ch == '{' || ch == '[') {
+                ++nesting;
+            } else if (ch == '}' || ch == ']') {
+                if (--nesting == 0) return true;
+            }
+        }
+        return fail();
+    }
+    // Number or literal
+    const char* start = pos;
+    while (pos < end && *pos != ',' && *pos != '}' && *pos != ']' &&
+           *pos != ' ' && *pos != '\n' && *pos != '\r' && *pos != '\t') {
+        ++pos;
+    }
+    return pos != start ? true : fail();
+}
+
+bool JsonCursor::readRaw(std::string_view& out) {
+    if (failed) return false;
+    skipWhitespace();
+    const char* start = pos;
+    if (!skipValue()) return false;
+    out = std::string_view(start, static_cast<size_t>(pos - start));
+    return true;
+}
+
+static bool decodeParams(JsonCursor& cur, DeribitMessage& out) {
+    std::string_view key;
+    if (!cur.beginObject()) return false;
+    while (cur.nextMember(key)) {
+        if (key == "channel") cur.readString(out.channel);
+        else if (key == "data") cur.readRaw(out.data);
+        else if (key == "type") cur.readString(out.heartbeatType);
+        else cur.skipValue();
+    }
+    return cur.ok();
+}
+
+static bool decodeError(JsonCursor& cur, DeribitMessage& out) {
+    std::string_view key;
+    if (!cur.beginObject()) return false;
+    while (cur.nextMember(key)) {
+        if (key == "code") cur.readInt(out.errorCode);
+        else if (key == "message") cur.readString(out.errorMessage);
+        else cur.skipValue();
+    }
+    return cur.ok();
+}
+
+bool decodeMessage(std::string_view payload, DeribitMessage& out) {
+    out = DeribitMessage{};
+    JsonCursor cur(payload);
+    bool hasResult = false;
+    bool hasError = false;
+
+    std::string_view key;
+    if (!cur.beginObject()) return false;
+    while (cur.nextMember(key)) {
+        if (key == "id") {
+            char c = cur.peek();
+            if (c == '-' || (c >= '0' && c <= '9')) out.hasId = cur.readInt(out.id);
+            else cur.skipValue();
+        } else if (key == "result") {
+            hasResult = cur.readRaw(out.result);
+        } else if (key == "error") {
+            hasError = decodeError(cur, out);
+        } else if (key == "method") {
+            cur.readString(out.method);
+        } else if (key == "params") {
+            decodeParams(cur, out);
+        } else if (key == "usIn") {
+            cur.readInt(out.usIn);
+        } else if (key == "usOut") {
+            cur.readInt(out.usOut);
+        } else {
+            cur.skipValue();
+        }
+    }
+    if (!cur.ok()) return false;
+
+    if (hasError) out.kind = MessageKind::Error;
+    else if (hasResult) out.kind = MessageKind::Result;
+    else if (out.method == "subscription") out.kind = MessageKind::Subscription;
+    else if (out.method == "heartbeat") out.kind = MessageKind::Heartbeat;
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<string_view>
+
+// Forward-only pull parser over a JSON buffer. Nothing is copied or allocated:
+// strings come back as views into the buffer (escape sequences are left as-is,
+// which is fine for the identifiers and numbers Deribit sends us) and numbers
+// are converted in place with std::from_chars.
+//
+// Objects are walked with   if (cur.beginObject()) while (cur.nextMember(key)) { read or skipValue(); }
+// arrays with               if (cur.beginArray())  while (cur.nextElement())  { read or skipValue(); }
+// Every member/element value must be consumed before asking for the next one.
+class JsonCursor {
+private:
+    static constexpr int MaxDepth = 64;
+
+    const char* pos;
+    const char* end;
+    bool failed = false;
+    int depth = 0;
+    bool first[MaxDepth];               // No member/element read yet at this nesting level
+
+    void skipWhitespace();
+    bool fail() { failed = true; return false; }
+    bool push();
+    bool skipString();
+
+public:
+    explicit JsonCursor(std::string_view json);
+
+    // Next significant character, or '\0' at the end of input
+    char peek();
+
+    bool beginObject();
+    bool nextMember(std::string_view& key);
+    bool beginArray();
+    bool nextElement();
+
+    bool readString(std::string_view& out);
+    bool readDouble(double& out);
+    bool readInt(int64_t& out);
+    // Decimal number scaled to FixedScale exactly, without a trip through double
+    bool readFixed(int64_t& out);
+    bool readBool(bool& out);
+    bool readNull();
+
+    // Skip over the next value without decoding it
+    bool skipValue();
+    // Skip over the next value and return its raw JSON text
+    bool readRaw(std::string_view& out);
+
+    bool ok() const { return !failed; }
+};
+
+// Shapes of the messages we get from the Deribit JSON-RPC websocket
+enum class MessageKind {
+    Unknown,
+    Result,              // {"id":..,"result":..}
+    Error,               // {"id":..,"error":{"code":..,"message":..}}
+    Subscription,        // {"method":"subscription","params":{"channel":..,"data":..}}
+    Heartbeat            // {"method":"heartbeat","params":{"type":..}}
+};
+
+// Top-level fields of one message. All views point into the payload buffer and
+// are only valid while it is alive. Nested values are kept as raw JSON so the
+// consumer can walk them with a JsonCursor.
+struct DeribitMessage {
+    MessageKind kind = MessageKind::Unknown;
+    bool hasId = false;
+    int64_t id = 0;
+    std::string_view method;
+    std::string_view channel;            // params.channel
+    std::string_view data;               // params.data (raw JSON)
+    std::string_view heartbeatType;      // params.type
+    std::string_view result;             // result (raw JSON)
+    int64_t errorCode = 0;
+    std::string_view errorMessage;
+    int64_t usIn = 0;                    // Exchange receive time (us)
+    int64_t usOut = 0;                   // Exchange send time (us)
+};
+
+// Decode the top level of a payload in a single pass. Returns false on malformed JSON.
+bool decodeMessage(std::string_view payload, DeribitMessage& out);
@@ -0,0 +1,152 @@
+#include "MessagePipeline.h"
+#include "Logger.h"
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+constexpr int SpinLimit = 20000;                 // Idle polls before the dispatcher parks
+constexpr size_t ClassifyWindow = 96;            // Bytes looked at to pick a lane
+
+// Single-writer counters: a plain load/store pair is enough and avoids a locked RMW
+inline void addTo(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+inline void maxInto(std::atomic<uint64_t>& counter, uint64_t value) {
+    if (value > counter.load(std::memory_order_relaxed)) counter.store(value, std::memory_order_relaxed);
+}
+}
+
+MessagePipeline::MessagePipeline(Dispatch dispatchFn, size_t laneCapacity)
+    : dispatch(std::move(dispatchFn)), controlLane(laneCapacity), marketLane(laneCapacity) {}
+
+MessagePipeline::~MessagePipeline() {
+    stop();
+}
+
+int64_t MessagePipeline::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool MessagePipeline::isMarketData(std::string_view payload) {
+    // Notifications start {"jsonrpc":"2.0","method":"subscription","params":{"channel":"...
+    // user.* channels carry our own orders and trades, so they stay on the control lane.
+    std::string_view head = payload.substr(0, ClassifyWindow);
+    return head.find("\"subscription\"") != std::string_view::npos &&
+           head.find("\"channel\":\"user.") == std::string_view::npos;
+}
+
+void MessagePipeline::start(int pinCpu) {
+    if (running.exchange(true)) return;
+    worker = std::thread(&MessagePipeline::run, this, pinCpu);
+}
+
+void MessagePipeline::stop() {
+    if (!running.exchange(false)) return;
+    wake();
+    if (worker.joinable()) worker.join();
+}
+
+void MessagePipeline::wake() {
+    std::lock_guard<std::mutex> lock(parkMutex);
+    parkCv.notify_one();
+}
+
+void MessagePipeline::push(InboundFrame&& frame) {
+    SpscRing<InboundFrame>& lane = isMarketData(frame.payload) ? marketLane : controlLane;
+    while (!lane.push(std::move(frame))) {
+        // Dispatcher is behind: back off rather than drop an order ack
+        producerStalls.fetch_add(1, std::memory_order_relaxed);
+        wake();
+        std::this_thread::yield();
+    }
+    received.store(received.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    size_t depth = lane.size();
+    if (depth > highWater.load(std::memory_order_relaxed)) highWater.store(depth, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (parked.load(std::memory_order_relaxed)) wake();
+}
+
+void MessagePipeline::flush() {
+    if (!running.load()) return;
+    uint64_t target = received.load(std::memory_order_acquire);
+    while (dispatched.load(std::memory_order_acquire) < target) {
+        wake();
+        std::this_thread::yield();
+    }
+}
+
+bool MessagePipeline::drainOne(InboundFrame& frame) {
+    if (!controlLane.pop(frame) && !marketLane.pop(frame)) return false;
+
+    int64_t start = nowNs();
+    dispatch(frame);
+    int64_t end = nowNs();
+
+    uint64_t queued = static_cast<uint64_t>(start - frame.rxNs);
+    uint64_t took = static_cast<uint64_t>(end - start);
+    addTo(totalQueueNs, queued);
+    maxInto(maxQueueNs, queued);
+    addTo(totalDispatchNs, took);
+    maxInto(maxDispatchNs, took);
+    dispatched.store(dispatched.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+}
+
+void MessagePipeline::run(int pinCpu) {
+    logger().setThreadName("dispatch");
+    if (pinCpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(pinCpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            LOG_WARN("Could not pin dispatcher to CPU {}", pinCpu);
+        }
+    }
+
+    InboundFrame frame;
+    int idle = 0;
+    while (true) {
+        if (drainOne(frame)) {
+            idle = 0;
+            continue;
+        }
+        if (!running.load(std::memory_order_acquire)) {
+            if (controlLane.empty() && marketLane.empty()) break;
+            continue;
+        }
+        if (++idle < SpinLimit) {
+            continue;
+        }
+
+        // Quiet feed: park until the I/O thread pushes (or a short timeout)
+        std::unique_lock<std::mutex> lock(parkMutex);
+        parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (controlLane.empty() && marketLane.empty() && running.load()) {
+            parkCv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        parked.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+}
+
+PipelineStats MessagePipeline::stats() const {
+    PipelineStats s;
+    s.controlDepth = controlLane.size();
+    s.marketDepth = marketLane.size();
+    s.highWater = highWater.load(std::memory_order_relaxed);
+    s.received = received.load(std::memory_order_acquire);
+    s.dispatched = dispatched.load(std::memory_order_acquire);
+    s.producerStalls = producerStalls.load(std::memory_order_relaxed);
+    if (s.dispatched > 0) {
+        s.avgQueueNs = static_cast<double>(totalQueueNs.load(std::memory_order_relaxed)) / s.dispatched;
+        s.avgDispatchNs = static_cast<double>(totalDispatchNs.load(std::memory_order_relaxed)) / s.dispatched;
+    }
+    s.maxQueueNs = maxQueueNs.load(std::memory_order_relaxed);
+    s.maxDispatchNs = maxDispatchNs.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include<atomic>
+#include<condition_variable>
+#include<cstdint>
+#include<functional>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<thread>
+#include "SpscRing.h"
+
+// One websocket frame handed from the I/O thread to the dispatcher
+struct InboundFrame {
+    std::string payload;
+    int64_t rxNs = 0;            // steady_clock time the I/O thread received it
+};
+
+// Snapshot of pipeline counters
+struct PipelineStats {
+    size_t controlDepth = 0;        // Frames waiting in the control lane
+    size_t marketDepth = 0;         // Frames waiting in the market data lane
+    size_t highWater = 0;           // Deepest either lane has been
+    uint64_t received = 0;
+    uint64_t dispatched = 0;
+    uint64_t producerStalls = 0;    // Times the I/O thread found a lane full
+    double avgQueueNs = 0;          // Receive -> dequeue
+    uint64_t maxQueueNs = 0;
+    double avgDispatchNs = 0;       // Decode + handlers
+    uint64_t maxDispatchNs = 0;
+};
+
+// Two-stage receive pipeline.
+//
+// The websocket I/O thread only classifies each frame and moves its payload
+// into one of two SPSC rings: a control lane (RPC results, errors, heartbeats)
+// and a market data lane (subscription notifications). A dedicated dispatcher
+// thread, optionally pinned to a core, drains the control lane first so order
+// acknowledgements never queue behind ticker/book bursts, and runs the
+// dispatch callback for every frame. The I/O thread never decodes or prints,
+// so socket reads keep up with the feed.
+class MessagePipeline {
+public:
+    using Dispatch = std::function<void(InboundFrame&)>;
+
+    explicit MessagePipeline(Dispatch dispatch, size_t laneCapacity = 65536);
+    ~MessagePipeline();
+
+    // Start the dispatcher thread; pinCpu < 0 leaves it unpinned
+    void start(int pinCpu = -1);
+    // Drain what is queued and join the dispatcher
+    void stop();
+
+    // I/O thread: queue a frame. Blocks (spinning) only if a lane is full.
+    void push(InboundFrame&& frame);
+
+    // Wait until every frame pushed so far has been dispatched
+    void flush();
+
+    PipelineStats stats() const;
+
+    static int64_t nowNs();
+
+private:
+    Dispatch dispatch;
+    SpscRing<InboundFrame> controlLane;
+    SpscRing<InboundFrame> marketLane;
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    // Dispatcher parks here after spinning idle for a while
+    std::mutex parkMutex;
+    std::condition_variable parkCv;
+    std::atomic<bool> parked{false};
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> dispatched{0};
+    std::atomic<uint64_t> producerStalls{0};
+    std::atomic<size_t> highWater{0};
+    std::atomic<uint64_t> totalQueueNs{0};
+    std::atomic<uint64_t> maxQueueNs{0};
+    std::atomic<uint64_t> totalDispatchNs{0};
+    std::atomic<uint64_t> maxDispatchNs{0};
+
+    static bool isMarketData(std::string_view payload);
+    void run(int pinCpu);
+    bool drainOne(InboundFrame& frame);
+    void wake();
+};
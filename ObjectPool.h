@@ -0,0 +1,127 @@
+#pragma once
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<type_traits>
+#include<vector>
+
+// Allocator counters of one pool
+struct PoolStats {
+    uint32_t chunks = 0;
+    uint32_t capacity = 0;      // Slots in allocated chunks
+    uint32_t live = 0;          // Slots handed out and not yet released
+    uint32_t highWater = 0;     // Slots ever handed out (free list + live)
+    uint64_t acquired = 0;
+    uint64_t recycled = 0;      // Acquires served from the free list
+    uint64_t released = 0;
+
+    // Share of touched slots sitting on the free list
+    double fragmentation() const {
+        return highWater == 0 ? 0.0 : static_cast<double>(highWater - live) / highWater;
+    }
+};
+
+// Slab pool of trivially copyable records addressed by a 32-bit index.
+//
+// Slots live in fixed-size chunks that are never moved or freed, so a record's
+// address is stable for the pool's lifetime. Released slots go on a free list
+// and are handed out again before the pool touches a fresh slot; a chunk is
+// only allocated when both run out, so a session whose working set has peaked
+// never calls malloc again. Copy-assignment reuses the target's chunks and only
+// copies the touched prefix, which keeps republishing a snapshot cheap.
+template <typename T, uint32_t ChunkSize = 1024>
+class ObjectPool {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "Pooled records are copied as raw bytes");
+
+    std::vector<std::unique_ptr<T[]>> chunks;
+    std::vector<uint32_t> freeList;
+    uint32_t highWater = 0;
+    uint32_t live = 0;
+    uint64_t acquiredCount = 0;
+    uint64_t recycledCount = 0;
+    uint64_t releasedCount = 0;
+
+    void addChunk() {
+        chunks.emplace_back(new T[ChunkSize]);
+        freeList.reserve(chunks.size() * ChunkSize); // release() never allocates
+    }
+
+public:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool& other) { *this = other; }
+
+    ObjectPool& operator=(const ObjectPool& other) {
+        if (this == &other) return *this;
+        while (chunks.size() < other.chunks.size()) addChunk();
+        for (uint32_t base = 0, chunk = 0; base < other.highWater; base += ChunkSize, ++chunk) {
+            uint32_t count = std::min(ChunkSize, other.highWater - base);
+            std::memcpy(chunks[chunk].get(), other.chunks[chunk].get(), count * sizeof(T));
+        }
+        freeList = other.freeList;
+        highWater = other.highWater;
+        live = other.live;
+        acquiredCount = other.acquiredCount;
+        recycledCount = other.recycledCount;
+        releasedCount = other.releasedCount;
+        return *this;
+    }
+
+    // Keep a copy of source up to date piecewise: its counters (and room for its slots),
+    // then each changed record with copyRecord. The free list isn't copied, so a pool
+    // kept this way is for reading only until it is assigned in full again.
+    void copyCounters(const ObjectPool& source) {
+        while (chunks.size() < source.chunks.size()) addChunk();
+        highWater = source.highWater;
+        live = source.live;
+        acquiredCount = source.acquiredCount;
+        recycledCount = source.recycledCount;
+        releasedCount = source.releasedCount;
+    }
+    void copyRecord(const ObjectPool& source, uint32_t index) { std::memcpy(&(*this)[index], &source[index], sizeof(T)); }
+
+    // Index of a default-initialised record
+    uint32_t acquire() {
+        uint32_t index;
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+            ++recycledCount;
+        } else {
+            if (highWater == chunks.size() * ChunkSize) addChunk();
+            index = highWater++;
+        }
+        ++live;
+        ++acquiredCount;
+        (*this)[index] = T{};
+        return index;
+    }
+
+    void release(uint32_t index) {
+        freeList.push_back(index);
+        --live;
+        ++releasedCount;
+    }
+
+    T& operator[](uint32_t index) { return chunks[index / ChunkSize][index % ChunkSize]; }
+    const T& operator[](uint32_t index) const { return chunks[index / ChunkSize][index % ChunkSize]; }
+
+    // Slots [0, touched()) have been handed out at least once
+    uint32_t touched() const { return highWater; }
+    uint32_t size() const { return live; }
+
+    PoolStats stats() const {
+        PoolStats s;
+        s.chunks = static_cast<uint32_t>(chunks.size());
+        s.capacity = s.chunks * ChunkSize;
+        s.live = live;
+        s.highWater = highWater;
+        s.acquired = acquiredCount;
+        s.recycled = recycledCount;
+        s.released = releasedCount;
+        return s;
+    }
+};
@@ -1,5 +1,5 @@
 #include "Order.h"
-#include<iostream>
+#include<fstream>
 #include<stdexcept>
 #include "types.hpp"
 
@@ -7,7 +7,6 @@ Order Order::fromSimpleString(const std::string& input){
      std::vector<std::string> tokens = tokenize(input, ' ');
 
         if (tokens.size() < 8) {
-            std::cerr << "Invalid input string.\n";
             throw std::invalid_argument("Insufficient parameters in input.");
         }
 
@@ -21,8 +20,9 @@ Order Order::fromSimpleString(const std::string& input){
         else throw std::invalid_argument("Invalid instrument type.");
 
         std::string side = tokens[3];
+        parseOrderSide(side);   // Throws for anything but buy/sell
         std::string orderType = tokens[4];
-        int amount = std::stod(tokens[5]);
+        double amount = std::stod(tokens[5]);
         std::optional<double> price = tokens[6] == "0" ? std::optional<double>{} : std::stod(tokens[6]);
         std::string label = tokens[7];
 
@@ -40,6 +40,36 @@ Order Order::fromSimpleString(const std::string& input){
         );
 }
 
+std::vector<Order> Order::fromFile(const std::string& path, std::vector<std::string>& errors) {
+    std::vector<Order> orders;
+    std::ifstream file(path);
+    if (!file) {
+        errors.push_back("Could not open " + path);
+        return orders;
+    }
+
+    std::string line, normalized;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        // Commas and tabs separate fields too; runs of separators count as one
+        normalized.clear();
+        for (char c : line) {
+            if (c == ',' || c == '\t' || c == '\r') c = ' ';
+            if (c == ' ' && (normalized.empty() || normalized.back() == ' ')) continue;
+            normalized.push_back(c);
+        }
+        if (!normalized.empty() && normalized.back() == ' ') normalized.pop_back();
+        if (normalized.empty() || normalized[0] == '#') continue;
+        if (normalized.compare(0, 3, "id ") == 0 || normalized.compare(0, 9, "order_id ") == 0) continue; // CSV header
+
+        try {
+            orders.push_back(fromSimpleString(normalized));
+        } catch (const std::exception& e) {
+            errors.push_back("line " + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+    return orders;
+}
+
      std::vector<std::string> Order::tokenize(const std::string& str, char delimiter) {
         std::vector<std::string> tokens;
         std::istringstream stream(str);
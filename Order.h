@@ -46,6 +46,11 @@ Order(
 
     static Order fromSimpleString(const std::string& input);
 
+    // One order per line in fromSimpleString's format; commas also separate fields, so a CSV
+    // export loads as is. Blank lines, # comments and an "id,..." header are skipped. Lines that
+    // do not parse are left out and reported in errors as "line N: reason".
+    static std::vector<Order> fromFile(const std::string& path, std::vector<std::string>& errors);
+
     const std::string& getInstrumentName() const { return instrumentName; }
     double getAmount() const { return amount; }
     const std::optional<double>& getPrice() const { return price; }
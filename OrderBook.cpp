@@ -0,0 +1,107 @@
+#include "OrderBook.h"
+#include <algorithm>
+
+OrderBook::OrderBook(const std::string& instrument, size_t reserveLevels)
+    : instrumentName(instrument) {
+    bids.reserve(reserveLevels);
+    asks.reserve(reserveLevels);
+}
+
+void OrderBook::beginSnapshot(int64_t newChangeId, int64_t newTimestamp) {
+    bids.clear();
+    asks.clear();
+    changeId = newChangeId;
+    timestamp = newTimestamp;
+    inSnapshot = true;
+    resyncRequestedMs = 0;
+}
+
+bool OrderBook::beginChange(int64_t newChangeId, int64_t prevChangeId, int64_t newTimestamp) {
+    if (!synced || prevChangeId != changeId) {
+        invalidate();
+        return false;
+    }
+    changeId = newChangeId;
+    timestamp = newTimestamp;
+    return true;
+}
+
+void OrderBook::applyLevel(BookSide side, BookAction action, Price price, Qty amount) {
+    std::vector<BookLevel>& book = levels(side);
+
+    // Snapshot levels are appended as they come and sorted once in endUpdate()
+    if (inSnapshot) {
+        if (action != BookAction::Delete && amount.raw > 0) {
+            book.push_back({price, amount});
+        }
+        return;
+    }
+
+    // Bids are ascending, asks descending, so the touch is always at the back
+    auto it = side == BookSide::Bid
+        ? std::lower_bound(book.begin(), book.end(), price,
+                           [](const BookLevel& level, Price p) { return level.price < p; })
+        : std::lower_bound(book.begin(), book.end(), price,
+                           [](const BookLevel& level, Price p) { return level.price > p; });
+    bool found = it != book.end() && it->price == price;
+
+    if (action == BookAction::Delete || amount.raw <= 0) {
+        if (found) book.erase(it);
+    } else if (found) {
+        it->amount = amount;
+    } else {
+        book.insert(it, {price, amount});
+    }
+}
+
+void OrderBook::endUpdate() {
+    if (inSnapshot) {
+        std::sort(bids.begin(), bids.end(),
+                  [](const BookLevel& a, const BookLevel& b) { return a.price < b.price; });
+        std::sort(asks.begin(), asks.end(),
+                  [](const BookLevel& a, const BookLevel& b) { return a.price > b.price; });
+        inSnapshot = false;
+        synced = true;
+    }
+}
+
+bool OrderBook::claimResync(int64_t nowMs) {
+    if (resyncRequestedMs != 0 && nowMs - resyncRequestedMs < ResyncRetryMs) return false;
+    resyncRequestedMs = nowMs > 0 ? nowMs : 1;
+    return true;
+}
+
+void OrderBook::invalidate() {
+    bids.clear();
+    asks.clear();
+    synced = false;
+    inSnapshot = false;
+}
+
+std::optional<Price> OrderBook::spread() const {
+    if (bids.empty() || asks.empty()) return std::nullopt;
+    return asks.back().price - bids.back().price;
+}
+
+std::optional<Price> OrderBook::mid() const {
+    if (bids.empty() || asks.empty()) return std::nullopt;
+    return Price::fromRaw((asks.back().price.raw + bids.back().price.raw) / 2);
+}
+
+size_t OrderBook::copyTop(const std::vector<BookLevel>& side, BookLevel* out, size_t depth) {
+    size_t count = std::min(depth, side.size());
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = side[side.size() - 1 - i];
+    }
+    return count;
+}
+
+void OrderBook::getTop(size_t depth, BookTop& out) const {
+    out.bids.resize(std::min(depth, bids.size()));
+    out.asks.resize(std::min(depth, asks.size()));
+    copyTop(bids, out.bids.data(), out.bids.size());
+    copyTop(asks, out.asks.data(), out.asks.size());
+    out.changeId = changeId;
+    out.timestamp = timestamp;
+    out.synced = synced;
+}
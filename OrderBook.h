@@ -0,0 +1,101 @@
+#pragma once
+#include<cstdint>
+#include<optional>
+#include<string>
+#include<vector>
+#include "FixedPoint.h"
+
+// Aggregated price level
+struct BookLevel {
+    Price price;                // Level price
+    Qty amount;                 // Total amount resting at this price
+};
+
+enum class BookSide {
+    Bid,
+    Ask
+};
+
+// Deribit level actions: ["new"|"change"|"delete", price, amount]
+enum class BookAction {
+    New,
+    Change,
+    Delete
+};
+
+// Top-N copy of a book, best level first
+struct BookTop {
+    std::vector<BookLevel> bids;
+    std::vector<BookLevel> asks;
+    int64_t changeId = 0;
+    int64_t timestamp = 0;
+    bool synced = false;
+};
+
+// Local L2 book for a single instrument, kept in sync from book.* notifications.
+//
+// Each side is a flat vector sorted so that the best price sits at the back
+// (bids ascending, asks descending). Best bid/ask is O(1), top-N is O(N), and
+// most updates land near the touch so inserts/erases only shift a few levels.
+// Capacity is reserved up front, so updates do not allocate in steady state.
+// Levels are fixed-point, so locating a price is an exact integer compare.
+class OrderBook {
+private:
+    std::string instrumentName;
+    std::vector<BookLevel> bids;       // Ascending, best bid at back()
+    std::vector<BookLevel> asks;       // Descending, best ask at back()
+    int64_t changeId = 0;              // change_id of the last applied update
+    int64_t timestamp = 0;             // Exchange timestamp of the last update (ms)
+    bool synced = false;               // False until a snapshot arrives or after a gap
+    bool inSnapshot = false;           // Levels are being appended unsorted
+    int64_t resyncRequestedMs = 0;     // Exchange time a fresh snapshot was asked for after a gap; 0 if none
+
+    std::vector<BookLevel>& levels(BookSide side) { return side == BookSide::Bid ? bids : asks; }
+    static size_t copyTop(const std::vector<BookLevel>& side, BookLevel* out, size_t depth);
+
+public:
+    explicit OrderBook(const std::string& instrument = "", size_t reserveLevels = 1024);
+
+    // Start a full snapshot: clears both sides
+    void beginSnapshot(int64_t newChangeId, int64_t newTimestamp);
+
+    // Start an incremental update. Returns false (and marks the book unsynced)
+    // when prevChangeId does not follow the last applied change_id.
+    bool beginChange(int64_t newChangeId, int64_t prevChangeId, int64_t newTimestamp);
+
+    void applyLevel(BookSide side, BookAction action, Price price, Qty amount);
+
+    // Finish the current snapshot/change
+    void endUpdate();
+
+    // Drop all levels and wait for the next snapshot
+    void invalidate();
+
+    // The book is out of sync at exchange time nowMs: true if a fresh snapshot should be
+    // requested. Once per gap, so the changes that keep arriving meanwhile don't each ask
+    // again; a request still unanswered after ResyncRetryMs may go out once more.
+    static constexpr int64_t ResyncRetryMs = 5000;
+    bool claimResync(int64_t nowMs);
+
+    const std::string& getInstrumentName() const { return instrumentName; }
+    bool isSynced() const { return synced; }
+    int64_t getChangeId() const { return changeId; }
+    int64_t getTimestamp() const { return timestamp; }
+    size_t bidDepth() const { return bids.size(); }
+    size_t askDepth() const { return asks.size(); }
+
+    const BookLevel* bestBid() const { return bids.empty() ? nullptr : &bids.back(); }
+    const BookLevel* bestAsk() const { return asks.empty() ? nullptr : &asks.back(); }
+    std::optional<Price> spread() const;
+    std::optional<Price> mid() const;      // Truncated to 1e-8
+
+    // Every level of a side in place, best at back(): for analytics that walk the book without copying it
+    const std::vector<BookLevel>& sideLevels(BookSide which) const { return which == BookSide::Bid ? bids : asks; }
+
+    // Copy up to depth levels, best first. Returns the number written.
+    size_t topBids(BookLevel* out, size_t depth) const { return copyTop(bids, out, depth); }
+    size_t topAsks(BookLevel* out, size_t depth) const { return copyTop(asks, out, depth); }
+
+    // Fill out with the top depth levels of each side (reuses out's capacity)
+    void getTop(size_t depth, BookTop& out) const;
+};
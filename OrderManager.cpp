@@ -1,287 +1,1828 @@
 #include "OrderManager.h"
+#include "MessagePipeline.h"
+#include "Logger.h"
+#include <algorithm>
+#include <unordered_set>
 
 OrderManager::OrderManager(client *clientPtr, websocketpp::connection_hdl hdl)
-    : wsClient(clientPtr), wsHandle(hdl) {}
+    : wsClient(clientPtr), wsHandle(hdl), connected(!hdl.expired()), risk(instruments.capacity()) {}
 
-bool OrderManager::placeOrder(const Order &order)
+OrderManager::~OrderManager()
 {
+    detachConnection();
+    if (subscriptions)
+    {
+        subscriptions->clearHandlers();
+    }
+}
+
+void OrderManager::attachConnection(client *clientPtr, websocketpp::connection_hdl hdl)
+{
+    std::lock_guard<std::mutex> lock(sendMutex);
+    wsClient = clientPtr;
+    wsHandle = hdl;
+    connected = true;
+}
+
+void OrderManager::detachConnection()
+{
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        wsHandle.reset();
+        connected = false;
+    }
+    // The subscriptions outlive this connection; stop them sending through it
+    if (subscriptions)
+    {
+        subscriptions->detach();
+    }
+    // Nobody will answer these any more
+    RpcResult closed;
+    closed.errorMessage = "Connection closed";
+    requests.drain([&](PendingRequest &pending)
+                   { completeRequest(pending, closed); });
+}
+
+static std::future<RpcResult> readyResult(const std::string &errorMessage)
+{
+    std::promise<RpcResult> promise;
+    RpcResult result;
+    result.errorMessage = errorMessage;
+    promise.set_value(result);
+    return promise.get_future();
+}
+
+bool OrderManager::trackRequest(int64_t id, PendingRequest &&pending, RpcCallback &&onComplete, std::future<RpcResult> &result)
+{
+    std::promise<RpcResult> promise;
+    result = promise.get_future();
+    pending.promise = std::move(promise);
+    pending.callback = std::move(onComplete);
+    if (!requests.insert(id, std::move(pending)))
+    {
+        RpcResult full;
+        full.errorMessage = "Too many requests in flight";
+        completeRequest(pending, full);
+        return false;
+    }
+    return true;
+}
+
+void OrderManager::completeRequest(PendingRequest &pending, const RpcResult &result)
+{
+    if (!result.ok && pending.kind == RequestKind::InstrumentInfo)
+    {
+        instruments.releaseSpecRequest(pending.order->instrument); // Fetch again on the next order
+    }
+    if (pending.kind == RequestKind::Buy || pending.kind == RequestKind::Sell)
+    {
+        risk.release(*pending.order); // Acknowledged orders count from the store (and hold from it) from here on
+    }
+    if (pending.callback)
+    {
+        pending.callback(result);
+    }
+    if (pending.promise)
+    {
+        pending.promise->set_value(result);
+        pending.promise.reset();
+    }
+}
+
+// Price sent with a placed order, if it has one
+static std::optional<Price> limitPrice(const CompactOrder &order)
+{
+    return order.hasPrice() ? std::optional<Price>(Price::fromRaw(order.price)) : std::nullopt;
+}
+
+RiskReject OrderManager::checkRisk(const CompactOrder &order)
+{
+    PositionsSnapshot positions = publishedPositions.read();
+    const Position *position = positions->find(order.instrument);
+    OrdersSnapshot resting = publishedOrders.read();
+    return risk.admit(order, position ? position->size : Qty(), resting->countIn(order.instrument), isInverse(order.instrument));
+}
+
+static int64_t unfilledAmount(const CompactOrder &order)
+{
+    return order.amount > order.filledAmount ? order.amount - order.filledAmount : 0;
+}
+
+void OrderManager::moveHold(const CompactOrder &before, const CompactOrder *after)
+{
+    // Take the new hold first, so a concurrent check never sees less than either
+    if (after)
+        risk.hold(after->instrument, after->side, unfilledAmount(*after));
+    risk.hold(before.instrument, before.side, -unfilledAmount(before));
+}
+
+void OrderManager::haltTrading(bool on)
+{
+    if (risk.isHalted() != on)
+    {
+        LOG_WARN("Kill switch {}: new orders and edits are {}", on ? "on" : "off", on ? "rejected" : "allowed again");
+    }
+    risk.halt(on);
+}
+
+bool OrderManager::setRiskLimits(const std::string &instrument, const RiskLimits &limits)
+{
+    InstrumentId instrumentId = instruments.intern(instrument);
+    if (instrumentId == NoInstrument)
+    {
+        return false;
+    }
+    risk.setLimits(instrumentId, limits);
+    return true;
+}
+
+std::future<RpcResult> OrderManager::placeOrder(const Order &order, RpcCallback onComplete)
+{
+    int64_t startNs = latency ? MessagePipeline::nowNs() : 0;
     if (orderExists(order.id))
     {
-        std::cerr << "Order with ID " << order.id << " already exists.\n";
+        LOG_WARN("Order with ID {} already exists", order.id);
+        return readyResult("Order with ID " + order.id + " already exists");
+    }
+
+    CompactOrder compact;
+    std::string rejected;
+    if (!toCompact(order, compact, rejected) || !roundToSpec(compact, rejected))
+    {
+        return readyResult(rejected);
+    }
+    RiskReject verdict = checkRisk(compact);
+    if (verdict != RiskReject::None)
+    {
+        LOG_WARN("Order {} stopped by risk checks: {}", order.id, riskRejectText(verdict));
+        return readyResult(riskRejectText(verdict));
+    }
+
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = compact.side == OrderSide::Buy ? RequestKind::Buy : RequestKind::Sell;
+    pending.order = compact; // Stored under the exchange order id once acknowledged
+    pending.times.startNs = startNs;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        std::string_view request = encoder.order(id, compact.side == OrderSide::Buy, order.instrumentName, Qty::fromRaw(compact.amount),
+                                                 order.type, limitPrice(compact), order.label ? std::string_view(*order.label) : std::string_view());
+        int64_t encodedNs = latency ? MessagePipeline::nowNs() : 0;
+        sent = sendApiRequest(request);
+        if (sent && latency)
+        {
+            stampSent(id, encodedNs);
+        }
+        LOG_DEBUG("Sent {}", request);
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+std::vector<std::future<RpcResult>> OrderManager::placeOrders(const std::vector<Order> &batch, RpcCallback onEach)
+{
+    int64_t startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::vector<std::future<RpcResult>> results;
+    results.reserve(batch.size());
+    std::vector<int64_t> ids(batch.size(), 0); // 0: not sent
+    std::vector<CompactOrder> compacts(batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const Order &order = batch[i];
+        if (orderExists(order.id))
+        {
+            results.push_back(readyResult("Order with ID " + order.id + " already exists"));
+            continue;
+        }
+        std::string rejected;
+        if (!toCompact(order, compacts[i], rejected) || !roundToSpec(compacts[i], rejected))
+        {
+            results.push_back(readyResult(rejected));
+            continue;
+        }
+        RiskReject verdict = checkRisk(compacts[i]);
+        if (verdict != RiskReject::None)
+        {
+            LOG_WARN("Order {} stopped by risk checks: {}", order.id, riskRejectText(verdict));
+            results.push_back(readyResult(riskRejectText(verdict)));
+            continue;
+        }
+        int64_t id = requests.nextId();
+        PendingRequest pending;
+        pending.kind = compacts[i].side == OrderSide::Buy ? RequestKind::Buy : RequestKind::Sell;
+        pending.order = compacts[i];
+        pending.times.startNs = startNs;
+        results.emplace_back();
+        // Not tracked (the request table is full): already answered, and not sent
+        if (trackRequest(id, std::move(pending), RpcCallback(onEach), results.back()))
+        {
+            ids[i] = id;
+        }
+    }
+
+    std::vector<int64_t> sent, unsent;
+    sent.reserve(batch.size());
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        encoder.beginBatch();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            if (!ids[i])
+                continue;
+            const Order &order = batch[i];
+            encoder.order(ids[i], compacts[i].side == OrderSide::Buy, order.instrumentName, Qty::fromRaw(compacts[i].amount),
+                          order.type, limitPrice(compacts[i]), order.label ? std::string_view(*order.label) : std::string_view());
+            sent.push_back(ids[i]);
+        }
+        encoder.endBatch();
+        unsent = sendBatch(sent, latency ? MessagePipeline::nowNs() : 0);
+    }
+    for (int64_t id : unsent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return results;
+}
+
+std::vector<std::future<RpcResult>> OrderManager::cancelOrders(const std::vector<std::string> &orderIds, RpcCallback onEach)
+{
+    int64_t startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::vector<std::future<RpcResult>> results;
+    results.reserve(orderIds.size());
+    std::vector<int64_t> ids;
+    ids.reserve(orderIds.size());
+    for (size_t i = 0; i < orderIds.size(); ++i)
+    {
+        int64_t id = requests.nextId();
+        PendingRequest pending;
+        pending.kind = RequestKind::Cancel;
+        pending.times.startNs = startNs;
+        results.emplace_back();
+        bool tracked = trackRequest(id, std::move(pending), RpcCallback(onEach), results.back());
+        ids.push_back(tracked ? id : 0);
+    }
+
+    std::vector<int64_t> sent, unsent;
+    sent.reserve(ids.size());
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        encoder.beginBatch();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (!ids[i])
+                continue;
+            encoder.cancel(ids[i], orderIds[i]);
+            sent.push_back(ids[i]);
+        }
+        encoder.endBatch();
+        unsent = sendBatch(sent, latency ? MessagePipeline::nowNs() : 0);
+    }
+    for (int64_t id : unsent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return results;
+}
+
+std::vector<std::future<RpcResult>> OrderManager::modifyOrders(const std::vector<OrderEdit> &edits, RpcCallback onEach)
+{
+    int64_t startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::vector<std::future<RpcResult>> results;
+    results.reserve(edits.size());
+    std::vector<int64_t> ids;
+    ids.reserve(edits.size());
+    std::vector<Price> prices(edits.size());
+    std::vector<Qty> amounts(edits.size());
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        prices[i] = Price::fromDouble(edits[i].price.value_or(0.0));
+        amounts[i] = Qty::fromDouble(edits[i].amount.value_or(0.0));
+        std::string rejected;
+        if (risk.isHalted())
+        {
+            results.push_back(readyResult(riskRejectText(RiskReject::Halted)));
+            ids.push_back(0);
+            continue;
+        }
+        if (!roundEdit(edits[i].orderId, prices[i], amounts[i], rejected))
+        {
+            results.push_back(readyResult(rejected));
+            ids.push_back(0);
+            continue;
+        }
+        int64_t id = requests.nextId();
+        PendingRequest pending;
+        pending.kind = RequestKind::Edit;
+        pending.times.startNs = startNs;
+        results.emplace_back();
+        bool tracked = trackRequest(id, std::move(pending), RpcCallback(onEach), results.back());
+        ids.push_back(tracked ? id : 0);
+    }
+
+    std::vector<int64_t> sent, unsent;
+    sent.reserve(ids.size());
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        encoder.beginBatch();
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (!ids[i])
+                continue;
+            const OrderEdit &edit = edits[i];
+            encoder.edit(ids[i], edit.orderId, amounts[i], prices[i], std::string_view(), edit.postOnly, edit.reduceOnly);
+            sent.push_back(ids[i]);
+        }
+        encoder.endBatch();
+        unsent = sendBatch(sent, latency ? MessagePipeline::nowNs() : 0);
+    }
+    for (int64_t id : unsent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return results;
+}
+
+std::vector<int64_t> OrderManager::sendBatch(const std::vector<int64_t> &ids, int64_t encodedNs)
+{
+    // websocketpp queues each frame and writes everything queued in one gathered write
+    std::vector<int64_t> unsent;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        if (!sendApiRequest(encoder.batchRequest(i)))
+        {
+            unsent.push_back(ids[i]);
+        }
+        else if (latency)
+        {
+            stampSent(ids[i], encodedNs);
+        }
+    }
+    return unsent;
+}
+
+std::future<RpcResult> OrderManager::cancelAllByInstrument(const std::string &instrument, RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::CancelByInstrument;
+    pending.order = CompactOrder();
+    pending.order->instrument = instruments.find(instrument);
+    pending.times.startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.instrument(id, "private/cancel_all_by_instrument", instrument));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+std::future<RpcResult> OrderManager::cancelByLabel(const std::string &label, RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::CancelByLabel;
+    pending.order = CompactOrder();
+    pending.order->label = labels.find(label);
+    pending.times.startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.cancelByLabel(id, label));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+void OrderManager::eraseCancelled(const PendingRequest &pending)
+{
+    const CompactOrder &filter = *pending.order;
+    bool byInstrument = pending.kind == RequestKind::CancelByInstrument;
+    // Never seen locally: nothing of ours to forget
+    if (byInstrument ? filter.instrument == NoInstrument : filter.label == StringInterner::None)
+    {
+        return;
+    }
+    std::vector<OrderId> cancelled;
+    orders.forEach([&](const CompactOrder &order)
+                   {
+        if (byInstrument ? order.instrument == filter.instrument : order.label == filter.label)
+            cancelled.push_back(order.id); });
+    for (const OrderId &orderId : cancelled)
+    {
+        moveHold(*orders.find(orderId), nullptr);
+        orders.erase(orderId);
+    }
+}
+
+bool OrderManager::toCompact(const Order &order, CompactOrder &compact, std::string &rejected)
+{
+    // Anything but "buy"/"sell" is a mistake, not a sell
+    try
+    {
+        compact.side = parseOrderSide(order.side);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        rejected = e.what();
+        return false;
+    }
+    compact.instrument = instruments.intern(order.instrumentName);
+    if (compact.instrument == NoInstrument)
+    {
+        rejected = "Instrument registry is full";
+        return false;
+    }
+    compact.id.assign(order.id);
+    compact.type = order.type;
+    compact.instrumentType = order.instrumentType;
+    compact.amount = toFixed(order.amount);
+    if (order.price)
+    {
+        compact.price = toFixed(*order.price);
+        compact.flags |= CompactOrder::HasPrice;
+    }
+    if (order.triggerPrice)
+    {
+        compact.triggerPrice = toFixed(*order.triggerPrice);
+        compact.flags |= CompactOrder::HasTriggerPrice;
+    }
+    if (order.trigger)
+    {
+        compact.trigger = parseTriggerType(*order.trigger);
+    }
+    if (order.label)
+    {
+        compact.label = labels.intern(*order.label);
+    }
+    return true;
+}
+
+bool OrderManager::roundToSpec(CompactOrder &order, std::string &rejected)
+{
+    InstrumentSpec spec;
+    if (!instruments.spec(order.instrument, spec))
+    {
+        if (instruments.claimSpecRequest(order.instrument))
+        {
+            getContractSize(std::string(instruments.name(order.instrument)));
+        }
+        return true;
+    }
+    if (spec.tickSize.raw > 0)
+    {
+        // Buys round down and sells up, so a limit never becomes more aggressive than asked
+        Rounding toward = order.side == OrderSide::Buy ? Rounding::Down : Rounding::Up;
+        if (order.hasPrice())
+            order.price = roundToStep(order.price, spec.tickSize.raw, toward);
+        if (order.hasTriggerPrice())
+            order.triggerPrice = roundToStep(order.triggerPrice, spec.tickSize.raw, Rounding::Nearest);
+    }
+    if (spec.minTradeAmount.raw > 0)
+    {
+        order.amount = roundToStep(order.amount, spec.minTradeAmount.raw, Rounding::Down);
+        if (order.amount < spec.minTradeAmount.raw)
+        {
+            rejected = "Amount is below the minimum trade amount of " + spec.minTradeAmount.toString() + " for " +
+                       std::string(instruments.name(order.instrument));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OrderManager::roundEdit(const std::string &orderId, Price &price, Qty &amount, std::string &rejected) const
+{
+    OrdersSnapshot snapshot = publishedOrders.read();
+    const CompactOrder *order = snapshot->find(OrderId(orderId));
+    InstrumentSpec spec;
+    if (!order || !instruments.spec(order->instrument, spec))
+    {
+        return true;
+    }
+    if (spec.tickSize.raw > 0)
+    {
+        price = price.rounded(spec.tickSize, order->side == OrderSide::Buy ? Rounding::Down : Rounding::Up);
+    }
+    if (spec.minTradeAmount.raw > 0)
+    {
+        amount = amount.rounded(spec.minTradeAmount, Rounding::Down);
+        if (amount < spec.minTradeAmount)
+        {
+            rejected = "Amount is below the minimum trade amount of " + spec.minTradeAmount.toString() + " for " +
+                       std::string(instruments.name(order->instrument));
+            return false;
+        }
+    }
+    return true;
+}
+
+Order OrderManager::toOrder(const CompactOrder &compact, const OrderStore &store) const
+{
+    Order order;
+    order.id.assign(compact.id.view());
+    order.instrumentName.assign(instruments.name(compact.instrument));
+    order.side = orderSideToString(compact.side);
+    order.instrumentType = compact.instrumentType;
+    order.type = compact.type;
+    order.amount = fromFixed(compact.amount);
+    if (compact.hasPrice())
+    {
+        order.price = fromFixed(compact.price);
+    }
+    if (compact.hasTriggerPrice())
+    {
+        order.triggerPrice = fromFixed(compact.triggerPrice);
+    }
+    if (compact.trigger != TriggerType::None)
+    {
+        order.trigger = std::string(triggerTypeToString(compact.trigger));
+    }
+    if (compact.label != StringInterner::None)
+    {
+        order.label = std::string(labels.name(compact.label));
+    }
+
+    // Fills are chained newest first; Order keeps them oldest first
+    store.forEachFill(compact, [&](const CompactFill &fill)
+                      {
+        Trade trade;
+        trade.tradeId.assign(fill.tradeId.view());
+        trade.price = fromFixed(fill.price);
+        trade.amount = fromFixed(fill.amount);
+        trade.fee = fromFixed(fill.fee);
+        trade.feeCurrency.assign(currencies.name(fill.feeCurrency));
+        trade.direction = orderSideToString(fill.side);
+        trade.timestamp = fill.timestamp;
+        order.trades.push_back(std::move(trade)); });
+    std::reverse(order.trades.begin(), order.trades.end());
+    return order;
+}
+
+bool OrderManager::sendApiRequest(std::string_view requestJson)
+{
+    if (capture)
+    {
+        capture->append(FrameDirection::Outbound, MessagePipeline::nowNs(), requestJson);
+    }
+    if (!wsClient)
+    {
+        return true; // Offline (benchmarks, replay): requests are encoded and tracked but go nowhere
+    }
+    if (!connected)
+    {
+        LOG_WARN("Not connected, request dropped");
+        return false;
+    }
+    websocketpp::lib::error_code ec;
+    wsClient->send(wsHandle, requestJson.data(), requestJson.size(), websocketpp::frame::opcode::text, ec);
+    if (ec)
+    {
+        LOG_ERROR("Failed to send API request: {}", ec.message());
+        return false;
+    }
+    return true;
+}
+
+void OrderManager::stampSent(int64_t id, int64_t encodedNs)
+{
+    int64_t sentNs = MessagePipeline::nowNs();
+    // A response that already arrived has taken the request; it goes unstamped
+    requests.update(id, [&](PendingRequest &pending)
+                    {
+        pending.times.encodedNs = encodedNs;
+        pending.times.sentNs = sentNs; });
+}
+
+void OrderManager::completeResponse(PendingRequest &pending, const RpcResult &result, const ReceiveTimes &received)
+{
+    if (latency && pending.kind != RequestKind::Other && pending.kind != RequestKind::InstrumentInfo &&
+        pending.kind != RequestKind::InstrumentList && pending.kind != RequestKind::OpenOrders &&
+        pending.kind != RequestKind::Positions)
+    {
+        latency->recordRequest(pending.times, received, MessagePipeline::nowNs());
+    }
+    completeRequest(pending, result);
+}
+
+void OrderManager::failRequest(int64_t id, const std::string &errorMessage)
+{
+    PendingRequest pending;
+    if (requests.take(id, pending))
+    {
+        RpcResult failed;
+        failed.errorMessage = errorMessage;
+        completeRequest(pending, failed);
+    }
+}
+
+std::future<RpcResult> OrderManager::cancelOrder(const std::string &orderId, RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::Cancel;
+    pending.times.startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        std::string_view request = encoder.cancel(id, orderId);
+        int64_t encodedNs = latency ? MessagePipeline::nowNs() : 0;
+        sent = sendApiRequest(request);
+        if (sent && latency)
+        {
+            stampSent(id, encodedNs);
+        }
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+std::future<RpcResult> OrderManager::modifyOrder(const std::string &orderId, const std::optional<double> &newPrice, const std::optional<double> &newAmount, std::string &advanced, bool &post_only, bool &reduce_only, RpcCallback onComplete)
+{
+    Price price = Price::fromDouble(newPrice.value_or(0.0));
+    Qty amount = Qty::fromDouble(newAmount.value_or(0.0));
+    if (risk.isHalted())
+    {
+        return readyResult(riskRejectText(RiskReject::Halted));
+    }
+    std::string rejected;
+    if (!roundEdit(orderId, price, amount, rejected))
+    {
+        return readyResult(rejected);
+    }
+
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::Edit;
+    pending.times.startNs = latency ? MessagePipeline::nowNs() : 0;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        std::string_view request = encoder.edit(id, orderId, amount, price, advanced, post_only, reduce_only);
+        int64_t encodedNs = latency ? MessagePipeline::nowNs() : 0;
+        sent = sendApiRequest(request);
+        if (sent && latency)
+        {
+            stampSent(id, encodedNs);
+        }
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+void OrderManager::setSubscriptions(SubscriptionManager *channels)
+{
+    // Called again on every reconnect. The handlers go in once: the dispatcher may be
+    // calling them while a new connection opens.
+    bool first = subscriptions != channels;
+    subscriptions = channels;
+    if (!subscriptions)
+        return;
+    if (first)
+    {
+        for (ChannelKind kind : {ChannelKind::Book, ChannelKind::Ticker, ChannelKind::Trades, ChannelKind::UserTrades})
+        {
+            subscriptions->setHandler(kind, [this, kind](ChannelId, const DeribitMessage &message)
+                                      { return routeNotification(kind, message); });
+        }
+    }
+    subscriptions->attach([this](std::string_view method, const std::vector<std::string_view> &names)
+                          {
+                              std::lock_guard<std::mutex> lock(sendMutex);
+                              return sendApiRequest(encoder.channels(requests.nextId(), method, names)); });
+}
+
+void OrderManager::unsubscribeAll()
+{
+    if (subscriptions)
+    {
+        subscriptions->removeAll();
+        subscriptions->flush();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.noParams(requests.nextId(), "public/unsubscribe_all"));
+}
+
+void OrderManager::unsubscribe(const std::string &channel)
+{
+    if (subscriptions)
+    {
+        // Only goes out when this was the channel's last consumer
+        if (subscriptions->remove(channel))
+            subscriptions->flush();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.channel(requests.nextId(), "public/unsubscribe", channel));
+}
+
+void OrderManager::publishOrders()
+{
+    // The spare snapshot takes only what changed since it was last current, so an ack
+    // costs the same with ten orders open as with tens of thousands
+    ordersDirty = !publishedOrders.publish([this](OrderStore &snapshot)
+                                           { snapshot.syncFrom(orders); });
+    markDirty(DirtyFlags::Orders);
+}
+
+std::optional<Order> OrderManager::getOrderById(const std::string &orderId) const
+{
+    OrdersSnapshot snapshot = publishedOrders.read();
+    const CompactOrder *order = snapshot->find(OrderId(orderId));
+    if (!order)
+    {
+        return std::nullopt;
+    }
+    return toOrder(*order, *snapshot);
+}
+
+std::vector<Order> OrderManager::getAllOrders() const
+{
+    OrdersSnapshot snapshot = publishedOrders.read();
+    std::vector<Order> allOrders;
+    allOrders.reserve(snapshot->size());
+    snapshot->forEach([&](const CompactOrder &order)
+                      { allOrders.push_back(toOrder(order, *snapshot)); });
+    return allOrders;
+}
+
+std::unordered_map<std::string, double> OrderManager::getCurrentPositions() const
+{
+    PositionsSnapshot snapshot = publishedPositions.read();
+    std::unordered_map<std::string, double> positions;
+    for (size_t slot = 0; slot < snapshot->size(); ++slot)
+    {
+        positions[std::string(instruments.name(snapshot->instrumentAt(slot)))] = snapshot->positionAt(slot).size.toDouble();
+    }
+    return positions;
+}
+
+std::optional<Position> OrderManager::getPosition(const std::string &instrument) const
+{
+    PositionsSnapshot snapshot = publishedPositions.read();
+    const Position *position = snapshot->find(instruments.find(instrument));
+    if (!position)
+    {
+        return std::nullopt;
+    }
+    return *position;
+}
+
+bool OrderManager::processApiResponse(const std::string &response)
+{
+    DeribitMessage message;
+    if (!decodeMessage(response, message))
+    {
+        LOG_ERROR("JSON parsing error: malformed response");
+        return false;
+    }
+    return processApiResponse(message);
+}
+
+// Fields of result.order we care about, as views into the payload
+struct OrderUpdateFields
+{
+    std::string_view orderId;
+    std::string_view direction;
+    std::string_view label;
+    std::string_view orderType;
+    std::string_view orderState;
+    std::string_view instrument;
+    int64_t averagePrice = 0; // Fixed-point
+    int64_t amount = 0;
+    int64_t price = 0;        // Limit price; market orders have none
+    int64_t filledAmount = 0;
+    bool hasPrice = false;
+};
+
+static bool isTerminalState(std::string_view orderState)
+{
+    return orderState == "filled" || orderState == "cancelled" || orderState == "rejected";
+}
+
+static bool decodeOrderFields(std::string_view json, OrderUpdateFields &fields)
+{
+    JsonCursor cur(json);
+    std::string_view key;
+    if (!cur.beginObject())
+        return false;
+    while (cur.nextMember(key))
+    {
+        if (cur.peek() == 'n')
+            cur.readNull(); // Absent label, average_price on untouched orders, ...
+        else if (key == "order_id")
+            cur.readString(fields.orderId);
+        else if (key == "average_price")
+            cur.readFixed(fields.averagePrice);
+        else if (key == "amount")
+            cur.readFixed(fields.amount);
+        else if (key == "price" && cur.peek() != '"')
+            fields.hasPrice = cur.readFixed(fields.price); // "market_price" on market orders
+        else if (key == "filled_amount")
+            cur.readFixed(fields.filledAmount);
+        else if (key == "instrument_name")
+            cur.readString(fields.instrument);
+        else if (key == "direction")
+            cur.readString(fields.direction);
+        else if (key == "label")
+            cur.readString(fields.label);
+        else if (key == "order_type")
+            cur.readString(fields.orderType);
+        else if (key == "order_state")
+            cur.readString(fields.orderState);
+        else
+            cur.skipValue();
+    }
+    return cur.ok();
+}
+
+// Fields of one trade, as views into the payload
+struct TradeFields
+{
+    std::string_view tradeId;
+    std::string_view instrument;
+    std::string_view direction;
+    std::string_view feeCurrency;
+    Price price;
+    Qty amount;
+    int64_t fee = 0; // Fixed-point
+    int64_t timestamp = 0;
+    int64_t tradeSeq = -1;
+};
+
+static bool decodeTrade(JsonCursor &cur, TradeFields &trade)
+{
+    std::string_view key;
+    if (!cur.beginObject())
+        return false;
+    while (cur.nextMember(key))
+    {
+        if (key == "trade_id")
+            cur.readString(trade.tradeId);
+        else if (key == "fee_currency")
+            cur.readString(trade.feeCurrency);
+        else if (key == "direction")
+            cur.readString(trade.direction);
+        else if (key == "price")
+            cur.readFixed(trade.price.raw);
+        else if (key == "amount")
+            cur.readFixed(trade.amount.raw);
+        else if (key == "fee")
+            cur.readFixed(trade.fee);
+        else if (key == "timestamp")
+            cur.readInt(trade.timestamp);
+        else if (key == "instrument_name")
+            cur.readString(trade.instrument);
+        else if (key == "trade_seq")
+            cur.readInt(trade.tradeSeq);
+        else
+            cur.skipValue();
+    }
+    return cur.ok();
+}
+
+static InstrumentType parseInstrumentKind(std::string_view kind)
+{
+    if (kind == "option" || kind == "option_combo")
+        return InstrumentType::Options;
+    if (kind == "spot")
+        return InstrumentType::Spot;
+    return InstrumentType::Futures;
+}
+
+// One instrument object of a public/get_instrument(s) result. False if it lacks
+// the tick size or minimum trade amount orders are rounded to.
+static bool decodeInstrumentSpec(JsonCursor &cur, std::string_view &name, InstrumentSpec &spec)
+{
+    std::string_view key, text;
+    bool hasTick = false, hasMinimum = false;
+    if (!cur.beginObject())
+        return false;
+    while (cur.nextMember(key))
+    {
+        if (cur.peek() == 'n')
+            cur.readNull(); // strike and option_type of non-options, ...
+        else if (key == "instrument_name")
+            cur.readString(name);
+        else if (key == "tick_size")
+            hasTick = cur.readFixed(spec.tickSize.raw);
+        else if (key == "contract_size")
+            cur.readFixed(spec.contractSize.raw);
+        else if (key == "min_trade_amount")
+            hasMinimum = cur.readFixed(spec.minTradeAmount.raw);
+        else if (key == "strike")
+            cur.readFixed(spec.strike.raw);
+        else if (key == "expiration_timestamp")
+            cur.readInt(spec.expirationMs);
+        else if (key == "kind" && cur.readString(text))
+            spec.kind = parseInstrumentKind(text);
+        else if (key == "option_type" && cur.readString(text))
+            spec.optionKind = text == "call" ? OptionKind::Call : text == "put" ? OptionKind::Put : OptionKind::None;
+        else if (key == "instrument_type" && cur.readString(text))
+            spec.inverse = text == "reversed";
+        else
+            cur.skipValue();
+    }
+    return cur.ok() && hasTick && hasMinimum;
+}
+
+bool OrderManager::processApiResponse(const DeribitMessage &message, const ReceiveTimes &received)
+{
+    if (ordersDirty)
+    {
+        publishOrders();
+    }
+
+    // Match the response to the request that caused it
+    PendingRequest pending;
+    bool tracked = message.hasId && requests.take(message.id, pending);
+
+    if (message.kind == MessageKind::Error)
+    {
+        if (tracked)
+        {
+            RpcResult failed;
+            failed.errorCode = message.errorCode;
+            failed.errorMessage.assign(message.errorMessage);
+            completeResponse(pending, failed, received);
+        }
+        return false;
+    }
+    if (message.kind != MessageKind::Result)
+    {
+        return false;
+    }
+
+    RpcResult result;
+    result.ok = true;
+
+    // Mass cancels answer the number of orders cancelled
+    if (tracked && (pending.kind == RequestKind::CancelByInstrument || pending.kind == RequestKind::CancelByLabel))
+    {
+        JsonCursor count(message.result);
+        count.readInt(result.cancelledCount);
+        eraseCancelled(pending);
+        publishOrders();
+        completeResponse(pending, result, received);
+        return true;
+    }
+
+    if (tracked && pending.kind == RequestKind::InstrumentInfo)
+    {
+        JsonCursor cur(message.result);
+        std::string_view name;
+        InstrumentSpec spec;
+        if (decodeInstrumentSpec(cur, name, spec))
+        {
+            instruments.setSpec(pending.order->instrument, spec);
+        }
+        else
+        {
+            result.ok = false;
+            result.errorMessage = "Instrument without tick size or minimum trade amount";
+        }
+        completeResponse(pending, result, received);
+        return result.ok;
+    }
+
+    if (tracked && pending.kind == RequestKind::InstrumentList)
+    {
+        JsonCursor cur(message.result);
+        if (cur.beginArray())
+        {
+            while (cur.nextElement())
+            {
+                std::string_view name;
+                InstrumentSpec spec;
+                if (!decodeInstrumentSpec(cur, name, spec))
+                    continue;
+                InstrumentId id = instruments.intern(name);
+                if (id == NoInstrument)
+                    continue;
+                instruments.setSpec(id, spec);
+                ++result.instrumentCount;
+            }
+        }
+        if (!cur.ok())
+        {
+            result.ok = false;
+            result.errorMessage = "Malformed instrument list";
+        }
+        completeResponse(pending, result, received);
+        return result.ok;
+    }
+
+    if (tracked && (pending.kind == RequestKind::OpenOrders || pending.kind == RequestKind::Positions))
+    {
+        bool wellFormed = pending.kind == RequestKind::OpenOrders
+                              ? reconcileOpenOrders(message.result, result.reconciledCount)
+                              : reconcilePositionList(message.result, result.reconciledCount);
+        if (!wellFormed)
+        {
+            result.ok = false;
+            result.errorMessage = pending.kind == RequestKind::OpenOrders ? "Malformed open orders" : "Malformed positions";
+        }
+        publishOrders();
+        publishPositions();
+        completeResponse(pending, result, received);
+        return result.ok;
+    }
+
+    // buy/sell/edit answer {"order":{..},"trades":[..]}, cancel answers the order itself.
+    // Results of other methods (arrays, scalars, other objects) carry no order.
+    std::string_view orderJson, tradesJson, key;
+    JsonCursor cur(message.result);
+    if (cur.peek() == '{')
+    {
+        cur.beginObject();
+        while (cur.nextMember(key))
+        {
+            if (key == "order")
+                cur.readRaw(orderJson);
+            else if (key == "trades")
+                cur.readRaw(tradesJson);
+            else if (key == "order_id" && orderJson.empty())
+            {
+                orderJson = message.result;
+                cur.skipValue();
+            }
+            else
+                cur.skipValue();
+        }
+    }
+    OrderUpdateFields fields;
+    if (!cur.ok() || orderJson.empty() || !decodeOrderFields(orderJson, fields))
+    {
+        if (tracked)
+            completeResponse(pending, result, received);
+        return false;
+    }
+    result.orderId.assign(fields.orderId);
+    result.orderState.assign(fields.orderState);
+
+    // A placed order becomes known under the id the exchange gave it. It holds nothing
+    // against the position limit of its own until then: its request does.
+    OrderId orderId(fields.orderId);
+    const CompactOrder *known = orders.find(orderId);
+    CompactOrder held = known ? *known : CompactOrder();
+    if (tracked && pending.order)
+    {
+        pending.order->id = orderId;
+        orders.insert(*pending.order);
+    }
+
+    CompactOrder *order = orders.find(orderId);
+
+    // Fills count towards positions even for orders from before this session
+    if (!tradesJson.empty())
+    {
+        applyTrades(tradesJson, order);
+    }
+    if (positionsDirty)
+    {
+        publishPositions();
+    }
+
+    if (!order)
+    {
+        if (tracked)
+            completeResponse(pending, result, received);
         return false;
     }
 
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", order.side == "buy" ? "private/buy" : "private/sell"},
-        {"params", {{"instrument_name", order.instrumentName}, {"amount", static_cast<int>(order.amount)}, {"type", "market"}, // Assuming limit orders; adjust as needed.
-                    {"label", order.label.value_or("")}}}};
-    std::cout << requestJson.dump(4) << std::endl;
-    sendApiRequest(requestJson.dump());
-    orders[order.id] = order; // Temporarily add the order before confirmation.
+    // Update existing order. average_price is 0 until something fills, so it never replaces the limit price.
+    if (fields.hasPrice)
+    {
+        order->price = fields.price;
+        order->flags |= CompactOrder::HasPrice;
+    }
+    order->averagePrice = fields.averagePrice;
+    order->amount = fields.amount;
+    if (!fields.direction.empty())
+    {
+        order->side = fields.direction == "buy" ? OrderSide::Buy : OrderSide::Sell;
+    }
+    order->label = fields.label.empty() ? StringInterner::None : labels.intern(fields.label);
+
+    LOG_DEBUG("Order {} updated with new trades", orderId.view());
+    // Orders that can no longer change give their slots (and their fills') back to the pools
+    bool closed = (tracked && pending.kind == RequestKind::Cancel) || isTerminalState(fields.orderState);
+    moveHold(held, closed ? nullptr : order);
+    if (closed)
+    {
+        orders.erase(orderId);
+    }
+    publishOrders();
+    if (tracked)
+    {
+        completeResponse(pending, result, received);
+    }
     return true;
 }
 
-void OrderManager::sendApiRequest(const std::string &requestJson)
+void OrderManager::applyTrades(std::string_view tradesJson, CompactOrder *order)
 {
-    websocketpp::lib::error_code ec;
-    wsClient->send(wsHandle, requestJson, websocketpp::frame::opcode::text, ec);
-    if (ec)
+    JsonCursor trades(tradesJson);
+    if (!trades.beginArray())
+        return;
+    while (trades.nextElement())
     {
-        std::cerr << "Failed to send API request: " << ec.message() << std::endl;
+        TradeFields trade;
+        if (!decodeTrade(trades, trade))
+            break;
+        // The same fill arrives in the order ack and on user.trades; apply it once
+        InstrumentId instrument = instruments.intern(trade.instrument);
+        if (!ledger.applyTrade(instrument, trade.direction == "buy", trade.price, trade.amount,
+                               fromFixed(trade.fee), trade.feeCurrency, trade.tradeSeq, isInverse(instrument)))
+            continue;
+        positionsDirty = true;
+        tape.push(TradePrint{instrument, trade.price, trade.amount, trade.timestamp, trade.direction == "buy", true});
+        candles.addTrade(instrument, trade.instrument, trade.timestamp, trade.tradeSeq, trade.price, trade.amount);
+        markDirty(DirtyFlags::Trades);
+        if (!order)
+            continue;
+
+        CompactFill fill;
+        fill.tradeId.assign(trade.tradeId);
+        fill.price = trade.price.raw;
+        fill.amount = trade.amount.raw;
+        fill.fee = trade.fee;
+        fill.timestamp = trade.timestamp;
+        fill.tradeSeq = trade.tradeSeq;
+        fill.feeCurrency = currencies.intern(trade.feeCurrency);
+        fill.side = trade.direction == "buy" ? OrderSide::Buy : OrderSide::Sell;
+        orders.addFill(*order, fill);
     }
 }
 
-bool OrderManager::cancelOrder(const std::string &orderId)
+bool OrderManager::reconcileOpenOrders(std::string_view ordersJson, int64_t &changed)
 {
+    JsonCursor cur(ordersJson);
+    if (!cur.beginArray())
+        return false;
+    std::unordered_set<OrderId, ShortIdHash> listed;
+    while (cur.nextElement())
+    {
+        std::string_view orderJson;
+        OrderUpdateFields fields;
+        if (!cur.readRaw(orderJson) || !decodeOrderFields(orderJson, fields) || fields.orderId.empty())
+            continue;
+        OrderId orderId(fields.orderId);
+        listed.insert(orderId);
 
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "private/cancel"},
-        {"params", {{"order_id", orderId}}}};
+        CompactOrder *order = orders.find(orderId);
+        CompactOrder held = order ? *order : CompactOrder();
+        if (!order)
+        {
+            // Placed from another session, or its acknowledgement was lost with the connection
+            CompactOrder added;
+            added.id = orderId;
+            added.instrument = instruments.intern(fields.instrument);
+            if (added.instrument == NoInstrument)
+                continue;
+            InstrumentSpec spec;
+            if (instruments.spec(added.instrument, spec))
+                added.instrumentType = spec.kind;
+            try
+            {
+                added.type = stringToOrderType(std::string(fields.orderType));
+            }
+            catch (const std::invalid_argument &)
+            {
+                added.type = OrderType::limit;
+            }
+            order = &orders.insert(added);
+        }
+        else if (order->amount == fields.amount && order->filledAmount == fields.filledAmount &&
+                 (!fields.hasPrice || order->price == fields.price))
+        {
+            continue;
+        }
+        order->amount = fields.amount;
+        order->filledAmount = fields.filledAmount;
+        order->averagePrice = fields.averagePrice;
+        if (fields.hasPrice)
+        {
+            order->price = fields.price;
+            order->flags |= CompactOrder::HasPrice;
+        }
+        if (!fields.direction.empty())
+        {
+            order->side = fields.direction == "buy" ? OrderSide::Buy : OrderSide::Sell;
+        }
+        order->label = fields.label.empty() ? StringInterner::None : labels.intern(fields.label);
+        moveHold(held, order);
+        ++changed;
+    }
+    if (!cur.ok())
+        return false;
 
-    sendApiRequest(requestJson.dump());
+    // Anything we still hold that the exchange no longer lists was filled or cancelled meanwhile
+    std::vector<OrderId> closed;
+    orders.forEach([&](const CompactOrder &order)
+                   {
+        if (!listed.count(order.id))
+            closed.push_back(order.id); });
+    for (const OrderId &orderId : closed)
+    {
+        LOG_INFO("Order {} closed while disconnected", orderId.view());
+        moveHold(*orders.find(orderId), nullptr);
+        orders.erase(orderId);
+    }
+    changed += static_cast<int64_t>(closed.size());
     return true;
 }
-bool OrderManager::modifyOrder(const std::string &orderId, const std::optional<double> &newPrice, const std::optional<double> &newAmount, std::string &advanced, bool &post_only, bool &reduce_only)
+
+bool OrderManager::reconcilePositionList(std::string_view positionsJson, int64_t &changed)
 {
+    JsonCursor cur(positionsJson);
+    if (!cur.beginArray())
+        return false;
+    std::vector<bool> listed;
+    while (cur.nextElement())
+    {
+        std::string_view key, instrument;
+        Qty size;
+        Price averagePrice, markPrice;
+        if (!cur.beginObject())
+            return false;
+        while (cur.nextMember(key))
+        {
+            if (cur.peek() == 'n')
+                cur.readNull();
+            else if (key == "instrument_name")
+                cur.readString(instrument);
+            else if (key == "size")
+                cur.readFixed(size.raw);
+            else if (key == "average_price")
+                cur.readFixed(averagePrice.raw);
+            else if (key == "mark_price")
+                cur.readFixed(markPrice.raw);
+            else
+                cur.skipValue();
+        }
+        InstrumentId id = instruments.intern(instrument);
+        if (!cur.ok() || id == NoInstrument)
+            continue;
+        if (id >= listed.size())
+            listed.resize(id + 1);
+        listed[id] = true;
+
+        // Only a size we got wrong counts as a correction. With the size right the
+        // exchange's average entry is adopted quietly: it differs from ours in the
+        // last digits, and for inverse contracts in how the average is rounded.
+        const Position *position = ledger.find(id);
+        bool matches = position ? position->size == size : size.isZero();
+        if (!matches)
+        {
+            LOG_INFO("Position in {} corrected to {}", instrument, size.toString());
+            ++changed;
+        }
+        if (!matches || (position && !size.isZero() && position->avgEntryPrice != averagePrice))
+            ledger.setPosition(id, size, averagePrice, isInverse(id));
+        if (!markPrice.isZero())
+            ledger.mark(id, markPrice);
+    }
+    if (!cur.ok())
+        return false;
 
-    nlohmann::json editMsg = {
-        {"jsonrpc", "2.0"},
-        {"id", rand()},
-        {"method", "private/edit"},
-        {"params", {{"order_id", orderId}, {"amount", newAmount.value_or(0.0)}, // Use .value_or() to handle std::optional
-                    {"price", newPrice.value_or(0.0)},                          // Use .value_or() to handle std::optional
-                    {"advanced", advanced},
-                    {"post_only", post_only},
-                    {"reduce_only", reduce_only}}}};
-    sendApiRequest(editMsg.dump());
+    // Open positions the exchange no longer reports were closed meanwhile
+    for (size_t slot = 0; slot < ledger.size(); ++slot)
+    {
+        InstrumentId id = ledger.instrumentAt(slot);
+        if ((id < listed.size() && listed[id]) || ledger.positionAt(slot).size.isZero())
+            continue;
+        LOG_INFO("Position in {} closed while disconnected", instruments.name(id));
+        ledger.setPosition(id, Qty(), Price(), isInverse(id));
+        ++changed;
+    }
     return true;
 }
 
-void OrderManager::handleApiResponse(const std::string &response)
+void OrderManager::publishPositions()
 {
-    auto jsonResponse = nlohmann::json::parse(response);
+    positionsDirty = !publishedPositions.publish([this](PositionLedger &snapshot)
+                                                 { snapshot = ledger; });
+    markDirty(DirtyFlags::Positions);
+}
 
-    if (jsonResponse.contains("result"))
+// Mark price of a ticker notification, and its last traded price when it has one
+static bool decodeTickerMark(std::string_view data, std::string_view &instrument, Price &markPrice, Price &lastPrice,
+                             bool &hasLast)
+{
+    JsonCursor cur(data);
+    std::string_view key;
+    bool hasMark = false;
+    hasLast = false;
+    if (!cur.beginObject())
+        return false;
+    while (cur.nextMember(key))
     {
-        auto result = jsonResponse["result"];
-        if (result.contains("order"))
-        {
-            auto orderId = result["order"]["order_id"].get<std::string>();
-            if (orderExists(orderId))
-            {
-                Order &order = orders[orderId];
-                order.price = result["order"]["average_price"];
-                order.amount = result["order"]["amount"];
-                std::cout << "Order " << orderId << " updated successfully.\n";
-            }
-        }
+        if (key == "instrument_name")
+            cur.readString(instrument);
+        else if (key == "mark_price" && cur.peek() != 'n')
+            hasMark = cur.readFixed(markPrice.raw);
+        else if (key == "last_price" && cur.peek() != 'n')
+            hasLast = cur.readFixed(lastPrice.raw);
+        else
+            cur.skipValue();
     }
+    return cur.ok() && hasMark && !instrument.empty();
 }
 
-void OrderManager::unsubscribeAll()
+bool OrderManager::processSubscription(const DeribitMessage &message)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/unsubscribe_all"}};
-    sendApiRequest(requestJson.dump());
+    if (ordersDirty)
+    {
+        publishOrders();
+    }
+
+    if (positionsDirty)
+    {
+        publishPositions();
+    }
+
+    // The subscription table knows each channel's kind already; offline, work it out from the name
+    if (subscriptions)
+        return subscriptions->dispatch(message);
+    return routeNotification(classifyChannel(message.channel), message);
 }
 
-void OrderManager::unsubscribe(const std::string &channel)
+bool OrderManager::routeNotification(ChannelKind kind, const DeribitMessage &message)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/unsubscribe"},
-        {"params", {{"channels", {channel}}}}};
-    sendApiRequest(requestJson.dump());
+    switch (kind)
+    {
+    case ChannelKind::Book:
+        return processBookNotification(message.channel, message.data);
+    case ChannelKind::Ticker:
+        return processTickerNotification(message.data);
+    case ChannelKind::Trades:
+        return processTradesNotification(message.data);
+    case ChannelKind::UserTrades:
+        return processUserTradesNotification(message.data);
+    default:
+        return false;
+    }
 }
 
-std::optional<Order> OrderManager::getOrderById(const std::string &orderId) const
+bool OrderManager::processTickerNotification(std::string_view data)
 {
-    if (!orderExists(orderId))
+    std::string_view instrument;
+    Price markPrice, lastPrice;
+    bool hasLast;
+    if (!decodeTickerMark(data, instrument, markPrice, lastPrice, hasLast))
+        return false;
+    InstrumentId instrumentId = instruments.intern(instrument);
+    if (ledger.mark(instrumentId, markPrice))
     {
-        return std::nullopt;
+        publishPositions();
+    }
+    if (hasLast && instrumentId != NoInstrument)
+    {
+        prices.record(instrumentId, lastPrice.toDouble());
+        markDirty(DirtyFlags::Prices);
     }
-    return orders.at(orderId);
+    return true;
 }
-std::vector<Order> OrderManager::getAllOrders() const
+
+bool OrderManager::processUserTradesNotification(std::string_view data)
 {
-    std::vector<Order> allOrders;
-    for (const auto &pair : orders)
+    applyTrades(data, nullptr);
+    if (positionsDirty)
     {
-        allOrders.push_back(pair.second);
+        publishPositions();
     }
-    return allOrders;
+    return true;
 }
 
-std::unordered_map<std::string, double> OrderManager::getCurrentPositions() const
+bool OrderManager::processTradesNotification(std::string_view data)
 {
-    std::unordered_map<std::string, double> positions;
-    for (const auto &pair : orders)
+    JsonCursor trades(data);
+    if (!trades.beginArray())
+        return false;
+    size_t count = 0;
+    while (trades.nextElement())
     {
-        const Order &order = pair.second;
-        if (order.side == "buy")
-        {
-            positions[order.instrumentName] += order.amount;
-        }
-        else if (order.side == "sell")
+        TradeFields trade;
+        if (!decodeTrade(trades, trade))
+            return false;
+        InstrumentId instrument = instruments.intern(trade.instrument);
+        tape.push(TradePrint{instrument, trade.price, trade.amount, trade.timestamp, trade.direction == "buy", false});
+        prices.record(instrument, trade.price.toDouble());
+        candles.addTrade(instrument, trade.instrument, trade.timestamp, trade.tradeSeq, trade.price, trade.amount);
+        ++count;
+    }
+    if (count > 0)
+        markDirty(DirtyFlags::Trades | DirtyFlags::Prices);
+    return trades.ok();
+}
+
+// Apply one side of a book notification: [["new"|"change"|"delete", price, amount], ...]
+// or plain [[price, amount], ...] on grouped channels.
+static bool applyBookLevels(OrderBook &book, std::string_view levels, BookSide side)
+{
+    JsonCursor cur(levels);
+    if (!cur.beginArray())
+        return false;
+    while (cur.nextElement())
+    {
+        BookAction action = BookAction::New;
+        Price price;
+        Qty amount;
+        std::string_view actionStr;
+        if (!cur.beginArray() || !cur.nextElement())
+            return false;
+        if (cur.peek() == '"')
         {
-            positions[order.instrumentName] -= order.amount;
+            cur.readString(actionStr);
+            action = actionStr == "delete" ? BookAction::Delete
+                   : actionStr == "new"    ? BookAction::New
+                                           : BookAction::Change;
+            cur.nextElement();
         }
+        cur.readFixed(price.raw);
+        cur.nextElement();
+        cur.readFixed(amount.raw);
+        while (cur.nextElement())
+            cur.skipValue();
+        if (!cur.ok())
+            return false;
+        book.applyLevel(side, action, price, amount);
     }
-    return positions;
+    return cur.ok();
 }
 
-bool OrderManager::processApiResponse(const std::string &response)
+bool OrderManager::processBookNotification(std::string_view channel, std::string_view data)
 {
-    try
+    std::string_view instrument, type, bids, asks, key;
+    int64_t changeId = 0, prevChangeId = 0, timestamp = 0;
+    bool hasPrevChangeId = false;
+
+    JsonCursor cur(data);
+    if (!cur.beginObject())
+        return false;
+    while (cur.nextMember(key))
+    {
+        if (key == "instrument_name")
+            cur.readString(instrument);
+        else if (key == "type")
+            cur.readString(type);
+        else if (key == "change_id")
+            cur.readInt(changeId);
+        else if (key == "prev_change_id")
+            hasPrevChangeId = cur.readInt(prevChangeId);
+        else if (key == "timestamp")
+            cur.readInt(timestamp);
+        else if (key == "bids")
+            cur.readRaw(bids);
+        else if (key == "asks")
+            cur.readRaw(asks);
+        else
+            cur.skipValue();
+    }
+    if (!cur.ok() || instrument.empty())
+        return false;
+    InstrumentId instrumentId = instruments.intern(instrument);
+    if (instrumentId == NoInstrument)
+        return false;
+
+    std::lock_guard<std::mutex> lock(booksMutex);
+    if (instrumentId >= books.size())
+    {
+        books.resize(instrumentId + 1);
+    }
+    if (!books[instrumentId])
     {
-        auto jsonResponse = nlohmann::json::parse(response);
+        books[instrumentId] = std::make_unique<OrderBook>(std::string(instrument));
+    }
+    OrderBook &book = *books[instrumentId];
 
-        if (jsonResponse.contains("result"))
+    // book.{instrument}.{interval} sends a snapshot followed by changes chained by
+    // prev_change_id; grouped book channels send a full book every time.
+    if (hasPrevChangeId && type != "snapshot")
+    {
+        if (!book.beginChange(changeId, prevChangeId, timestamp))
         {
-            auto result = jsonResponse["result"];
-            if (result.contains("order"))
+            // Missed an update: resubscribe to get a fresh snapshot, once until it arrives
+            if (!book.claimResync(timestamp))
+                return false;
+            LOG_WARN("Order book gap on {}, resubscribing", instrument);
+            if (subscriptions)
             {
-                auto orderId = result["order"]["order_id"].get<std::string>();
-                auto orderIt = orders.find(orderId);
-                if (orderIt == orders.end())
-                {
-                    return false;
-                }
-                Order &order = orderIt->second;
-
-                // Handle null values gracefully
-                auto orderTypeStr = result["order"]["order_type"].get<std::string>();
-                OrderType orderType = stringToOrderType(orderTypeStr.empty() ? "limit" : orderTypeStr); // Default to "limit" if null
-
-                // Update existing order
-                order.price = result["order"]["average_price"].get<double>();
-                order.amount = result["order"]["amount"].get<double>();
-                order.side = result["order"]["direction"].get<std::string>();
-                order.label = result["order"]["label"].get<std::string>();
-
-                // Add trades to the order
-                if (result.contains("trades"))
-                {
-                    for (const auto &tradeJson : result["trades"])
-                    {
-                        Trade trade{
-                            tradeJson["trade_id"].get<std::string>(),
-                            tradeJson["price"].get<double>(),
-                            tradeJson["amount"].get<double>(),
-                            tradeJson["fee"].get<double>(),
-                            tradeJson["fee_currency"].get<std::string>(),
-                            tradeJson["direction"].get<std::string>(),
-                            tradeJson["timestamp"].get<int64_t>()};
-                        order.addTrade(trade);
-                    }
-                }
-
-                std::cout << "Order " << orderId << " updated with new trades.\n";
-                return true;
+                subscriptions->resubscribe(channel);
+                return false;
             }
+            std::lock_guard<std::mutex> sendLock(sendMutex);
+            sendApiRequest(encoder.channel(requests.nextId(), "public/unsubscribe", channel));
+            sendApiRequest(encoder.channel(requests.nextId(), "public/subscribe", channel));
+            return false;
         }
     }
-    catch (const nlohmann::json::exception &e)
+    else
+    {
+        book.beginSnapshot(changeId, timestamp);
+    }
+
+    if (!applyBookLevels(book, bids, BookSide::Bid) || !applyBookLevels(book, asks, BookSide::Ask))
+    {
+        book.invalidate();
+        return false;
+    }
+    book.endUpdate();
+    markDirty(DirtyFlags::Book);
+
+    std::optional<Price> mid = book.mid();
+    if (mid)
+    {
+        risk.setMid(instrumentId, *mid);
+    }
+    if (mid && ledger.mark(instrumentId, *mid))
+    {
+        publishPositions();
+    }
+    return true;
+}
+
+bool OrderManager::getBookTop(const std::string &instrument, size_t depth, BookTop &out) const
+{
+    InstrumentId instrumentId = instruments.find(instrument);
+    std::lock_guard<std::mutex> lock(booksMutex);
+    if (instrumentId >= books.size() || !books[instrumentId])
+    {
+        return false;
+    }
+    books[instrumentId]->getTop(depth, out);
+    return true;
+}
+
+bool OrderManager::getBookSignals(const std::string &instrument, size_t levels, double fillSize, BookSignals &out) const
+{
+    InstrumentId instrumentId = instruments.find(instrument);
+    std::lock_guard<std::mutex> lock(booksMutex);
+    if (instrumentId >= books.size() || !books[instrumentId])
+    {
+        return false;
+    }
+    out = BookAnalytics::compute(*books[instrumentId], levels, fillSize);
+    return true;
+}
+
+std::vector<std::string> OrderManager::getBookInstruments() const
+{
+    std::lock_guard<std::mutex> lock(booksMutex);
+    std::vector<std::string> names;
+    for (const std::unique_ptr<OrderBook> &book : books)
     {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
+        if (book)
+            names.push_back(book->getInstrumentName());
     }
-    return false;
+    std::sort(names.begin(), names.end());
+    return names;
 }
 
 void OrderManager::getOrderHistoryByCurrency(const std::string &currency)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "private/get_order_history_by_currency"},
-        {"params", {
-                       {"currency", currency}, {"count", 10} // Number of orders to retrieve
-                   }}};
-    sendApiRequest(requestJson.dump());
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.currency(requests.nextId(), "private/get_order_history_by_currency", currency, 10)); // Number of orders to retrieve
 }
 void OrderManager::getOrderHistoryByInstrument(const std::string &instrument)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "private/get_order_history_by_instrument"},
-        {"params", {
-                       {"instrument_name", instrument}, {"count", 10} // Number of orders to retrieve
-                   }}};
-    sendApiRequest(requestJson.dump());
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.instrument(requests.nextId(), "private/get_order_history_by_instrument", instrument, 10)); // Number of orders to retrieve
 }
 void OrderManager::streamMarketData(const std::string &channel)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/subscribe"},
-        {"params", {{"channels", {channel}}}}};
-    sendApiRequest(requestJson.dump());
+    subscribe(channel);
 }
 
 void OrderManager::getSummaryByInstrument(const std::string &instrument)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/get_book_summary_by_instrument"},
-        {"params", {{"instrument_name", instrument}}}};
-    sendApiRequest(requestJson.dump());
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.instrument(requests.nextId(), "public/get_book_summary_by_instrument", instrument));
 }
 
 void OrderManager::getSummaryByCurrency(const std::string &currency)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/get_book_summary_by_currency"},
-        {"params", {{"currency", currency}}}};
-    sendApiRequest(requestJson.dump());
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.currency(requests.nextId(), "public/get_book_summary_by_currency", currency));
 }
 
 void OrderManager::subscribe(const std::string &channel)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/subscribe"},
-        {"params", {{"channels", {channel}}}}};
-    sendApiRequest(requestJson.dump());
+    if (subscriptions)
+    {
+        subscriptions->add(channel);
+        subscriptions->flush();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.channel(requests.nextId(), "public/subscribe", channel));
+}
+
+void OrderManager::subscribe(const std::vector<std::string> &channels)
+{
+    if (subscriptions)
+    {
+        for (const std::string &channel : channels)
+            subscriptions->add(channel);
+        subscriptions->flush();
+        return;
+    }
+    for (const std::string &channel : channels)
+        subscribe(channel);
 }
 
 void OrderManager::getTickerData(const std::string &instrument)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/ticker"},
-        {"params", {{"instrument_name", instrument}}}};
-    sendApiRequest(requestJson.dump());
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.instrument(requests.nextId(), "public/ticker", instrument));
+}
+
+std::future<RpcResult> OrderManager::getContractSize(const std::string &instrument, RpcCallback onComplete)
+{
+    InstrumentId instrumentId = instruments.intern(instrument);
+    if (instrumentId == NoInstrument)
+    {
+        return readyResult("Instrument registry is full");
+    }
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::InstrumentInfo;
+    pending.order = CompactOrder();
+    pending.order->instrument = instrumentId;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.instrument(id, "public/get_instrument", instrument));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+std::future<RpcResult> OrderManager::loadInstruments(const std::string &currency, RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::InstrumentList;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.currency(id, "public/get_instruments", currency));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+std::future<RpcResult> OrderManager::enableCancelOnDisconnect(RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.scope(id, "private/enable_cancel_on_disconnect", "connection"));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
+}
+
+void OrderManager::setHeartbeat(int intervalSeconds)
+{
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.heartbeat(requests.nextId(), intervalSeconds));
+}
+
+int64_t OrderManager::sendTest()
+{
+    int64_t id = requests.nextId();
+    std::lock_guard<std::mutex> lock(sendMutex);
+    return sendApiRequest(encoder.noParams(id, "public/test")) ? id : 0;
+}
+
+std::future<RpcResult> OrderManager::reconcileOrders(RpcCallback onComplete)
+{
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::OpenOrders;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        // "any" lists every currency, so a local order missing from the answer is really gone
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.currency(id, "private/get_open_orders_by_currency", "any"));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
 }
 
-void OrderManager::getContractSize(const std::string &instrument)
+std::future<RpcResult> OrderManager::reconcilePositions(RpcCallback onComplete)
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/get_instrument"},
-        {"params", {{"instrument_name", instrument}}}};
-    sendApiRequest(requestJson.dump());
+    int64_t id = requests.nextId();
+    PendingRequest pending;
+    pending.kind = RequestKind::Positions;
+    std::future<RpcResult> result;
+    if (!trackRequest(id, std::move(pending), std::move(onComplete), result))
+    {
+        return result; // Not sent: nothing would take its answer
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        sent = sendApiRequest(encoder.currency(id, "private/get_positions", "any"));
+    }
+    if (!sent)
+    {
+        failRequest(id, "Failed to send request");
+    }
+    return result;
 }
 
 void OrderManager::getAllSupportedCurrencies()
 {
-    nlohmann::json requestJson = {
-        {"jsonrpc", "2.0"},
-        {"id", std::rand()},
-        {"method", "public/get_currencies"}};
-    sendApiRequest(requestJson.dump());
-}
\ No newline at end of file
+    std::lock_guard<std::mutex> lock(sendMutex);
+    sendApiRequest(encoder.noParams(requests.nextId(), "public/get_currencies"));
+}
@@ -1,42 +1,344 @@
-
+#pragma once
 #include <map>
+#include <functional>
+#include <future>
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <nlohmann/json.hpp>
+#include <memory>
+#include <mutex>
 #include "Order.h"
+#include "OrderStore.h"
+#include "OrderBook.h"
+#include "MessageDecoder.h"
+#include "RequestEncoder.h"
+#include "RequestTable.h"
+#include "SnapshotBuffer.h"
+#include "PositionLedger.h"
+#include "SubscriptionManager.h"
+#include "FrameLog.h"
+#include "LatencyStats.h"
+#include "DirtyFlags.h"
+#include "TradeTape.h"
+#include "PriceSeries.h"
+#include "CandleStore.h"
+#include "BookAnalytics.h"
+#include "RiskGate.h"
 #include "common.h"
+
+// Outcome of a tracked JSON-RPC request
+struct RpcResult
+{
+    bool ok = false;
+    int64_t errorCode = 0;
+    std::string errorMessage;
+    std::string orderId;    // Exchange order id (order methods)
+    std::string orderState; // open, filled, cancelled, ... (order methods)
+    int64_t cancelledCount = 0; // Orders the exchange cancelled (mass cancel methods)
+    int64_t instrumentCount = 0; // Instrument specs loaded (public/get_instruments)
+    int64_t reconciledCount = 0; // Local orders or positions corrected (reconcile methods)
+};
+
+using RpcCallback = std::function<void(const RpcResult &)>;
+
+enum class RequestKind
+{
+    Other,
+    Buy,
+    Sell,
+    Edit,
+    Cancel,
+    CancelByInstrument,
+    CancelByLabel,
+    InstrumentInfo,
+    InstrumentList,
+    OpenOrders,
+    Positions
+};
+
+// One entry of a modifyOrders batch
+struct OrderEdit
+{
+    std::string orderId;
+    std::optional<double> price;
+    std::optional<double> amount;
+    bool postOnly = false;
+    bool reduceOnly = false;
+};
+
+// What we need to remember about a request until its response arrives
+struct PendingRequest
+{
+    RequestKind kind = RequestKind::Other;
+    std::optional<CompactOrder> order;                // Order being placed (buy/sell); instrument/label filter of a mass cancel;
+                                                      // instrument of a get_instrument
+    std::optional<std::promise<RpcResult>> promise;
+    RpcCallback callback;
+    RequestTimes times;                               // Stage stamps, when latency is being recorded
+};
+
+using OrdersSnapshot = SnapshotBuffer<OrderStore>::Reader;
+using PositionsSnapshot = SnapshotBuffer<PositionLedger>::Reader;
+
 // OrderManager class
 class OrderManager
 {
 private:
-    std::unordered_map<std::string, Order> orders;
+    // Order state has a single writer, the dispatcher thread, which mutates `orders`
+    // and then publishes a copy; every other thread reads published snapshots.
+    OrderStore orders;
+    SnapshotBuffer<OrderStore> publishedOrders;
+    bool ordersDirty = false; // Changes not yet published (all spare snapshots were pinned)
+    std::vector<std::unique_ptr<OrderBook>> books;     // Local L2 books indexed by InstrumentId, created on first notification
+    mutable std::mutex booksMutex;                     // Books are written on the websocket thread, read by the menu
     client *wsClient;
     websocketpp::connection_hdl wsHandle;
+    bool connected;                                    // Guarded by sendMutex; a live manager without a connection fails its sends
 
     bool orderExists(const std::string &orderId) const
     {
-        return orders.find(orderId) != orders.end();
+        OrdersSnapshot snapshot = publishedOrders.read();
+        return snapshot->find(OrderId(orderId)) != nullptr;
+    }
+
+    // Names behind the ids in CompactOrder/CompactFill. Append-only, so readers
+    // of a snapshot can resolve them without locking.
+    InstrumentRegistry instruments;
+    StringInterner labels{4096};
+    StringInterner currencies{256};
+
+    // False (with the reason in rejected) for a side other than buy/sell or a full instrument registry
+    bool toCompact(const Order &order, CompactOrder &compact, std::string &rejected);
+
+    // Snap a new order's prices to the tick and its amount to the trade size of its
+    // instrument. False (with the reason in rejected) if the amount is below the minimum.
+    // Without a spec yet the order goes as given and the spec is fetched once.
+    bool roundToSpec(CompactOrder &order, std::string &rejected);
+    // Same for an edit of orderId, when the order and its instrument's spec are known
+    bool roundEdit(const std::string &orderId, Price &price, Qty &amount, std::string &rejected) const;
+
+    // Writer only: make the current `orders` visible to readers
+    void publishOrders();
+
+    // Positions follow the same single-writer/snapshot scheme as orders
+    PositionLedger ledger;
+    // Whether the instrument's spec says it is an inverse contract; linear until the spec is known
+    bool isInverse(InstrumentId instrument) const
+    {
+        InstrumentSpec spec;
+        return instruments.spec(instrument, spec) && spec.inverse;
+    }
+    SnapshotBuffer<PositionLedger> publishedPositions;
+    bool positionsDirty = false;
+
+    void publishPositions();
+    // Apply a JSON array of trades to the ledger (and to order, if given)
+    void applyTrades(std::string_view tradesJson, CompactOrder *order);
+
+    // Results of the reconcile methods; count what they corrected. False if malformed.
+    bool reconcileOpenOrders(std::string_view ordersJson, int64_t &changed);
+    bool reconcilePositionList(std::string_view positionsJson, int64_t &changed);
+
+    RequestEncoder encoder; // Per-connection request buffer
+    std::mutex sendMutex;   // Guards encoder from encode until the frame is handed to websocketpp
+
+    RequestTable<PendingRequest> requests; // In-flight requests awaiting a response, by JSON-RPC id
+
+    bool sendApiRequest(std::string_view requestJson);
+
+    FrameLogWriter *capture = nullptr; // Records every request sent, when capturing
+    LatencyStats *latency = nullptr;   // Order round trip stages, when measuring
+    SubscriptionManager *subscriptions = nullptr; // Channel set shared across connections, when attached
+    DirtyFlags *display = nullptr;     // Told which panels changed, when something is showing them
+    TradeTape tape;                    // Recent public trades and our fills
+    PriceHistory prices;               // Last traded prices per instrument, from ticker.* and trades.*
+    CandleStore candles;               // OHLCV bars per instrument, from trades.* and our fills
+    RiskGate risk;                     // Pre-trade limits and kill switch; mids from the local books
+
+    // Pre-trade checks of a new order against the published position and resting orders.
+    // On None the order is in flight until its request completes.
+    RiskReject checkRisk(const CompactOrder &order);
+    // Move a stored order's hold on the position limit from what it held as `before`
+    // to its unfilled amount now (nothing if after is null, the order is going away)
+    void moveHold(const CompactOrder &before, const CompactOrder *after);
+
+    void markDirty(uint32_t panels)
+    {
+        if (display)
+            display->mark(panels);
     }
 
-    void sendApiRequest(const std::string &requestJson);
+    // Stamp a tracked request as encoded at encodedNs and sent now
+    void stampSent(int64_t id, int64_t encodedNs);
+    // Send every request of the encoder's batch, ids[i] being the i-th request's id. Caller holds
+    // sendMutex. Returns the ids that could not be sent, for the caller to fail once it has let go.
+    std::vector<int64_t> sendBatch(const std::vector<int64_t> &ids, int64_t encodedNs);
+    // Forget local orders a mass cancel took out
+    void eraseCancelled(const PendingRequest &pending);
+    // completeRequest for a response, recording its round trip first
+    void completeResponse(PendingRequest &pending, const RpcResult &result, const ReceiveTimes &received);
+
+    // Register a request under id before it is sent; result completes on its response. False if the
+    // table is full: result has already failed and the request must not be sent.
+    bool trackRequest(int64_t id, PendingRequest &&pending, RpcCallback &&onComplete, std::future<RpcResult> &result);
+    void completeRequest(PendingRequest &pending, const RpcResult &result);
+    // Never with sendMutex held: the request's callback runs here and may send another
+    void failRequest(int64_t id, const std::string &errorMessage);
+
+    bool processBookNotification(std::string_view channel, std::string_view data);
+    bool processTickerNotification(std::string_view data);
+    bool processUserTradesNotification(std::string_view data);
+    bool processTradesNotification(std::string_view data);
+    // Hand a notification to the processor for its kind of channel
+    bool routeNotification(ChannelKind kind, const DeribitMessage &message);
 
 public:
+    // A null clientPtr runs offline: nothing is sent, responses are fed in by the caller
     OrderManager(client *clientPtr, websocketpp::connection_hdl hdl);
+    ~OrderManager();
+
+    // Orders, positions, books and subscriptions outlive connections. After a reconnect,
+    // attach the new connection, authenticate and reconcile; until then sends fail.
+    void attachConnection(client *clientPtr, websocketpp::connection_hdl hdl);
+    // The connection is gone: requests in flight fail now, new ones until the next attach
+    void detachConnection();
 
-    bool placeOrder(const Order &order);
+    // private/enable_cancel_on_disconnect for this connection: the exchange cancels
+    // our open orders when it drops, so nothing trades while we can't see it
+    std::future<RpcResult> enableCancelOnDisconnect(RpcCallback onComplete = nullptr);
 
-    bool cancelOrder(const std::string &orderId);
+    // public/set_heartbeat: the exchange sends a heartbeat every intervalSeconds (10 or more)
+    // and now and then a test_request, which must be answered with sendTest()
+    void setHeartbeat(int intervalSeconds);
 
-    bool modifyOrder(const std::string &orderId, const std::optional<double> &newPrice, const std::optional<double> &newAmount, std::string &advanced, bool &post_only, bool &reduce_only);
-    void handleApiResponse(const std::string &response);
+    // A fresh id for a request sent around the manager (public/auth). Its answer goes untracked,
+    // and no tracked request can be matched to it.
+    int64_t nextRequestId() { return requests.nextId(); }
+
+    // public/test, untracked. Returns its request id, or 0 if it could not be sent.
+    // Cheap enough to answer test_request straight from the I/O thread.
+    int64_t sendTest();
+
+    // Bring local state in line with the exchange without starting over.
+    // reconcileOrders: orders listed by private/get_open_orders_by_currency are added or
+    // updated, local orders it no longer lists were filled or cancelled meanwhile and are closed.
+    // reconcilePositions: sizes and entry prices are set to private/get_positions where
+    // they differ (fills missed while disconnected). Results carry reconciledCount.
+    std::future<RpcResult> reconcileOrders(RpcCallback onComplete = nullptr);
+    std::future<RpcResult> reconcilePositions(RpcCallback onComplete = nullptr);
+
+    // Order methods return as soon as the request is written; the future (and the
+    // optional callback, run on the websocket thread) completes with the exchange's answer.
+    std::future<RpcResult> placeOrder(const Order &order, RpcCallback onComplete = nullptr);
+
+    std::future<RpcResult> cancelOrder(const std::string &orderId, RpcCallback onComplete = nullptr);
+
+    std::future<RpcResult> modifyOrder(const std::string &orderId, const std::optional<double> &newPrice, const std::optional<double> &newAmount, std::string &advanced, bool &post_only, bool &reduce_only, RpcCallback onComplete = nullptr);
+
+    // Batches: all requests are encoded into one buffer and written back to back under a
+    // single lock, so the socket sees them coalesced. One future per entry, in order.
+    std::vector<std::future<RpcResult>> placeOrders(const std::vector<Order> &batch, RpcCallback onEach = nullptr);
+    std::vector<std::future<RpcResult>> cancelOrders(const std::vector<std::string> &orderIds, RpcCallback onEach = nullptr);
+    std::vector<std::future<RpcResult>> modifyOrders(const std::vector<OrderEdit> &edits, RpcCallback onEach = nullptr);
+
+    // private/cancel_all_by_instrument and private/cancel_by_label; the result carries cancelledCount
+    std::future<RpcResult> cancelAllByInstrument(const std::string &instrument, RpcCallback onComplete = nullptr);
+    std::future<RpcResult> cancelByLabel(const std::string &label, RpcCallback onComplete = nullptr);
+
+    // Number of requests still waiting for a response
+    size_t pendingRequestCount() const { return requests.size(); }
+
+    // Consistent, lock-free view of all orders and their fills, read in place (no copies);
+    // pins that version until released. Also carries the pools' allocator stats.
+    OrdersSnapshot getOrdersSnapshot() const { return publishedOrders.read(); }
+
+    // Full Order (with its trades) for display; hot paths should read the snapshot instead
+    Order toOrder(const CompactOrder &order, const OrderStore &store) const;
 
     std::optional<Order> getOrderById(const std::string &orderId) const;
 
     std::vector<Order> getAllOrders() const;
 
+    const InstrumentRegistry &getInstruments() const { return instruments; }
+
+    // Bulk-load the specs of every live instrument of currency ("any" for all) with
+    // public/get_instruments; the result carries instrumentCount
+    std::future<RpcResult> loadInstruments(const std::string &currency = "any", RpcCallback onComplete = nullptr);
+
+    // Instrument spec cache on disk: load before trading for a warm start, save after loadInstruments
+    size_t loadInstrumentCache(const std::string &path) { return instruments.loadSnapshot(path); }
+    bool saveInstrumentCache(const std::string &path) const { return instruments.saveSnapshot(path); }
+
+    // Net size per instrument
     std::unordered_map<std::string, double> getCurrentPositions() const;
 
+    // Size, average entry and PnL of one instrument, O(1)
+    std::optional<Position> getPosition(const std::string &instrument) const;
+
+    // Consistent, lock-free view of the whole ledger (positions and fees)
+    PositionsSnapshot getPositionsSnapshot() const { return publishedPositions.read(); }
+
     bool processApiResponse(const std::string &response);
+    // received carries the receive path's stamps for latency stats (optional)
+    bool processApiResponse(const DeribitMessage &message, const ReceiveTimes &received = ReceiveTimes());
+
+    // Route a "subscription" notification to its consumer
+    bool processSubscription(const DeribitMessage &message);
+
+    // Copy the top depth levels of an instrument's local book. False if no book is kept for it.
+    bool getBookTop(const std::string &instrument, size_t depth, BookTop &out) const;
+
+    // Imbalance, microprice, weighted mid/spread and prices to fill fillSize over the top levels
+    // of an instrument's local book, computed in place. False if no book is kept for it.
+    bool getBookSignals(const std::string &instrument, size_t levels, double fillSize, BookSignals &out) const;
+
+    // Instruments with a local book
+    std::vector<std::string> getBookInstruments() const;
+
+    // Up to count of the newest trades from trades.* and our own fills, newest first
+    void getRecentTrades(size_t count, std::vector<TradePrint> &out) const { tape.latest(count, out); }
+
+    // History of last traded prices of an instrument, for charts; null until it has one.
+    // The series stays valid for the manager's lifetime and keeps filling as prices arrive.
+    const PriceSeries *getPriceSeries(const std::string &instrument) const { return prices.find(instruments.find(instrument)); }
+
+    // Call fn(const CandleColumns &finished, const Candle *current) with an instrument's candles
+    // in timeframe, read in place under their lock. False if it has none yet.
+    template <typename Fn>
+    bool readCandles(const std::string &instrument, Timeframe timeframe, Fn &&fn) const
+    {
+        return candles.read(instruments.find(instrument), timeframe, std::forward<Fn>(fn));
+    }
+
+    // Keep finished candles in files under path, so the next run starts with them. Set before trading starts.
+    void setCandleDirectory(const std::string &path) { candles.setDirectory(path); }
+
+    // Limits every new order is checked against before it is sent: all instruments without
+    // limits of their own, or one instrument (false if the registry is full)
+    void setRiskLimits(const RiskLimits &limits) { risk.setDefaultLimits(limits); }
+    bool setRiskLimits(const std::string &instrument, const RiskLimits &limits);
+    RiskLimits getRiskLimits(const std::string &instrument) const { return risk.limits(instruments.find(instrument)); }
+
+    // Kill switch: while on, new orders and edits are rejected before they are sent.
+    // Orders already working are left alone; cancel them separately.
+    void haltTrading(bool on);
+    bool isTradingHalted() const { return risk.isHalted(); }
+    // Reject counts and orders in flight, for display
+    const RiskGate &getRiskGate() const { return risk; }
+
+    // Record outgoing requests to writer (null stops recording). Set before trading starts.
+    void setCapture(FrameLogWriter *writer) { capture = writer; }
+
+    // Record the stages of every order request's round trip into stats (null stops). Set before trading starts.
+    void setLatencyStats(LatencyStats *stats) { latency = stats; }
+
+    // Mark the panels whose data changed (book, orders, positions, trades) in flags, for a
+    // display that redraws on change (null stops). Set before trading starts.
+    void setDirtyFlags(DirtyFlags *flags) { display = flags; }
+
+    // Route subscribe/unsubscribe through channels and restore its subscriptions on this
+    // connection. Without one, each call sends its own request and nothing is restored.
+    void setSubscriptions(SubscriptionManager *channels);
 
     //  method: Get order history by currency
     void getOrderHistoryByCurrency(const std::string &currency);
@@ -56,8 +358,9 @@ public:
     //  method: Get ticker data
     void getTickerData(const std::string &instrument);
 
-    //  method: Get contract size
-    void getContractSize(const std::string &instrument);
+    //  method: Get contract size. Loads the instrument's tick size, contract size and
+    //  minimum trade amount into getInstruments() before the result completes.
+    std::future<RpcResult> getContractSize(const std::string &instrument, RpcCallback onComplete = nullptr);
 
     //  method: Get all supported currencies
     void getAllSupportedCurrencies();
@@ -65,6 +368,9 @@ public:
     //  method: Subscribe to a channel
     void subscribe(const std::string &channel);
 
+    // Subscribe to several channels at once (batched into as few requests as possible)
+    void subscribe(const std::vector<std::string> &channels);
+
     // New method: Unsubscribe from a channel
     void unsubscribe(const std::string &channel);
 
@@ -0,0 +1,146 @@
+#include "OrderStore.h"
+
+OrderStore::OrderStore() : buckets(1024, NoSlot), mask(1023) {}
+
+CompactOrder* OrderStore::find(const OrderId& id) {
+    for (size_t i = home(id); buckets[i] != NoSlot; i = (i + 1) & mask) {
+        if (orders[buckets[i]].id == id) {
+            record(Part::Order, buckets[i]);
+            return &orders[buckets[i]];
+        }
+    }
+    return nullptr;
+}
+
+const CompactOrder* OrderStore::find(const OrderId& id) const {
+    for (size_t i = home(id); buckets[i] != NoSlot; i = (i + 1) & mask) {
+        if (orders[buckets[i]].id == id) return &orders[buckets[i]];
+    }
+    return nullptr;
+}
+
+CompactOrder& OrderStore::insert(const CompactOrder& order) {
+    if (CompactOrder* existing = find(order.id)) return *existing;
+
+    // Keep the index at most half full
+    if ((orders.size() + 1) * 2 > buckets.size()) grow();
+
+    uint32_t slot = orders.acquire();
+    orders[slot] = order;
+    orders[slot].lastFill = NoFill;
+    orders[slot].filledAmount = 0;
+
+    size_t i = home(order.id);
+    while (buckets[i] != NoSlot) i = (i + 1) & mask;
+    buckets[i] = slot;
+    record(Part::Order, slot);
+    record(Part::Bucket, static_cast<uint32_t>(i));
+    if (order.instrument != NoInstrument) {
+        if (order.instrument >= perInstrument.size()) perInstrument.resize(order.instrument + 1, 0);
+        ++perInstrument[order.instrument];
+        record(Part::InstrumentCount, order.instrument);
+    }
+    return orders[slot];
+}
+
+bool OrderStore::erase(const OrderId& id) {
+    for (size_t i = home(id); buckets[i] != NoSlot; i = (i + 1) & mask) {
+        uint32_t slot = buckets[i];
+        CompactOrder& order = orders[slot];
+        if (order.id != id) continue;
+
+        for (uint32_t index = order.lastFill; index != NoFill;) {
+            uint32_t prev = fills[index].prevFill;
+            fills.release(index);
+            index = prev;
+        }
+        if (order.instrument < perInstrument.size()) {
+            --perInstrument[order.instrument];
+            record(Part::InstrumentCount, order.instrument);
+        }
+        order.id = OrderId();
+        orders.release(slot);
+        record(Part::Order, slot);
+        eraseBucket(i);
+        return true;
+    }
+    return false;
+}
+
+void OrderStore::addFill(CompactOrder& order, const CompactFill& fill) {
+    uint32_t index = fills.acquire();
+    fills[index] = fill;
+    fills[index].prevFill = order.lastFill;
+    order.lastFill = index;
+    order.filledAmount += fill.amount;
+    record(Part::Fill, index);
+    find(order.id);     // Records the order's slot
+}
+
+void OrderStore::eraseBucket(size_t hole) {
+    // Pull back any later entry of the probe run that may live in the hole
+    size_t j = hole;
+    while (true) {
+        j = (j + 1) & mask;
+        if (buckets[j] == NoSlot) break;
+        size_t h = home(orders[buckets[j]].id);
+        bool stays = hole <= j ? (hole < h && h <= j) : (hole < h || h <= j);
+        if (!stays) {
+            buckets[hole] = buckets[j];
+            record(Part::Bucket, static_cast<uint32_t>(hole));
+            hole = j;
+        }
+    }
+    buckets[hole] = NoSlot;
+    record(Part::Bucket, static_cast<uint32_t>(hole));
+}
+
+void OrderStore::grow() {
+    // Every bucket moves: snapshots from before this are copied in full
+    journalBase = changeCount() + 1;
+    journal.clear();
+    buckets.assign(buckets.size() * 2, NoSlot);
+    mask = buckets.size() - 1;
+    for (uint32_t slot = 0; slot < orders.touched(); ++slot) {
+        if (orders[slot].id.empty()) continue;
+        size_t i = home(orders[slot].id);
+        while (buckets[i] != NoSlot) i = (i + 1) & mask;
+        buckets[i] = slot;
+    }
+}
+
+void OrderStore::record(Part part, uint32_t index) {
+    // Snapshots more than JournalLimit changes behind are copied in full anyway
+    if (journal.size() >= 2 * JournalLimit) {
+        journal.erase(journal.begin(), journal.begin() + JournalLimit);
+        journalBase += JournalLimit;
+    }
+    journal.push_back(Change{part, index});
+}
+
+void OrderStore::syncFrom(const OrderStore& source) {
+    uint64_t target = source.changeCount();
+    if (syncedTo < source.journalBase || syncedTo > target || buckets.size() != source.buckets.size() ||
+        target - syncedTo > JournalLimit) {
+        orders = source.orders;
+        fills = source.fills;
+        buckets = source.buckets;
+        perInstrument = source.perInstrument;
+        mask = source.mask;
+        syncedTo = target;
+        return;
+    }
+    orders.copyCounters(source.orders);
+    fills.copyCounters(source.fills);
+    if (perInstrument.size() < source.perInstrument.size()) perInstrument.resize(source.perInstrument.size(), 0);
+    for (size_t at = syncedTo - source.journalBase; at < source.journal.size(); ++at) {
+        const Change& change = source.journal[at];
+        switch (change.part) {
+            case Part::Order: orders.copyRecord(source.orders, change.index); break;
+            case Part::Fill: fills.copyRecord(source.fills, change.index); break;
+            case Part::Bucket: buckets[change.index] = source.buckets[change.index]; break;
+            case Part::InstrumentCount: perInstrument[change.index] = source.perInstrument[change.index]; break;
+        }
+    }
+    syncedTo = target;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include "CompactOrder.h"
+#include "ObjectPool.h"
+
+// Working orders and their fills in pooled storage.
+//
+// Orders and fills each live in an ObjectPool, so pointers to them stay valid
+// until the order is erased, and erasing an order (it reached a terminal state)
+// hands its slot and all of its fill slots back for reuse. Lookup by order id
+// goes through a flat open-addressed index of pool slots with backward-shift
+// deletion. Copy-assignment reuses the target's chunks and index, so the
+// dispatcher can republish a snapshot on every change without allocating once
+// the store has reached its working size.
+//
+// Republishing need not copy the whole store either: the store journals every
+// order slot, fill slot, bucket and per-instrument count it writes, and
+// syncFrom() brings a snapshot up to date by copying only those. A snapshot
+// left too far behind (the journal keeps the last JournalLimit changes), or
+// one from before the index grew, is copied in full instead.
+class OrderStore {
+public:
+    static constexpr uint32_t NoSlot = UINT32_MAX;
+
+    OrderStore();
+
+    // Store order unless its id is already known; returns the stored order either way
+    CompactOrder& insert(const CompactOrder& order);
+
+    // The non-const lookup counts the order as changed, since the caller may write to it
+    CompactOrder* find(const OrderId& id);
+    const CompactOrder* find(const OrderId& id) const;
+
+    // Drop an order and recycle its fills. False if the id is unknown.
+    bool erase(const OrderId& id);
+
+    // Append a fill to order's chain
+    void addFill(CompactOrder& order, const CompactFill& fill);
+
+    const CompactFill& fill(uint32_t index) const { return fills[index]; }
+
+    // Visit every order: fn(const CompactOrder&)
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (uint32_t slot = 0; slot < orders.touched(); ++slot) {
+            if (!orders[slot].id.empty()) fn(orders[slot]);
+        }
+    }
+
+    // Visit an order's fills, newest first: fn(const CompactFill&)
+    template <typename Fn>
+    void forEachFill(const CompactOrder& order, Fn&& fn) const {
+        for (uint32_t index = order.lastFill; index != NoFill; index = fills[index].prevFill) fn(fills[index]);
+    }
+
+    // Make this snapshot of source current, copying what changed since its last sync.
+    // A store kept this way is for reading only: don't insert into or erase from it.
+    void syncFrom(const OrderStore& source);
+
+    size_t size() const { return orders.size(); }
+    // Orders held for one instrument, O(1)
+    uint32_t countIn(InstrumentId instrument) const {
+        return instrument < perInstrument.size() ? perInstrument[instrument] : 0;
+    }
+
+    PoolStats orderStats() const { return orders.stats(); }
+    PoolStats fillStats() const { return fills.stats(); }
+    size_t indexBuckets() const { return buckets.size(); }
+
+    static constexpr size_t JournalLimit = 4096;
+
+private:
+    enum class Part : uint8_t {
+        Order,
+        Fill,
+        Bucket,
+        InstrumentCount
+    };
+    struct Change {
+        Part part;
+        uint32_t index;
+    };
+
+    ObjectPool<CompactOrder> orders;      // Released slots have an empty id
+    ObjectPool<CompactFill> fills;
+    std::vector<uint32_t> buckets;        // Order slot per bucket, NoSlot when empty
+    std::vector<uint32_t> perInstrument;  // Order count by InstrumentId
+    size_t mask;
+    std::vector<Change> journal;          // Writes since change number journalBase
+    uint64_t journalBase = 0;
+    uint64_t syncedTo = 0;                // Of a snapshot: changes of its source it has
+
+    size_t home(const OrderId& id) const { return ShortIdHash{}(id) & mask; }
+    uint64_t changeCount() const { return journalBase + journal.size(); }
+    void record(Part part, uint32_t index);
+    void grow();
+    void eraseBucket(size_t hole);
+};
@@ -0,0 +1,113 @@
+#include "PositionLedger.h"
+#include <algorithm>
+#include <cmath>
+
+size_t PositionLedger::slotFor(InstrumentId instrument) {
+    if (instrument >= slots.size()) slots.resize(instrument + 1, NoSlot);
+    if (slots[instrument] != NoSlot) return slots[instrument];
+
+    uint32_t slot = static_cast<uint32_t>(positions.size());
+    positions.emplace_back();
+    recent.emplace_back();
+    instruments.push_back(instrument);
+    slots[instrument] = slot;
+    return slot;
+}
+
+// Linear: size x price move, from the exact 128-bit product
+static double pnl(Qty size, Price move) {
+    __int128 product = static_cast<__int128>(size.raw) * move.raw;
+    return static_cast<double>(product) / (static_cast<double>(FixedScale) * static_cast<double>(FixedScale));
+}
+
+// Inverse: size x (1/entry - 1/exit), in the base coin; positive for a long that rose
+static double inversePnl(Qty size, Price entry, Price exit) {
+    if (entry.raw <= 0 || exit.raw <= 0) return 0.0;
+    return size.toDouble() * (1.0 / entry.toDouble() - 1.0 / exit.toDouble());
+}
+
+static double markedPnl(const Position& position) {
+    if (position.size.isZero()) return 0.0;
+    return position.inverse ? inversePnl(position.size, position.avgEntryPrice, position.markPrice)
+                            : pnl(position.size, position.markPrice - position.avgEntryPrice);
+}
+
+bool PositionLedger::applyTrade(InstrumentId instrument, bool buy, Price price, Qty amount,
+                                double fee, std::string_view feeCurrency, int64_t tradeSeq, bool inverse) {
+    if (instrument == NoInstrument) return false;
+    size_t slot = slotFor(instrument);
+    Position& position = positions[slot];
+    if (tradeSeq >= 0) {
+        if (!recent[slot].add(tradeSeq)) return false;
+        position.lastTradeSeq = recent[slot].last();
+    }
+    position.inverse = inverse;
+
+    Qty signedAmount = buy ? amount : -amount;
+    bool isLong = position.size.raw > 0;
+    bool increasing = position.size.isZero() || isLong == buy;
+
+    if (increasing) {
+        __int128 openSize = isLong ? position.size.raw : -position.size.raw;
+        __int128 totalSize = openSize + amount.raw;
+        if (totalSize > 0 && inverse) {
+            // Harmonic: total notional over the coins it cost
+            double coins = (openSize > 0 ? static_cast<double>(openSize) / position.avgEntryPrice.raw : 0.0) +
+                           static_cast<double>(amount.raw) / price.raw;
+            position.avgEntryPrice = Price::fromRaw(std::llround(static_cast<double>(totalSize) / coins));
+        } else if (totalSize > 0) {
+            __int128 cost = openSize * position.avgEntryPrice.raw + static_cast<__int128>(price.raw) * amount.raw;
+            position.avgEntryPrice = Price::fromRaw(static_cast<int64_t>(cost / totalSize));
+        }
+        position.size += signedAmount;
+    } else {
+        // Close against the open size; anything left over opens the other way at this price
+        Qty closing = std::min(amount, isLong ? position.size : -position.size);
+        if (inverse) {
+            position.realizedPnl += inversePnl(isLong ? closing : -closing, position.avgEntryPrice, price);
+        } else {
+            position.realizedPnl += pnl(closing, isLong ? price - position.avgEntryPrice : position.avgEntryPrice - price);
+        }
+        position.size += signedAmount;
+        if (position.size.isZero()) {
+            position.avgEntryPrice = Price();
+        } else if ((position.size.raw > 0) == buy) {
+            position.avgEntryPrice = price;
+        }
+    }
+
+    if (position.markPrice.isZero()) position.markPrice = price;
+    position.unrealizedPnl = markedPnl(position);
+
+    if (fee != 0.0) {
+        auto it = std::find_if(fees.begin(), fees.end(),
+                               [&](const FeeTotal& total) { return total.currency == feeCurrency; });
+        if (it == fees.end()) {
+            fees.push_back({std::string(feeCurrency), 0.0});
+            it = fees.end() - 1;
+        }
+        it->total += fee;
+    }
+    return true;
+}
+
+bool PositionLedger::setPosition(InstrumentId instrument, Qty size, Price avgEntryPrice, bool inverse) {
+    if (instrument == NoInstrument) return false;
+    Position& position = positions[slotFor(instrument)];
+    position.size = size;
+    position.avgEntryPrice = size.isZero() ? Price() : avgEntryPrice;
+    position.inverse = inverse;
+    if (position.markPrice.isZero()) position.markPrice = position.avgEntryPrice;
+    position.unrealizedPnl = markedPnl(position);
+    return true;
+}
+
+bool PositionLedger::mark(InstrumentId instrument, Price price) {
+    uint32_t slot = instrument < slots.size() ? slots[instrument] : NoSlot;
+    if (slot == NoSlot) return false;
+
+    Position& position = positions[slot];
+    position.markPrice = price;
+    position.unrealizedPnl = markedPnl(position);
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "FixedPoint.h"
+#include "InstrumentRegistry.h"
+#include "RecentTradeSeqs.h"
+
+// Running position in one instrument
+struct Position {
+    Qty size;                     // Net size: positive long, negative short
+    Price avgEntryPrice;          // Average price of the open size (harmonic for inverse contracts)
+    double realizedPnl = 0.0;     // From closed size, in the settlement currency (see inverse)
+    double unrealizedPnl = 0.0;   // Open size marked to markPrice, same units
+    Price markPrice;
+    int64_t lastTradeSeq = -1;    // Highest trade_seq applied
+    bool inverse = false;         // Size is quote-currency notional (USD) and PnL is in the base coin
+};
+
+// Fees paid in one currency
+struct FeeTotal {
+    std::string currency;
+    double total = 0.0;
+};
+
+// Per-instrument positions built incrementally from fills.
+//
+// Every trade updates net size, average entry and realized PnL in O(1); marks
+// only touch unrealized PnL. Instruments get a dense slot the first time they
+// trade, found through a table indexed by InstrumentId, so lookups are two
+// array reads and copying the ledger is cheap once the set of instruments is
+// stable.
+//
+// Size is fixed-point and updated with exact integer arithmetic, so a
+// position that is closed out is exactly flat. Linear contracts have PnL of
+// size x price move in quote units and an arithmetic average entry. Inverse
+// contracts (Deribit's BTC-PERPETUAL and coin-margined futures, whose amount is
+// USD) have PnL of size x (1/entry - 1/exit) in the base coin and a harmonic
+// average entry, as the exchange reports them.
+//
+// A fill is recognized as already applied by its trade_seq among the last
+// RecentTrades of its instrument, not by a high-water mark: the same fill comes
+// in the order ack and on user.trades, in either order, and batched
+// notifications may deliver an older fill after a newer one.
+class PositionLedger {
+public:
+    static constexpr int RecentTrades = 32;     // trade_seqs remembered per instrument
+
+private:
+    static constexpr uint32_t NoSlot = UINT32_MAX;
+
+    std::vector<Position> positions;
+    std::vector<RecentTradeSeqs<RecentTrades>> recent;   // Per slot
+    std::vector<InstrumentId> instruments;           // Instrument per slot
+    std::vector<uint32_t> slots;                     // InstrumentId -> slot, NoSlot if never traded
+    std::vector<FeeTotal> fees;
+
+    size_t slotFor(InstrumentId instrument);
+
+public:
+    // Apply one fill of an inverse or linear contract. tradeSeq < 0 skips the duplicate check.
+    // Returns false if the fill was already applied (or instrument is NoInstrument).
+    bool applyTrade(InstrumentId instrument, bool buy, Price price, Qty amount,
+                    double fee, std::string_view feeCurrency, int64_t tradeSeq = -1, bool inverse = false);
+
+    // Overwrite size and average entry with the exchange's figures (reconciliation after
+    // fills we missed). Realized PnL, fees and the trade_seqs seen are kept.
+    // Returns false for NoInstrument.
+    bool setPosition(InstrumentId instrument, Qty size, Price avgEntryPrice, bool inverse = false);
+
+    // Update the mark price of an instrument we hold (or have held).
+    // Returns false if the ledger has never seen the instrument.
+    bool mark(InstrumentId instrument, Price price);
+
+    const Position* find(InstrumentId instrument) const {
+        uint32_t slot = instrument < slots.size() ? slots[instrument] : NoSlot;
+        return slot == NoSlot ? nullptr : &positions[slot];
+    }
+
+    size_t size() const { return positions.size(); }
+    InstrumentId instrumentAt(size_t slot) const { return instruments[slot]; }
+    const Position& positionAt(size_t slot) const { return positions[slot]; }
+    const std::vector<FeeTotal>& feesByCurrency() const { return fees; }
+};
@@ -0,0 +1,166 @@
+#include "PriceSeries.h"
+#include <algorithm>
+
+// Min and max of [begin, end) with their positions, folded into low/high
+static void scanRange(const double* begin, const double* end, const double*& low, const double*& high) {
+    double lowValue = *low, highValue = *high;
+    for (const double* p = begin; p < end; ++p) {
+        double value = *p;
+        if (value < lowValue) {
+            lowValue = value;
+            low = p;
+        }
+        if (value > highValue) {
+            highValue = value;
+            high = p;
+        }
+    }
+}
+
+void downsampleMinMax(const double* a, size_t na, const double* b, size_t nb, size_t width, std::vector<double>& out) {
+    size_t n = na + nb;
+    if (n <= width) {
+        out.resize(n);
+        std::copy(a, a + na, out.begin());
+        std::copy(b, b + nb, out.begin() + na);
+        return;
+    }
+    // Position i of the series lives at a + i or, past na, at b + (i - na); pointers into
+    // b only compare correctly among themselves, so order is decided on positions
+    auto point = [&](size_t i) { return i < na ? a + i : b + (i - na); };
+    auto position = [&](const double* p) { return p >= a && p < a + na ? static_cast<size_t>(p - a) : na + (p - b); };
+    size_t buckets = std::max<size_t>(1, width / 2);
+    out.resize(buckets * 2);
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+        size_t begin = bucket * n / buckets;
+        size_t end = (bucket + 1) * n / buckets;
+        const double* low = point(begin);
+        const double* high = low;
+        if (begin < na) scanRange(a + begin, a + std::min(end, na), low, high);
+        if (end > na) scanRange(b + (std::max(begin, na) - na), b + (end - na), low, high);
+        bool lowFirst = position(low) <= position(high);
+        out[bucket * 2] = lowFirst ? *low : *high;
+        out[bucket * 2 + 1] = lowFirst ? *high : *low;
+    }
+}
+
+PriceSeries::PriceSeries(size_t capacity) {
+    size_t size = BlockSize;
+    while (size < capacity) size <<= 1;
+    values.resize(size);
+    minQueue.resize(size);
+    maxQueue.resize(size);
+    blocks.resize(size / BlockSize);
+    mask = size - 1;
+    blockMask = blocks.size() - 1;
+}
+
+void PriceSeries::push(double price) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t seq = total;
+    // The point this one overwrites leaves the window, and with it any queue front that was it
+    if (seq > mask) {
+        uint64_t leaving = seq - (mask + 1);
+        if (minHead != minTail && minQueue[minHead & mask] == leaving) ++minHead;
+        if (maxHead != maxTail && maxQueue[maxHead & mask] == leaving) ++maxHead;
+    }
+    values[seq & mask] = price;
+    // Points behind the new one that can never be the min (or max) again
+    while (minHead != minTail && values[minQueue[(minTail - 1) & mask] & mask] >= price) --minTail;
+    minQueue[minTail++ & mask] = seq;
+    while (maxHead != maxTail && values[maxQueue[(maxTail - 1) & mask] & mask] <= price) --maxTail;
+    maxQueue[maxTail++ & mask] = seq;
+
+    Block& block = blocks[(seq / BlockSize) & blockMask];
+    if (seq % BlockSize == 0) {
+        block = Block{price, price, seq, seq};
+    } else {
+        if (price < block.min) {
+            block.min = price;
+            block.minSeq = seq;
+        }
+        if (price > block.max) {
+            block.max = price;
+            block.maxSeq = seq;
+        }
+    }
+    ++total;
+}
+
+SeriesSummary PriceSeries::summary() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SeriesSummary out;
+    out.count = held();
+    if (out.count == 0) return out;
+    out.last = values[(total - 1) & mask];
+    out.min = values[minQueue[minHead & mask] & mask];
+    out.max = values[maxQueue[maxHead & mask] & mask];
+    return out;
+}
+
+void PriceSeries::downsample(size_t width, std::vector<double>& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = held();
+    uint64_t start = total - count;
+    if (count <= width) {
+        // Oldest point onwards: the ring is at most two contiguous runs
+        size_t first = std::min(count, values.size() - static_cast<size_t>(start & mask));
+        downsampleMinMax(values.data() + (start & mask), first, values.data(), count - first, width, out);
+        return;
+    }
+
+    size_t buckets = std::max<size_t>(1, width / 2);
+    out.resize(buckets * 2);
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+        uint64_t begin = start + bucket * count / buckets;
+        uint64_t end = start + (bucket + 1) * count / buckets;
+        double low = values[begin & mask], high = low;
+        uint64_t lowSeq = begin, highSeq = begin;
+        for (uint64_t seq = begin; seq < end;) {
+            // A whole block inside the bucket was written since its first point, so its extremes are current
+            if (seq % BlockSize == 0 && seq + BlockSize <= end) {
+                const Block& block = blocks[(seq / BlockSize) & blockMask];
+                if (block.min < low) {
+                    low = block.min;
+                    lowSeq = block.minSeq;
+                }
+                if (block.max > high) {
+                    high = block.max;
+                    highSeq = block.maxSeq;
+                }
+                seq += BlockSize;
+                continue;
+            }
+            // Bucket edges: scan up to the next block boundary (blocks never wrap the ring)
+            uint64_t stop = std::min<uint64_t>(end, (seq / BlockSize + 1) * BlockSize);
+            const double* point = values.data() + (seq & mask);
+            for (; seq < stop; ++seq, ++point) {
+                if (*point < low) {
+                    low = *point;
+                    lowSeq = seq;
+                }
+                if (*point > high) {
+                    high = *point;
+                    highSeq = seq;
+                }
+            }
+        }
+        out[bucket * 2] = lowSeq <= highSeq ? low : high;
+        out[bucket * 2 + 1] = lowSeq <= highSeq ? high : low;
+    }
+}
+
+void PriceHistory::record(InstrumentId instrument, double price) {
+    if (instrument == NoInstrument) return;
+    if (instrument >= series.size() || !series[instrument]) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (instrument >= series.size()) series.resize(instrument + 1);
+        series[instrument] = std::make_unique<PriceSeries>(capacity);
+    }
+    series[instrument]->push(price);
+}
+
+const PriceSeries* PriceHistory::find(InstrumentId instrument) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return instrument < series.size() ? series[instrument].get() : nullptr;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<memory>
+#include<mutex>
+#include<vector>
+#include "InstrumentRegistry.h"
+
+// Reduce the points a[0..na) followed by b[0..nb) to at most width values in out.
+// Consecutive points are grouped into width/2 buckets and each bucket gives its
+// min and max in the order they occurred, so spikes survive however many points
+// share a column. Fewer points than width are copied as they are. out is resized,
+// never shrunk, so a reused buffer stops allocating after the first call.
+void downsampleMinMax(const double* a, size_t na, const double* b, size_t nb, size_t width, std::vector<double>& out);
+
+struct SeriesSummary {
+    size_t count = 0;
+    double last = 0.0;
+    double min = 0.0;           // Over everything still held
+    double max = 0.0;
+};
+
+// Fixed-capacity price history of one instrument: the newest capacity points,
+// oldest overwritten first.
+//
+// Rolling min and max come from two monotonic queues of positions (ascending
+// values for min, descending for max). Each point enters and leaves each queue
+// once, so push is amortised O(1) and min/max are O(1) reads of the fronts.
+// Every BlockSize points also keep their own min and max, so downsampling folds
+// whole blocks and only scans points at bucket edges: a frame of a 100k-point
+// history touches a few thousand values, not all of them. All storage is
+// allocated up front.
+//
+// One thread pushes, any thread reads; a short mutex keeps them apart.
+class PriceSeries {
+public:
+    static constexpr size_t BlockSize = 64;
+
+    // Capacity is rounded up to a power of two, and to at least BlockSize
+    explicit PriceSeries(size_t capacity);
+
+    void push(double price);
+
+    SeriesSummary summary() const;
+
+    // The whole history downsampled for width columns, as downsampleMinMax would
+    void downsample(size_t width, std::vector<double>& out) const;
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    // Extremes of one aligned run of BlockSize sequences, first occurrence on ties
+    struct Block {
+        double min = 0.0, max = 0.0;
+        uint64_t minSeq = 0, maxSeq = 0;
+    };
+
+    std::vector<double> values;           // Ring, indexed by sequence & mask
+    std::vector<Block> blocks;            // Indexed by (sequence / BlockSize) & blockMask
+    std::vector<uint64_t> minQueue;       // Sequences of ascending values, front is the min
+    std::vector<uint64_t> maxQueue;       // Sequences of descending values, front is the max
+    uint64_t minHead = 0, minTail = 0;
+    uint64_t maxHead = 0, maxTail = 0;
+    uint64_t total = 0;                   // Points ever pushed; the next point's sequence
+    size_t mask;
+    size_t blockMask;
+    mutable std::mutex mutex;
+
+    size_t held() const { return total < values.size() ? static_cast<size_t>(total) : values.size(); }
+};
+
+// A PriceSeries per instrument, created on its first price.
+//
+// Only the dispatcher thread records, so it looks series up without locking;
+// the lock covers adding one and other threads' lookups. Series are never
+// removed, so a pointer from find() stays valid for the history's lifetime.
+class PriceHistory {
+public:
+    static constexpr size_t DefaultCapacity = 131072;   // Points per instrument
+
+    explicit PriceHistory(size_t capacityPerInstrument = DefaultCapacity) : capacity(capacityPerInstrument) {}
+
+    // Writer thread only
+    void record(InstrumentId instrument, double price);
+
+    // Null until the instrument has a price
+    const PriceSeries* find(InstrumentId instrument) const;
+
+private:
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<PriceSeries>> series;   // Indexed by InstrumentId
+};
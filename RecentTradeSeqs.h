@@ -0,0 +1,31 @@
+#pragma once
+#include<algorithm>
+#include<cstddef>
+#include<cstdint>
+
+// The last Size trade_seqs applied for one instrument, to recognize a trade seen twice.
+//
+// The same trade can arrive in an order's response and on a trades channel, in
+// either order, and a batched notification may deliver an older trade after a
+// newer one, so a high-water mark would drop real trades. A seq above every one
+// seen so far is new without a search, which is the common, in-order case.
+template <size_t Size>
+class RecentTradeSeqs {
+public:
+    RecentTradeSeqs() { std::fill(seqs, seqs + Size, -1); }
+
+    // False if seq was already applied; otherwise remembers it
+    bool add(int64_t seq) {
+        if (seq <= highest && std::find(seqs, seqs + Size, seq) != seqs + Size) return false;
+        seqs[next++ % Size] = seq;
+        highest = std::max(highest, seq);
+        return true;
+    }
+
+    int64_t last() const { return highest; }
+
+private:
+    int64_t seqs[Size];
+    size_t next = 0;
+    int64_t highest = -1;
+};
@@ -0,0 +1,194 @@
+#include "RequestEncoder.h"
+#include <charconv>
+
+RequestEncoder::RequestEncoder(size_t capacity) {
+    buffer.reserve(capacity);
+}
+
+std::string_view RequestEncoder::orderTypeName(OrderType type) {
+    switch (type) {
+        case OrderType::limit: return "limit";
+        case OrderType::stop_limit: return "stop_limit";
+        case OrderType::take_limit: return "take_limit";
+        case OrderType::market: return "market";
+        case OrderType::stop_market: return "stop_market";
+        case OrderType::take_market: return "take_market";
+        case OrderType::market_limit: return "market_limit";
+        case OrderType::trailing_stop: return "trailing_stop";
+    }
+    return "limit";
+}
+
+void RequestEncoder::appendInt(int64_t value) {
+    char digits[24];
+    auto [ptr, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, ptr);
+}
+
+void RequestEncoder::appendFixed(int64_t value) {
+    char digits[24];
+    buffer.append(digits, formatFixed(digits, value));
+}
+
+void RequestEncoder::appendString(std::string_view value) {
+    static const char hex[] = "0123456789abcdef";
+    buffer.push_back('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            buffer.push_back('\\');
+            buffer.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            buffer.append("\\u00");
+            buffer.push_back(hex[(c >> 4) & 0xF]);
+            buffer.push_back(hex[c & 0xF]);
+        } else {
+            buffer.push_back(c);
+        }
+    }
+    buffer.push_back('"');
+}
+
+void RequestEncoder::key(std::string_view name) {
+    buffer.append(",\"");
+    buffer.append(name);
+    buffer.append("\":");
+}
+
+void RequestEncoder::beginBatch() {
+    buffer.clear();
+    batchEnds.clear();
+    batching = true;
+}
+
+void RequestEncoder::begin(int64_t id, std::string_view method) {
+    if (!batching) buffer.clear();
+    requestStart = buffer.size();
+    appendRaw(R"({"jsonrpc":"2.0","id":)");
+    appendInt(id);
+    appendRaw(R"(,"method":")");
+    appendRaw(method);
+    appendRaw("\"");
+}
+
+std::string_view RequestEncoder::finish(bool hasParams) {
+    appendRaw(hasParams ? "}}" : "}");
+    if (batching) batchEnds.push_back(buffer.size());
+    return std::string_view(buffer).substr(requestStart);
+}
+
+std::string_view RequestEncoder::order(int64_t id, bool buy, std::string_view instrument, Qty amount,
+                                       OrderType type, std::optional<Price> price, std::string_view label) {
+    begin(id, buy ? "private/buy" : "private/sell");
+    appendRaw(R"(,"params":{"instrument_name":)");
+    appendString(instrument);
+    key("amount");
+    appendFixed(amount.raw);
+    key("type");
+    appendString(orderTypeName(type));
+    if (price && type != OrderType::market && type != OrderType::stop_market && type != OrderType::take_market) {
+        key("price");
+        appendFixed(price->raw);
+    }
+    if (!label.empty()) {
+        key("label");
+        appendString(label);
+    }
+    return finish(true);
+}
+
+std::string_view RequestEncoder::edit(int64_t id, std::string_view orderId, Qty amount, Price price,
+                                      std::string_view advanced, bool postOnly, bool reduceOnly) {
+    begin(id, "private/edit");
+    appendRaw(R"(,"params":{"order_id":)");
+    appendString(orderId);
+    key("amount");
+    appendFixed(amount.raw);
+    key("price");
+    appendFixed(price.raw);
+    if (!advanced.empty()) {
+        key("advanced");
+        appendString(advanced);
+    }
+    key("post_only");
+    appendBool(postOnly);
+    key("reduce_only");
+    appendBool(reduceOnly);
+    return finish(true);
+}
+
+std::string_view RequestEncoder::cancel(int64_t id, std::string_view orderId) {
+    begin(id, "private/cancel");
+    appendRaw(R"(,"params":{"order_id":)");
+    appendString(orderId);
+    return finish(true);
+}
+
+std::string_view RequestEncoder::cancelByLabel(int64_t id, std::string_view label) {
+    begin(id, "private/cancel_by_label");
+    appendRaw(R"(,"params":{"label":)");
+    appendString(label);
+    return finish(true);
+}
+
+std::string_view RequestEncoder::channel(int64_t id, std::string_view method, std::string_view channelName) {
+    begin(id, method);
+    appendRaw(R"(,"params":{"channels":[)");
+    appendString(channelName);
+    appendRaw("]");
+    return finish(true);
+}
+
+std::string_view RequestEncoder::channels(int64_t id, std::string_view method,
+                                          const std::vector<std::string_view>& channelNames) {
+    begin(id, method);
+    appendRaw(R"(,"params":{"channels":[)");
+    for (size_t i = 0; i < channelNames.size(); ++i) {
+        if (i) appendRaw(",");
+        appendString(channelNames[i]);
+    }
+    appendRaw("]");
+    return finish(true);
+}
+
+std::string_view RequestEncoder::instrument(int64_t id, std::string_view method, std::string_view instrumentName,
+                                            std::optional<int> count) {
+    begin(id, method);
+    appendRaw(R"(,"params":{"instrument_name":)");
+    appendString(instrumentName);
+    if (count) {
+        key("count");
+        appendInt(*count);
+    }
+    return finish(true);
+}
+
+std::string_view RequestEncoder::currency(int64_t id, std::string_view method, std::string_view currencyName,
+                                          std::optional<int> count) {
+    begin(id, method);
+    appendRaw(R"(,"params":{"currency":)");
+    appendString(currencyName);
+    if (count) {
+        key("count");
+        appendInt(*count);
+    }
+    return finish(true);
+}
+
+std::string_view RequestEncoder::heartbeat(int64_t id, int intervalSeconds) {
+    begin(id, "public/set_heartbeat");
+    appendRaw(R"(,"params":{"interval":)");
+    appendInt(intervalSeconds);
+    return finish(true);
+}
+
+std::string_view RequestEncoder::scope(int64_t id, std::string_view method, std::string_view scopeName) {
+    begin(id, method);
+    appendRaw(R"(,"params":{"scope":)");
+    appendString(scopeName);
+    return finish(true);
+}
+
+std::string_view RequestEncoder::noParams(int64_t id, std::string_view method) {
+    begin(id, method);
+    return finish(false);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include<cstdint>
+#include<optional>
+#include<string>
+#include<string_view>
+#include<vector>
+#include "types.hpp"
+#include "FixedPoint.h"
+
+// Writes JSON-RPC requests straight into a reusable buffer.
+//
+// Each method is a fixed template: the constant parts are string literals and
+// only the id, names and numbers are formatted in between (std::to_chars, no
+// locale, no temporaries). Prices and amounts are written from their
+// fixed-point value, so what goes out is exactly the tick-rounded number. The returned view points into the encoder's buffer
+// and stays valid until the next encode call, so one encoder per connection is
+// enough: encode, send, repeat. Once the buffer has grown to fit the largest
+// request nothing is allocated.
+//
+// Between beginBatch() and endBatch() requests are appended one after another
+// instead, so a whole batch is encoded into one contiguous buffer and then
+// handed to the socket back to back (views returned by the encode calls may be
+// invalidated by later ones; use batchRequest(i)).
+class RequestEncoder {
+private:
+    std::string buffer;
+    size_t requestStart = 0;          // Where the request being encoded begins in buffer
+    bool batching = false;
+    std::vector<size_t> batchEnds;    // End offset of each request of the batch
+
+    void begin(int64_t id, std::string_view method);
+    std::string_view finish(bool hasParams);
+
+    void appendRaw(std::string_view text) { buffer.append(text); }
+    void appendInt(int64_t value);
+    void appendFixed(int64_t value);                 // Exact decimal, e.g. 64000.5
+    void appendString(std::string_view value);      // Quoted and escaped
+    void appendBool(bool value) { buffer.append(value ? "true" : "false"); }
+
+    // ,"name": between params members
+    void key(std::string_view name);
+
+public:
+    explicit RequestEncoder(size_t capacity = 512);
+
+    static std::string_view orderTypeName(OrderType type);
+
+    // private/buy, private/sell
+    std::string_view order(int64_t id, bool buy, std::string_view instrument, Qty amount,
+                           OrderType type, std::optional<Price> price, std::string_view label);
+    // private/edit
+    std::string_view edit(int64_t id, std::string_view orderId, Qty amount, Price price,
+                          std::string_view advanced, bool postOnly, bool reduceOnly);
+    // private/cancel
+    std::string_view cancel(int64_t id, std::string_view orderId);
+    // private/cancel_by_label
+    std::string_view cancelByLabel(int64_t id, std::string_view label);
+    // public/subscribe, public/unsubscribe with a single channel
+    std::string_view channel(int64_t id, std::string_view method, std::string_view channelName);
+    // public/ and private/ subscribe and unsubscribe with a list of channels
+    std::string_view channels(int64_t id, std::string_view method, const std::vector<std::string_view>& channelNames);
+    // Methods taking instrument_name and an optional count (public/ticker, public/get_instrument, ...)
+    std::string_view instrument(int64_t id, std::string_view method, std::string_view instrumentName,
+                                std::optional<int> count = std::nullopt);
+    // public/set_heartbeat
+    std::string_view heartbeat(int64_t id, int intervalSeconds);
+    // Methods taking a scope (private/enable_cancel_on_disconnect, ...)
+    std::string_view scope(int64_t id, std::string_view method, std::string_view scopeName);
+    // Methods taking currency and an optional count
+    std::string_view currency(int64_t id, std::string_view method, std::string_view currencyName,
+                              std::optional<int> count = std::nullopt);
+    // Methods without params (public/get_currencies, public/unsubscribe_all, ...)
+    std::string_view noParams(int64_t id, std::string_view method);
+
+    void beginBatch();
+    void endBatch() { batching = false; }
+    size_t batchSize() const { return batchEnds.size(); }
+    std::string_view batchRequest(size_t i) const {
+        size_t start = i == 0 ? 0 : batchEnds[i - 1];
+        return std::string_view(buffer).substr(start, batchEnds[i] - start);
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include<atomic>
+#include<cstddef>
+#include<cstdint>
+#include<utility>
+#include<vector>
+
+// Fixed-capacity, open-addressed table of in-flight JSON-RPC requests keyed by id.
+//
+// Ids come from the table's own monotonic counter, so with identity hashing
+// consecutive requests land in consecutive slots and probes are almost always
+// one step long. Removal uses backward-shift deletion (no tombstones), so the
+// table never degrades however long the session runs. The slot array is
+// allocated once; insert/take only move Pending values in and out.
+//
+// Requests are registered from the menu/strategy threads and completed from the
+// websocket thread, so every operation takes a short spinlock.
+template <typename Pending>
+class RequestTable {
+private:
+    struct Slot {
+        int64_t id = 0;
+        bool used = false;
+        Pending pending{};
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t capacity;                       // Max in-flight requests (half the slots)
+    std::atomic<size_t> count{0};          // Written under the lock, read by size() without it
+    std::atomic<int64_t> lastId{0};
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+
+    struct Guard {
+        std::atomic_flag& flag;
+        explicit Guard(std::atomic_flag& f) : flag(f) {
+            while (flag.test_and_set(std::memory_order_acquire)) {
+            }
+        }
+        ~Guard() { flag.clear(std::memory_order_release); }
+    };
+
+    size_t home(int64_t id) const { return static_cast<size_t>(id) & mask; }
+
+    void erase(size_t hole) {
+        // Pull back any later entry of the probe run that may live in the hole
+        size_t j = hole;
+        while (true) {
+            j = (j + 1) & mask;
+            if (!slots[j].used) break;
+            size_t h = home(slots[j].id);
+            bool stays = hole <= j ? (hole < h && h <= j) : (hole < h || h <= j);
+            if (!stays) {
+                slots[hole] = std::move(slots[j]);
+                hole = j;
+            }
+        }
+        slots[hole].used = false;
+        slots[hole].pending = Pending{};
+        count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    explicit RequestTable(size_t maxInFlight = 4096) : capacity(maxInFlight) {
+        size_t size = 1;
+        while (size < maxInFlight * 2) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Next request id, never reused within a session
+    int64_t nextId() { return lastId.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    // Register a request. Returns false (leaving pending untouched) when the table is full.
+    bool insert(int64_t id, Pending&& pending) {
+        Guard guard(busy);
+        if (count.load(std::memory_order_relaxed) == capacity) return false;
+        size_t i = home(id);
+        while (slots[i].used) {
+            if (slots[i].id == id) return false;
+            i = (i + 1) & mask;
+        }
+        slots[i].id = id;
+        slots[i].used = true;
+        slots[i].pending = std::move(pending);
+        count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Remove the request with this id into out. False if it is not pending.
+    bool take(int64_t id, Pending& out) {
+        Guard guard(busy);
+        for (size_t i = home(id); slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].id == id) {
+                out = std::move(slots[i].pending);
+                erase(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Run fn on a still-pending request in place, under the lock. False if it is not pending.
+    template <typename Fn>
+    bool update(int64_t id, Fn&& fn) {
+        Guard guard(busy);
+        for (size_t i = home(id); slots[i].used; i = (i + 1) & mask) {
+            if (slots[i].id == id) {
+                fn(slots[i].pending);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Remove every pending request, handing each to fn (e.g. to fail them on disconnect)
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        std::vector<Pending> drained;
+        {
+            Guard guard(busy);
+            drained.reserve(count.load(std::memory_order_relaxed));
+            for (Slot& slot : slots) {
+                if (slot.used) {
+                    drained.push_back(std::move(slot.pending));
+                    slot.pending = Pending{};
+                    slot.used = false;
+                }
+            }
+            count.store(0, std::memory_order_relaxed);
+        }
+        for (Pending& pending : drained) fn(pending);
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+    size_t maxInFlight() const { return capacity; }
+};
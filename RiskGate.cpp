@@ -0,0 +1,106 @@
+#include "RiskGate.h"
+
+const char* riskRejectText(RiskReject reason) {
+    switch (reason) {
+        case RiskReject::None: return "Accepted";
+        case RiskReject::Halted: return "Trading halted by kill switch";
+        case RiskReject::Instrument: return "Instrument outside the risk table";
+        case RiskReject::Quantity: return "Order amount over limit";
+        case RiskReject::Notional: return "Order notional over limit (or no price to value it at)";
+        case RiskReject::Collar: return "Limit price outside the collar around mid";
+        case RiskReject::Position: return "Position limit would be exceeded";
+        case RiskReject::OpenOrders: return "Too many open orders in instrument";
+        default: return "Rejected by risk checks";
+    }
+}
+
+void RiskGate::LimitFields::store(const RiskLimits& limits) {
+    maxOrderQty.store(limits.maxOrderQty.raw, std::memory_order_relaxed);
+    maxOrderNotional.store(limits.maxOrderNotional, std::memory_order_relaxed);
+    maxPosition.store(limits.maxPosition.raw, std::memory_order_relaxed);
+    collarBps.store(limits.collarBps, std::memory_order_relaxed);
+    maxOpenOrders.store(limits.maxOpenOrders, std::memory_order_relaxed);
+}
+
+RiskLimits RiskGate::LimitFields::load() const {
+    RiskLimits limits;
+    limits.maxOrderQty = Qty::fromRaw(maxOrderQty.load(std::memory_order_relaxed));
+    limits.maxOrderNotional = maxOrderNotional.load(std::memory_order_relaxed);
+    limits.maxPosition = Qty::fromRaw(maxPosition.load(std::memory_order_relaxed));
+    limits.collarBps = collarBps.load(std::memory_order_relaxed);
+    limits.maxOpenOrders = maxOpenOrders.load(std::memory_order_relaxed);
+    return limits;
+}
+
+void RiskGate::setLimits(InstrumentId instrument, const RiskLimits& limits) {
+    if (instrument >= capacity) return;
+    slots[instrument].limits.store(limits);
+    slots[instrument].hasLimits.store(true, std::memory_order_release);
+}
+
+void RiskGate::clearLimits(InstrumentId instrument) {
+    if (instrument < capacity) slots[instrument].hasLimits.store(false, std::memory_order_release);
+}
+
+RiskLimits RiskGate::limits(InstrumentId instrument) const {
+    if (instrument < capacity && slots[instrument].hasLimits.load(std::memory_order_acquire)) {
+        return slots[instrument].limits.load();
+    }
+    return defaults.load();
+}
+
+static int64_t magnitude(int64_t value) { return value < 0 ? -value : value; }
+
+RiskReject RiskGate::admit(const CompactOrder& order, Qty position, uint32_t restingOrders, bool inverse) {
+    if (halted.load(std::memory_order_relaxed)) return reject(RiskReject::Halted);
+    if (order.instrument >= capacity) return reject(RiskReject::Instrument);
+
+    Slot& slot = slots[order.instrument];
+    const LimitFields& limits = slot.hasLimits.load(std::memory_order_acquire) ? slot.limits : defaults;
+    int64_t mid = slot.mid.load(std::memory_order_relaxed);
+
+    int64_t maxQty = limits.maxOrderQty.load(std::memory_order_relaxed);
+    if (maxQty > 0 && order.amount > maxQty) return reject(RiskReject::Quantity);
+
+    // The amount of an inverse contract is its notional already
+    double maxNotional = limits.maxOrderNotional.load(std::memory_order_relaxed);
+    if (maxNotional > 0.0 && inverse) {
+        if (fromFixed(order.amount) > maxNotional) return reject(RiskReject::Notional);
+    } else if (maxNotional > 0.0) {
+        int64_t price = order.hasPrice() ? order.price : mid;
+        if (price == 0 || fromFixed(order.amount) * fromFixed(magnitude(price)) > maxNotional) {
+            return reject(RiskReject::Notional);
+        }
+    }
+
+    // |price - mid| / mid > bps / 10000, kept in integers: both sides stay below 2^63 for prices under 1e6
+    int64_t collarBps = limits.collarBps.load(std::memory_order_relaxed);
+    if (collarBps > 0 && mid > 0 && order.hasPrice() &&
+        magnitude(order.price - mid) * 10000 > collarBps * mid) {
+        return reject(RiskReject::Collar);
+    }
+
+    // The last two take a share of the slot's counters, so concurrent callers each see the others'
+    // orders; a rejected order gives its share back. Orders that bring the position (with every
+    // open order on their side filled) closer to flat always pass.
+    bool buy = order.side == OrderSide::Buy;
+    std::atomic<int64_t>& open = slot.open[buy ? 0 : 1];
+    int64_t openAfter = open.fetch_add(order.amount, std::memory_order_relaxed) + order.amount;
+    int64_t maxPosition = limits.maxPosition.load(std::memory_order_relaxed);
+    if (maxPosition > 0) {
+        int64_t after = position.raw + (buy ? openAfter : -openAfter);
+        if (magnitude(after) > maxPosition && magnitude(after) > magnitude(position.raw)) {
+            open.fetch_sub(order.amount, std::memory_order_relaxed);
+            return reject(RiskReject::Position);
+        }
+    }
+
+    uint32_t maxOpen = limits.maxOpenOrders.load(std::memory_order_relaxed);
+    int32_t inFlight = slot.inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (maxOpen > 0 && restingOrders + static_cast<uint32_t>(inFlight) > maxOpen) {
+        slot.inFlight.fetch_sub(1, std::memory_order_relaxed);
+        open.fetch_sub(order.amount, std::memory_order_relaxed);
+        return reject(RiskReject::OpenOrders);
+    }
+    return RiskReject::None;
+}
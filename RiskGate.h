@@ -0,0 +1,136 @@
+#pragma once
+#include<atomic>
+#include<cstdint>
+#include<memory>
+#include "CompactOrder.h"
+#include "FixedPoint.h"
+#include "InstrumentRegistry.h"
+
+// Limits one instrument's new orders are held to. Zero disables a check.
+struct RiskLimits {
+    Qty maxOrderQty;                  // Amount of a single order
+    double maxOrderNotional = 0.0;    // Value of a single order in quote units: amount x price, or the amount of inverse contracts
+    Qty maxPosition;                  // Absolute net size if this and every open order on its side fill
+    int32_t collarBps = 0;            // Limit price at most this many basis points away from mid
+    uint32_t maxOpenOrders = 0;       // Resting plus in-flight orders, this one included
+};
+
+// Why the gate turned an order away
+enum class RiskReject : uint8_t {
+    None,
+    Halted,         // Kill switch is on
+    Instrument,     // Beyond the gate's capacity
+    Quantity,
+    Notional,
+    Collar,
+    Position,
+    OpenOrders,
+    Count
+};
+
+const char* riskRejectText(RiskReject reason);
+
+// Pre-trade checks every new order passes before it is sent.
+//
+// Limits, the last mid and the count of orders in flight live in one slot
+// per InstrumentId, allocated up front for the registry's whole capacity, so
+// a check is a handful of relaxed atomic loads and compares: no locks, no
+// allocation, no lookups by name. Instruments without limits of their own
+// fall back to the default limits.
+//
+// The caller supplies what the gate can't see itself: the position from the
+// published ledger and the orders resting on the exchange. admit() counts the
+// order as in flight until release() is called for it, which closes the gap
+// between sending an order and seeing it acknowledged, even when several
+// threads place orders at once.
+//
+// For the position limit each side also keeps the open amount of its orders,
+// in flight and resting, so a ladder or a burst of orders placed before the
+// first fill is held to the limit as a whole rather than one order at a time.
+// admit() reserves the order's amount and release() returns it; orders on the
+// exchange hold their unfilled amount through hold(), which the owner of the
+// order store moves as orders are acknowledged, fill, change and close.
+//
+// Limits may change while orders are being placed; a check running at that
+// moment sees each field either before or after the change.
+class RiskGate {
+public:
+    explicit RiskGate(uint32_t capacity = 16384) : capacity(capacity), slots(new Slot[capacity]) {}
+
+    // Run every check on order, whose instrument holds position (zero if none), has
+    // restingOrders open on the exchange and is an inverse contract (amount in USD) or not.
+    // On None the order counts as in flight and its amount as open on its side.
+    // Without a mid yet the collar is skipped, and a linear order without a price fails a notional limit.
+    RiskReject admit(const CompactOrder& order, Qty position, uint32_t restingOrders, bool inverse = false);
+    // An admitted order was answered (acknowledged or not) or never sent
+    void release(const CompactOrder& order) {
+        if (order.instrument >= capacity) return;
+        slots[order.instrument].inFlight.fetch_sub(1, std::memory_order_relaxed);
+        hold(order.instrument, order.side, -order.amount);
+    }
+    // Add amount (raw Qty; negative to return it) to the open amount of instrument's side
+    void hold(InstrumentId instrument, OrderSide side, int64_t amount) {
+        if (instrument < capacity) slots[instrument].open[side == OrderSide::Buy ? 0 : 1].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    // Reference price for the collar (and notional of orders without a price)
+    void setMid(InstrumentId instrument, Price mid) {
+        if (instrument < capacity) slots[instrument].mid.store(mid.raw, std::memory_order_relaxed);
+    }
+
+    void setDefaultLimits(const RiskLimits& limits) { defaults.store(limits); }
+    // Limits of one instrument, replacing the defaults for it
+    void setLimits(InstrumentId instrument, const RiskLimits& limits);
+    // Back to the defaults
+    void clearLimits(InstrumentId instrument);
+    RiskLimits limits(InstrumentId instrument) const;
+    RiskLimits defaultLimits() const { return defaults.load(); }
+
+    // Kill switch: while on, every new order is rejected
+    void halt(bool on) { halted.store(on, std::memory_order_relaxed); }
+    bool isHalted() const { return halted.load(std::memory_order_relaxed); }
+
+    uint32_t inFlight(InstrumentId instrument) const {
+        return instrument < capacity ? slots[instrument].inFlight.load(std::memory_order_relaxed) : 0;
+    }
+    // Amount of the orders open on one side, in flight and resting
+    Qty openAmount(InstrumentId instrument, OrderSide side) const {
+        return Qty::fromRaw(instrument < capacity ? slots[instrument].open[side == OrderSide::Buy ? 0 : 1].load(std::memory_order_relaxed) : 0);
+    }
+    // Orders turned away for reason since start
+    uint64_t rejectCount(RiskReject reason) const {
+        return rejects[static_cast<int>(reason)].load(std::memory_order_relaxed);
+    }
+
+private:
+    struct LimitFields {
+        std::atomic<int64_t> maxOrderQty{0};
+        std::atomic<double> maxOrderNotional{0.0};
+        std::atomic<int64_t> maxPosition{0};
+        std::atomic<int32_t> collarBps{0};
+        std::atomic<uint32_t> maxOpenOrders{0};
+
+        void store(const RiskLimits& limits);
+        RiskLimits load() const;
+    };
+
+    // One cache line per instrument, so orders for different instruments don't contend
+    struct alignas(64) Slot {
+        LimitFields limits;
+        std::atomic<bool> hasLimits{false};
+        std::atomic<int32_t> inFlight{0};
+        std::atomic<int64_t> mid{0};          // Raw Price, 0 until the first book
+        std::atomic<int64_t> open[2] = {};    // Raw Qty open to buy, to sell
+    };
+
+    const uint32_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    LimitFields defaults;
+    std::atomic<bool> halted{false};
+    std::atomic<uint64_t> rejects[static_cast<int>(RiskReject::Count)] = {};
+
+    RiskReject reject(RiskReject reason) {
+        rejects[static_cast<int>(reason)].fetch_add(1, std::memory_order_relaxed);
+        return reason;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include<atomic>
+#include<cstddef>
+#include<cstdint>
+
+// Single-writer, multi-reader published state.
+//
+// The writer keeps its own working copy and, after a change, publishes it into
+// one of a few spare slots and flips the "current" index. Readers pin the
+// current slot with a per-slot reader count and read it in place: no lock, no
+// copy, and a consistent view for as long as they hold the Reader. The writer
+// only ever rebuilds slots that are neither current nor pinned, so it never
+// waits on a reader; if every spare slot is pinned it reports failure and the
+// caller simply publishes again later.
+template <typename T, size_t SlotCount = 4>
+class SnapshotBuffer {
+private:
+    static_assert(SlotCount >= 2, "Need a spare slot to publish into");
+
+    struct alignas(64) Slot {
+        std::atomic<int> readers{0};
+        uint64_t version = 0;
+        T value{};
+    };
+
+    mutable Slot slots[SlotCount];
+    std::atomic<size_t> current{0};
+    uint64_t lastVersion = 0;
+
+public:
+    // Pins one published snapshot until destroyed
+    class Reader {
+    private:
+        Slot* slot;
+
+    public:
+        explicit Reader(Slot* pinned) : slot(pinned) {}
+        Reader(Reader&& other) noexcept : slot(other.slot) { other.slot = nullptr; }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader() {
+            if (slot) slot->readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        const T& operator*() const { return slot->value; }
+        const T* operator->() const { return &slot->value; }
+        uint64_t version() const { return slot->version; }
+    };
+
+    Reader read() const {
+        while (true) {
+            size_t index = current.load(std::memory_order_seq_cst);
+            Slot& slot = slots[index];
+            slot.readers.fetch_add(1, std::memory_order_seq_cst);
+            // The writer may have moved on (and started reusing this slot) in between
+            if (current.load(std::memory_order_seq_cst) == index) {
+                return Reader(&slot);
+            }
+            slot.readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // Writer only: fill(T&) rebuilds a spare slot, which then becomes current.
+    // Returns false without calling fill if every spare slot is still being read.
+    template <typename Fill>
+    bool publish(Fill&& fill) {
+        size_t active = current.load(std::memory_order_relaxed);
+        for (size_t step = 1; step < SlotCount; ++step) {
+            size_t index = (active + step) % SlotCount;
+            Slot& slot = slots[index];
+            if (slot.readers.load(std::memory_order_seq_cst) != 0) continue;
+            fill(slot.value);
+            slot.version = ++lastVersion;
+            current.store(index, std::memory_order_seq_cst);
+            return true;
+        }
+        return false;
+    }
+
+    uint64_t version() const { return slots[current.load(std::memory_order_acquire)].version; }
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include<atomic>
+#include<cstddef>
+#include<utility>
+#include<vector>
+
+// Bounded single-producer/single-consumer ring.
+//
+// One thread pushes, one thread pops; neither ever takes a lock. Head and tail
+// live on their own cache lines and each side keeps a cached copy of the other
+// side's index, so the shared lines are only touched when the cached view says
+// the ring looks full/empty. Slots are constructed once up front and values are
+// moved in and out, so a ring of std::string hands buffers across threads
+// without copying them.
+template <typename T>
+class SpscRing {
+private:
+    static constexpr size_t CacheLine = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(CacheLine) std::atomic<size_t> head{0};    // Next slot to pop (consumer)
+    size_t cachedTail = 0;                             // Consumer's view of tail
+    alignas(CacheLine) std::atomic<size_t> tail{0};    // Next slot to push (producer)
+    size_t cachedHead = 0;                             // Producer's view of head
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Producer side. Returns false when full.
+    bool push(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) return false;
+        }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return mask + 1; }
+};
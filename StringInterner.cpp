@@ -0,0 +1,27 @@
+#include "StringInterner.h"
+
+StringInterner::StringInterner(uint32_t capacity)
+    : maxEntries(capacity), names(new std::string[capacity]) {
+    ids.reserve(capacity < 1024 ? capacity : 1024);
+}
+
+uint32_t StringInterner::intern(std::string_view s) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lookupKey.assign(s);
+    auto it = ids.find(lookupKey);
+    if (it != ids.end()) return it->second;
+
+    uint32_t id = count.load(std::memory_order_relaxed);
+    if (id >= maxEntries) return None;
+    names[id] = lookupKey;
+    ids.emplace(lookupKey, id);
+    count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+uint32_t StringInterner::find(std::string_view s) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    lookupKey.assign(s);
+    auto it = ids.find(lookupKey);
+    return it == ids.end() ? None : it->second;
+}
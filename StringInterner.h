@@ -0,0 +1,44 @@
+#pragma once
+#include<atomic>
+#include<cstdint>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<unordered_map>
+
+// Maps strings to small dense ids and back.
+//
+// Interning takes a lock and is meant for the first sighting of a name; after
+// that, code carries the 32-bit id and compares or indexes by it. Names live in
+// a fixed-capacity array that never moves, so name(id) is lock-free from any
+// thread for any id handed out so far.
+class StringInterner {
+public:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    explicit StringInterner(uint32_t capacity = 65536);
+
+    // Id of s, adding it if new. None once capacity is used up.
+    uint32_t intern(std::string_view s);
+
+    // Id of s, or None if it was never interned
+    uint32_t find(std::string_view s) const;
+
+    // Name of an id returned by intern(); empty for None
+    std::string_view name(uint32_t id) const {
+        if (id >= count.load(std::memory_order_acquire)) return {};
+        return names[id];
+    }
+
+    uint32_t size() const { return count.load(std::memory_order_acquire); }
+    uint32_t capacity() const { return maxEntries; }
+
+private:
+    uint32_t maxEntries;
+    std::unique_ptr<std::string[]> names;         // Written once per id, before count moves past it
+    std::atomic<uint32_t> count{0};
+    std::unordered_map<std::string, uint32_t> ids;
+    mutable std::string lookupKey;                 // Guarded by mutex
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,193 @@
+#include "SubscriptionManager.h"
+#include "Logger.h"
+#include <algorithm>
+#include <thread>
+
+static bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+ChannelKind classifyChannel(std::string_view channel) {
+    if (startsWith(channel, "book.")) return ChannelKind::Book;
+    if (startsWith(channel, "ticker.")) return ChannelKind::Ticker;
+    if (startsWith(channel, "trades.")) return ChannelKind::Trades;
+    if (startsWith(channel, "user.trades.")) return ChannelKind::UserTrades;
+    if (startsWith(channel, "user.orders.")) return ChannelKind::UserOrders;
+    return ChannelKind::Other;
+}
+
+void SubscriptionManager::RouteTable::add(std::string_view name, ChannelKind kind) {
+    routes.push_back(Route{std::string(name), kind});
+    // Keep the index at most half full
+    if (routes.size() * 2 > buckets.size()) {
+        buckets.assign(std::max<size_t>(64, buckets.size() * 2), Empty);
+        for (ChannelId id = 0; id + 1 < routes.size(); ++id) {
+            size_t bucket = std::hash<std::string_view>{}(routes[id].name) & (buckets.size() - 1);
+            while (buckets[bucket] != Empty) bucket = (bucket + 1) & (buckets.size() - 1);
+            buckets[bucket] = id;
+        }
+    }
+    size_t bucket = std::hash<std::string_view>{}(name) & (buckets.size() - 1);
+    while (buckets[bucket] != Empty) bucket = (bucket + 1) & (buckets.size() - 1);
+    buckets[bucket] = static_cast<ChannelId>(routes.size() - 1);
+}
+
+ChannelId SubscriptionManager::RouteTable::find(std::string_view name) const {
+    if (buckets.empty()) return NoChannel;
+    for (size_t bucket = std::hash<std::string_view>{}(name) & (buckets.size() - 1); buckets[bucket] != Empty;
+         bucket = (bucket + 1) & (buckets.size() - 1)) {
+        if (routes[buckets[bucket]].name == name) return buckets[bucket];
+    }
+    return NoChannel;
+}
+
+ChannelId SubscriptionManager::findLocked(std::string_view channel) const {
+    lookupKey.assign(channel.data(), channel.size());
+    auto it = ids.find(lookupKey);
+    return it == ids.end() ? NoChannel : it->second;
+}
+
+ChannelId SubscriptionManager::find(std::string_view channel) const {
+    return routes.read()->find(channel);
+}
+
+ChannelId SubscriptionManager::add(const std::string& channel) {
+    if (channel.empty()) return NoChannel;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, inserted] = ids.emplace(channel, static_cast<ChannelId>(channels.size()));
+    if (inserted) {
+        Channel entry;
+        entry.name = channel;
+        entry.kind = classifyChannel(channel);
+        entry.isPrivate = startsWith(channel, "user.");
+        routeTable.add(channel, entry.kind);
+        channels.push_back(std::move(entry));
+        // The dispatcher pins a snapshot only for the length of one lookup
+        while (!routes.publish([this](RouteTable& table) { table = routeTable; })) std::this_thread::yield();
+    }
+    ++channels[it->second].consumers;
+    return it->second;
+}
+
+bool SubscriptionManager::remove(const std::string& channel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ChannelId id = findLocked(channel);
+    if (id == NoChannel || channels[id].consumers == 0) return false;
+    --channels[id].consumers;
+    return true;
+}
+
+void SubscriptionManager::removeAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Channel& channel : channels) channel.consumers = 0;
+}
+
+static constexpr size_t NoBatch = SIZE_MAX;
+
+void SubscriptionManager::collect(std::vector<Batch>& batches) {
+    // Pending subscribes and unsubscribes, public and private, each split into requests of MaxChannelsPerRequest
+    static const char* const methods[4] = {"public/subscribe", "private/subscribe",
+                                           "public/unsubscribe", "private/unsubscribe"};
+    size_t open[4] = {NoBatch, NoBatch, NoBatch, NoBatch};
+    for (ChannelId id = 0; id < channels.size(); ++id) {
+        Channel& channel = channels[id];
+        bool wanted = channel.consumers > 0;
+        if (wanted == channel.live) continue;
+        int slot = (wanted ? 0 : 2) + (channel.isPrivate ? 1 : 0);
+        if (open[slot] == NoBatch || batches[open[slot]].channels.size() >= MaxChannelsPerRequest) {
+            open[slot] = batches.size();
+            batches.push_back(Batch{methods[slot], {}, {}});
+        }
+        batches[open[slot]].channels.push_back(channel.name);
+        batches[open[slot]].ids.push_back(id);
+        channel.live = wanted;
+    }
+}
+
+size_t SubscriptionManager::send(std::vector<Batch>& batches, const Sender& via) {
+    size_t sent = 0;
+    for (const Batch& batch : batches) {
+        if (via(batch.method, batch.channels)) {
+            ++sent;
+            continue;
+        }
+        // Not sent: put the channels back as pending so the next flush retries them
+        LOG_WARN("Could not send {} for {} channels", batch.method, batch.channels.size());
+        std::lock_guard<std::mutex> lock(mutex);
+        for (ChannelId id : batch.ids) channels[id].live = !channels[id].live;
+    }
+    return sent;
+}
+
+size_t SubscriptionManager::flush() {
+    std::vector<Batch> batches;
+    Sender via;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!sender) return 0;
+        collect(batches);
+        via = sender;
+    }
+    // Channels live in a deque that only grows, so the names the batches point at stay put while unlocked
+    return send(batches, via);
+}
+
+void SubscriptionManager::resubscribe(std::string_view channel) {
+    Sender via;
+    std::string name;
+    bool isPrivate = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ChannelId id = findLocked(channel);
+        if (!sender || id == NoChannel || !channels[id].live) return;
+        via = sender;
+        name = channels[id].name;
+        isPrivate = channels[id].isPrivate;
+    }
+    std::vector<std::string_view> one{name};
+    via(isPrivate ? "private/unsubscribe" : "public/unsubscribe", one);
+    via(isPrivate ? "private/subscribe" : "public/subscribe", one);
+}
+
+size_t SubscriptionManager::attach(Sender via) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sender = std::move(via);
+        for (Channel& channel : channels) channel.live = false;
+    }
+    size_t sent = flush();
+    LOG_INFO("Subscriptions attached: {} requests for {} channels", sent, activeChannels().size());
+    return sent;
+}
+
+void SubscriptionManager::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    sender = nullptr;
+    for (Channel& channel : channels) channel.live = false;
+}
+
+void SubscriptionManager::clearHandlers() {
+    for (Handler& handler : handlers) handler = nullptr;
+}
+
+bool SubscriptionManager::dispatch(const DeribitMessage& message) {
+    ChannelId id;
+    ChannelKind kind;
+    {
+        SnapshotBuffer<RouteTable>::Reader table = routes.read();
+        id = table->find(message.channel);
+        // Subscribed some other way: fall back to the name
+        kind = id == NoChannel ? classifyChannel(message.channel) : table->kind(id);
+    }
+    const Handler& handler = handlers[static_cast<int>(kind)];
+    return handler ? handler(id, message) : false;
+}
+
+std::vector<std::string> SubscriptionManager::activeChannels() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> active;
+    for (const Channel& channel : channels) {
+        if (channel.consumers > 0) active.push_back(channel.name);
+    }
+    return active;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include<cstddef>
+#include<cstdint>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<string>
+#include<string_view>
+#include<unordered_map>
+#include<vector>
+#include "MessageDecoder.h"
+#include "SnapshotBuffer.h"
+
+using ChannelId = uint32_t;
+constexpr ChannelId NoChannel = UINT32_MAX;
+
+// What a channel carries, worked out once from its name
+enum class ChannelKind : uint8_t {
+    Book,           // book.*
+    Ticker,         // ticker.*
+    Trades,         // trades.*
+    UserTrades,     // user.trades.*
+    UserOrders,     // user.orders.*
+    Other,
+    Count
+};
+
+ChannelKind classifyChannel(std::string_view channel);
+
+// The set of channels subscribed on the exchange, shared by every consumer and
+// kept across connections.
+//
+// Each channel is reference counted: the exchange subscription is made for the
+// first consumer and dropped with the last. add() and remove() only change the
+// counts; flush() turns every pending change into a few multi-channel
+// public/ and private/ subscribe and unsubscribe requests instead of one
+// request per channel.
+//
+// Channels get dense ids and their kind is decided when they are added, so
+// dispatch() is one lookup and an indexed call rather than a chain of prefix
+// compares. The lookup goes through a route table that add() rebuilds and
+// publishes through a SnapshotBuffer whenever a new channel appears, so the
+// dispatcher takes no lock and never waits on a thread subscribing. When the
+// connection goes, detach() marks everything unsubscribed; attach() on the
+// next connection subscribes again to whatever still has consumers.
+//
+// add/remove/flush may be called from any thread. Handlers are set once,
+// before notifications start flowing, and are called on the dispatcher thread;
+// reconnecting attaches again without touching them.
+class SubscriptionManager {
+public:
+    // Send one request for channels with method; false if it could not be sent
+    using Sender = std::function<bool(std::string_view method, const std::vector<std::string_view>& channels)>;
+    using Handler = std::function<bool(ChannelId id, const DeribitMessage& message)>;
+
+    // Channels per subscribe/unsubscribe request
+    static constexpr size_t MaxChannelsPerRequest = 64;
+
+    // Take one consumer's interest in channel. Returns its id (NoChannel for an empty name).
+    ChannelId add(const std::string& channel);
+    // Drop one consumer's interest. False if channel had no consumers.
+    bool remove(const std::string& channel);
+    // Drop every consumer of every channel
+    void removeAll();
+
+    // Send the pending changes, if attached. Returns the number of requests sent.
+    size_t flush();
+
+    // Unsubscribe and subscribe a live channel again, e.g. to get a fresh book snapshot
+    void resubscribe(std::string_view channel);
+
+    // A connection is up: requests go through sender, and every channel with consumers is subscribed again
+    size_t attach(Sender sender);
+    // The connection is gone: nothing is subscribed any more
+    void detach();
+
+    void setHandler(ChannelKind kind, Handler handler) { handlers[static_cast<int>(kind)] = std::move(handler); }
+    void clearHandlers();
+
+    // Route a notification to the handler of its channel's kind. False if none handled it.
+    bool dispatch(const DeribitMessage& message);
+
+    // Lock-free, like dispatch
+    ChannelId find(std::string_view channel) const;
+    // Channels with at least one consumer
+    std::vector<std::string> activeChannels() const;
+
+private:
+    struct Channel {
+        std::string name;
+        ChannelKind kind = ChannelKind::Other;
+        bool isPrivate = false;       // user.* channels need private/subscribe
+        uint32_t consumers = 0;
+        bool live = false;            // Subscribe request sent on the current connection
+    };
+
+    // One request's worth of channels
+    struct Batch {
+        const char* method;
+        std::vector<std::string_view> channels;
+        std::vector<ChannelId> ids;
+    };
+
+    // Name to id and kind of every channel ever added, in an open-addressed index.
+    // Ids are dense and never reused, so a channel's route is routes[id].
+    class RouteTable {
+    public:
+        void add(std::string_view name, ChannelKind kind);
+        ChannelId find(std::string_view name) const;
+        ChannelKind kind(ChannelId id) const { return routes[id].kind; }
+
+    private:
+        static constexpr uint32_t Empty = UINT32_MAX;
+        struct Route {
+            std::string name;
+            ChannelKind kind;
+        };
+        std::vector<Route> routes;
+        std::vector<uint32_t> buckets;                 // ChannelId per bucket, Empty when unused
+    };
+
+    mutable std::mutex mutex;
+    std::deque<Channel> channels;                      // Indexed by ChannelId; ids are never reused
+    std::unordered_map<std::string, ChannelId> ids;
+    mutable std::string lookupKey;                     // Guarded by mutex
+    RouteTable routeTable;                             // Guarded by mutex; the copy add() publishes
+    SnapshotBuffer<RouteTable> routes;                 // What dispatch reads
+    Sender sender;
+    Handler handlers[static_cast<int>(ChannelKind::Count)];
+
+    ChannelId findLocked(std::string_view channel) const;
+    // Caller holds mutex. Groups every pending change into batches, marking channels as sent.
+    void collect(std::vector<Batch>& batches);
+    size_t send(std::vector<Batch>& batches, const Sender& via);
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<mutex>
+#include<vector>
+#include "FixedPoint.h"
+#include "InstrumentRegistry.h"
+
+// One trade as shown on the tape
+struct TradePrint {
+    InstrumentId instrument = NoInstrument;
+    Price price;
+    Qty amount;
+    int64_t timestamp = 0;      // Exchange time, ms
+    bool buy = false;           // Taker side
+    bool own = false;           // One of our fills
+};
+
+// The last Capacity trades seen, public and our own, in a fixed ring: pushing
+// never allocates and old prints are simply overwritten. Written on the
+// dispatcher thread, copied out by the display.
+class TradeTape {
+public:
+    static constexpr size_t Capacity = 64;
+
+    void push(const TradePrint& print) {
+        std::lock_guard<std::mutex> lock(mutex);
+        prints[total % Capacity] = print;
+        ++total;
+    }
+
+    // Up to count of the newest prints, newest first
+    void latest(size_t count, std::vector<TradePrint>& out) const {
+        out.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t kept = total < Capacity ? static_cast<size_t>(total) : Capacity;
+        for (size_t i = 0; i < count && i < kept; ++i) {
+            out.push_back(prints[(total - 1 - i) % Capacity]);
+        }
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::array<TradePrint, Capacity> prints;
+    uint64_t total = 0;         // Prints ever pushed
+};
@@ -0,0 +1,130 @@
+// Receive path: nlohmann DOM double-parse (what on_message + processApiResponse
+// used to do) versus the single-pass MessageDecoder.
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include "MessageDecoder.h"
+#include "OrderBook.h"
+
+static std::string makeBookChange(int levels) {
+    std::string bids, asks;
+    for (int i = 0; i < levels; ++i) {
+        if (i) { bids += ","; asks += ","; }
+        bids += "[\"change\"," + std::to_string(64000.0 - i * 0.5) + "," + std::to_string(1000 + i * 10) + ".0]";
+        asks += "[\"new\"," + std::to_string(64000.5 + i * 0.5) + "," + std::to_string(2000 + i * 10) + ".0]";
+    }
+    return R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.BTC-PERPETUAL.100ms","data":{"type":"change","timestamp":1700000000000,"prev_change_id":1,"instrument_name":"BTC-PERPETUAL","change_id":2,"bids":[)"
+        + bids + R"(],"asks":[)" + asks + R"(]}}})";
+}
+
+static const std::string orderResult =
+    R"({"jsonrpc":"2.0","id":42,"result":{"trades":[{"trade_seq":1966056,"trade_id":"ETH-2696083","timestamp":1590483938456,"tick_direction":0,"state":"filled","self_trade":false,"reduce_only":false,"price":203.3,"post_only":false,"order_type":"market","order_id":"ETH-584849853","matching_id":null,"mark_price":203.28,"liquidity":"T","label":"market0000234","instrument_name":"ETH-PERPETUAL","index_price":203.33,"fee_currency":"ETH","fee":0.00014757,"direction":"buy","amount":40}],"order":{"web":false,"time_in_force":"good_til_cancelled","replaced":false,"reduce_only":false,"profit_loss":0.00022929,"price":207.3,"post_only":false,"order_type":"market","order_state":"filled","order_id":"ETH-584849853","max_show":40,"last_update_timestamp":1590483938456,"label":"market0000234","is_liquidation":false,"instrument_name":"ETH-PERPETUAL","filled_amount":40,"direction":"buy","creation_timestamp":1590483938456,"commission":0.00014757,"average_price":203.3,"api":true,"amount":40}},"usIn":1590483938454776,"usOut":1590483938456986,"usDiff":2210,"testnet":true})";
+
+// Old path: parse in on_message, parse again in processApiResponse, copy sub-objects
+static void BM_LegacyDoubleParse_BookChange(benchmark::State& state) {
+    std::string payload = makeBookChange(static_cast<int>(state.range(0)));
+    OrderBook book("BTC-PERPETUAL");
+    for (auto _ : state) {
+        auto jsonData = nlohmann::json::parse(payload);
+        auto again = nlohmann::json::parse(payload);
+        auto data = again["params"]["data"];
+        book.beginSnapshot(data["change_id"].get<int64_t>(), data["timestamp"].get<int64_t>());
+        for (const auto& level : data["bids"])
+            book.applyLevel(BookSide::Bid, BookAction::New, Price::fromDouble(level[1].get<double>()), Qty::fromDouble(level[2].get<double>()));
+        for (const auto& level : data["asks"])
+            book.applyLevel(BookSide::Ask, BookAction::New, Price::fromDouble(level[1].get<double>()), Qty::fromDouble(level[2].get<double>()));
+        book.endUpdate();
+        benchmark::DoNotOptimize(book.bestBid());
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_LegacyDoubleParse_BookChange)->Arg(10)->Arg(50);
+
+static void walkLevels(OrderBook& book, std::string_view levels, BookSide side) {
+    JsonCursor cur(levels);
+    std::string_view action;
+    Price price;
+    Qty amount;
+    cur.beginArray();
+    while (cur.nextElement()) {
+        cur.beginArray();
+        cur.nextElement(); cur.readString(action);
+        cur.nextElement(); cur.readFixed(price.raw);
+        cur.nextElement(); cur.readFixed(amount.raw);
+        cur.nextElement();
+        book.applyLevel(side, BookAction::New, price, amount);
+    }
+}
+
+static void BM_Decoder_BookChange(benchmark::State& state) {
+    std::string payload = makeBookChange(static_cast<int>(state.range(0)));
+    OrderBook book("BTC-PERPETUAL");
+    DeribitMessage message;
+    for (auto _ : state) {
+        decodeMessage(payload, message);
+        std::string_view bids, asks, key;
+        int64_t changeId = 0, timestamp = 0;
+        JsonCursor cur(message.data);
+        cur.beginObject();
+        while (cur.nextMember(key)) {
+            if (key == "change_id") cur.readInt(changeId);
+            else if (key == "timestamp") cur.readInt(timestamp);
+            else if (key == "bids") cur.readRaw(bids);
+            else if (key == "asks") cur.readRaw(asks);
+            else cur.skipValue();
+        }
+        book.beginSnapshot(changeId, timestamp);
+        walkLevels(book, bids, BookSide::Bid);
+        walkLevels(book, asks, BookSide::Ask);
+        book.endUpdate();
+        benchmark::DoNotOptimize(book.bestBid());
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+BENCHMARK(BM_Decoder_BookChange)->Arg(10)->Arg(50);
+
+static void BM_LegacyDoubleParse_OrderResult(benchmark::State& state) {
+    for (auto _ : state) {
+        auto jsonData = nlohmann::json::parse(orderResult);
+        if (jsonData.contains("result")) {
+            auto jsonResponse = nlohmann::json::parse(orderResult);
+            auto result = jsonResponse["result"];
+            auto orderId = result["order"]["order_id"].get<std::string>();
+            double price = result["order"]["average_price"].get<double>();
+            double amount = result["order"]["amount"].get<double>();
+            benchmark::DoNotOptimize(orderId);
+            benchmark::DoNotOptimize(price + amount);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * orderResult.size());
+}
+BENCHMARK(BM_LegacyDoubleParse_OrderResult);
+
+static void BM_Decoder_OrderResult(benchmark::State& state) {
+    DeribitMessage message;
+    for (auto _ : state) {
+        decodeMessage(orderResult, message);
+        std::string_view key, orderJson, orderId;
+        double price = 0.0, amount = 0.0;
+        JsonCursor cur(message.result);
+        cur.beginObject();
+        while (cur.nextMember(key)) {
+            if (key == "order") cur.readRaw(orderJson);
+            else cur.skipValue();
+        }
+        JsonCursor order(orderJson);
+        order.beginObject();
+        while (order.nextMember(key)) {
+            if (key == "order_id") order.readString(orderId);
+            else if (key == "average_price") order.readDouble(price);
+            else if (key == "amount") order.readDouble(amount);
+            else order.skipValue();
+        }
+        benchmark::DoNotOptimize(orderId);
+        benchmark::DoNotOptimize(price + amount);
+    }
+    state.SetBytesProcessed(state.iterations() * orderResult.size());
+}
+BENCHMARK(BM_Decoder_OrderResult);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,110 @@
+// Order entry: building requests as nlohmann::json trees + dump() versus
+// writing them into a reused buffer with RequestEncoder.
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include "RequestEncoder.h"
+
+static const std::string instrument = "BTC-PERPETUAL";
+static const std::string label = "strat-7";
+static const std::string orderId = "USDC-4758390217";
+static const Qty amount = Qty::fromDouble(40.0);
+static const Price price = Price::fromDouble(64000.5);
+
+static void BM_Json_Buy(benchmark::State& state) {
+    int id = 0;
+    for (auto _ : state) {
+        nlohmann::json requestJson = {
+            {"jsonrpc", "2.0"},
+            {"id", ++id},
+            {"method", "private/buy"},
+            {"params", {{"instrument_name", instrument}, {"amount", 40.0}, {"type", "limit"}, {"price", 64000.5}, {"label", label}}}};
+        std::string request = requestJson.dump();
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Json_Buy);
+
+static void BM_Encoder_Buy(benchmark::State& state) {
+    RequestEncoder encoder;
+    int id = 0;
+    for (auto _ : state) {
+        std::string_view request = encoder.order(++id, true, instrument, amount, OrderType::limit, price, label);
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Encoder_Buy);
+
+static void BM_Json_Sell(benchmark::State& state) {
+    int id = 0;
+    for (auto _ : state) {
+        nlohmann::json requestJson = {
+            {"jsonrpc", "2.0"},
+            {"id", ++id},
+            {"method", "private/sell"},
+            {"params", {{"instrument_name", instrument}, {"amount", 40.0}, {"type", "market"}, {"label", label}}}};
+        std::string request = requestJson.dump();
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Json_Sell);
+
+static void BM_Encoder_Sell(benchmark::State& state) {
+    RequestEncoder encoder;
+    int id = 0;
+    for (auto _ : state) {
+        std::string_view request = encoder.order(++id, false, instrument, amount, OrderType::market, std::nullopt, label);
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Encoder_Sell);
+
+static void BM_Json_Edit(benchmark::State& state) {
+    int id = 0;
+    for (auto _ : state) {
+        nlohmann::json editMsg = {
+            {"jsonrpc", "2.0"},
+            {"id", ++id},
+            {"method", "private/edit"},
+            {"params", {{"order_id", orderId}, {"amount", 50.0}, {"price", 64010.0}, {"post_only", true}, {"reduce_only", false}}}};
+        std::string request = editMsg.dump();
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Json_Edit);
+
+static void BM_Encoder_Edit(benchmark::State& state) {
+    RequestEncoder encoder;
+    int id = 0;
+    for (auto _ : state) {
+        std::string_view request = encoder.edit(++id, orderId, Qty::fromDouble(50.0), Price::fromDouble(64010.0), "", true, false);
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Encoder_Edit);
+
+static void BM_Json_Cancel(benchmark::State& state) {
+    int id = 0;
+    for (auto _ : state) {
+        nlohmann::json requestJson = {
+            {"jsonrpc", "2.0"},
+            {"id", ++id},
+            {"method", "private/cancel"},
+            {"params", {{"order_id", orderId}}}};
+        std::string request = requestJson.dump();
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Json_Cancel);
+
+static void BM_Encoder_Cancel(benchmark::State& state) {
+    RequestEncoder encoder;
+    int id = 0;
+    for (auto _ : state) {
+        std::string_view request = encoder.cancel(++id, orderId);
+        benchmark::DoNotOptimize(request.data());
+    }
+}
+BENCHMARK(BM_Encoder_Cancel);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,564 @@
+// Baseline for the trading hot paths: order parsing, request building,
+// response/notification handling, position queries and graph sampling.
+//
+// Besides Google Benchmark's throughput numbers every benchmark reports
+// allocs/op (global operator new is counted below) and the heavier ones also
+// report p50/p99/p999 latency from a per-op clock. Application chatter on
+// std::cout is discarded so it doesn't mix with the report.
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "OrderManager.h"
+#include "GraphWidget.h"
+#include "PriceSeries.h"
+#include "CandleStore.h"
+#include "BookAnalytics.h"
+#include "RiskGate.h"
+
+static std::atomic<uint64_t> allocations{0};
+
+// Kept out of line: once inlined into their callers, GCC sees malloc paired with operator
+// delete (or operator new with free) and warns -Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t align) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t alignment = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// Counts heap allocations made inside the timed loop
+class AllocCounter {
+private:
+    uint64_t start = allocations.load(std::memory_order_relaxed);
+
+public:
+    void report(benchmark::State& state) const {
+        state.counters["allocs/op"] = benchmark::Counter(
+            static_cast<double>(allocations.load(std::memory_order_relaxed) - start), benchmark::Counter::kAvgIterations);
+    }
+};
+
+// Per-op latencies; keeps the most recent 1M samples. Includes ~20ns of clock overhead.
+class LatencySamples {
+private:
+    static constexpr size_t Capacity = 1 << 20;
+    std::vector<uint32_t> samples;
+    size_t count = 0;
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    LatencySamples() { samples.resize(Capacity); }
+
+    int64_t start() const { return now(); }
+    void stop(int64_t started) {
+        int64_t took = now() - started;
+        samples[count++ & (Capacity - 1)] = static_cast<uint32_t>(std::min<int64_t>(took, UINT32_MAX));
+    }
+
+    void report(benchmark::State& state) {
+        size_t n = std::min(count, Capacity);
+        if (n == 0) return;
+        auto at = [&](double quantile) {
+            size_t k = std::min(n - 1, static_cast<size_t>(quantile * n));
+            std::nth_element(samples.begin(), samples.begin() + k, samples.begin() + n);
+            return static_cast<double>(samples[k]);
+        };
+        state.counters["p50_ns"] = at(0.50);
+        state.counters["p99_ns"] = at(0.99);
+        state.counters["p999_ns"] = at(0.999);
+    }
+};
+
+// Recorded Deribit payloads (testnet, trimmed of fields nobody reads)
+static const std::string buyResult =
+    R"({"jsonrpc":"2.0","id":42,"result":{"trades":[{"trade_seq":1966056,"trade_id":"ETH-2696083","timestamp":1590483938456,"tick_direction":0,"state":"filled","self_trade":false,"reduce_only":false,"price":203.3,"post_only":false,"order_type":"market","order_id":"ETH-584849853","matching_id":null,"mark_price":203.28,"liquidity":"T","label":"market0000234","instrument_name":"ETH-PERPETUAL","index_price":203.33,"fee_currency":"ETH","fee":0.00014757,"direction":"buy","amount":40}],"order":{"web":false,"time_in_force":"good_til_cancelled","replaced":false,"reduce_only":false,"profit_loss":0.00022929,"price":207.3,"post_only":false,"order_type":"market","order_state":"filled","order_id":"ETH-584849853","max_show":40,"last_update_timestamp":1590483938456,"label":"market0000234","is_liquidation":false,"instrument_name":"ETH-PERPETUAL","filled_amount":40,"direction":"buy","creation_timestamp":1590483938456,"commission":0.00014757,"average_price":203.3,"api":true,"amount":40}},"usIn":1590483938454776,"usOut":1590483938456986,"usDiff":2210,"testnet":true})";
+
+static const std::string cancelResult =
+    R"({"jsonrpc":"2.0","id":43,"result":{"triggered":false,"time_in_force":"good_til_cancelled","reduce_only":false,"profit_loss":0,"price":8948.5,"post_only":false,"order_type":"limit","order_state":"cancelled","order_id":"ETH-SLIS-12","max_show":5,"last_update_timestamp":1550219810944,"label":"","is_liquidation":false,"instrument_name":"ETH-PERPETUAL","filled_amount":0,"direction":"sell","creation_timestamp":1550219749176,"average_price":0,"api":false,"amount":5},"usIn":1550219810944000,"usOut":1550219810944900,"usDiff":900,"testnet":true})";
+
+static const std::string errorResult =
+    R"({"jsonrpc":"2.0","id":44,"error":{"message":"not_enough_funds","code":10009},"usIn":1590483938454776,"usOut":1590483938456986,"usDiff":2210,"testnet":true})";
+
+static const std::string tickerNotification =
+    R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"ticker.BTC-PERPETUAL.100ms","data":{"timestamp":1623060194301,"stats":{"volume_usd":284061480,"volume":7831.8,"price_change":-0.5,"low":35000,"high":37000},"state":"open","settlement_price":36297.02,"open_interest":502097590,"min_price":35898.37,"max_price":36991.72,"mark_price":36446.51,"last_price":36457.5,"interest_value":1.2,"instrument_name":"BTC-PERPETUAL","index_price":36441.64,"funding_8h":0.0000211,"estimated_delivery_price":36441.64,"current_funding":0,"best_bid_price":36442.5,"best_bid_amount":5000,"best_ask_price":36443,"best_ask_amount":100}}})";
+
+static std::string makeBookChange(int levels) {
+    std::string bids, asks;
+    for (int i = 0; i < levels; ++i) {
+        if (i) { bids += ","; asks += ","; }
+        bids += "[\"change\"," + std::to_string(64000.0 - i * 0.5) + "," + std::to_string(1000 + i * 10) + ".0]";
+        asks += "[\"new\"," + std::to_string(64000.5 + i * 0.5) + "," + std::to_string(2000 + i * 10) + ".0]";
+    }
+    return R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.BTC-PERPETUAL.raw","data":{"type":"snapshot","timestamp":1700000000000,"instrument_name":"BTC-PERPETUAL","change_id":1,"bids":[)"
+        + bids + R"(],"asks":[)" + asks + R"(]}}})";
+}
+
+// Order ack for a given request id and fill sequence, written into a reused buffer
+class AckBuilder {
+private:
+    std::string buffer;
+
+    void append(int64_t value) {
+        char digits[24];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        buffer.append(digits, end);
+    }
+
+public:
+    AckBuilder() { buffer.reserve(1024); }
+
+    const std::string& build(int64_t id, const std::string& orderId, int64_t tradeSeq) {
+        buffer.assign(R"({"jsonrpc":"2.0","id":)");
+        append(id);
+        buffer.append(R"(,"result":{"trades":[{"trade_seq":)");
+        append(tradeSeq);
+        buffer.append(R"(,"trade_id":"ETH-)");
+        append(tradeSeq);
+        buffer.append(R"(","timestamp":1590483938456,"price":203.3,"order_id":")");
+        buffer.append(orderId);
+        buffer.append(R"(","instrument_name":"ETH-PERPETUAL","fee_currency":"ETH","fee":0.00014757,"direction":"buy","amount":40}],"order":{"order_state":"filled","order_id":")");
+        buffer.append(orderId);
+        buffer.append(R"(","label":"market0000234","instrument_name":"ETH-PERPETUAL","direction":"buy","average_price":203.3,"amount":40}},"usIn":1590483938454776,"usOut":1590483938456986,"usDiff":2210,"testnet":true})");
+        return buffer;
+    }
+};
+
+static Order makeOrder(const std::string& instrument) {
+    return Order("bench", instrument, InstrumentType::Futures, "buy", "limit", 40, 203.3, std::nullopt, std::nullopt,
+                 std::string("market0000234"));
+}
+
+// Load a spec for each instrument through the instrument cache, as a restart would. Without one
+// the first order on an instrument fetches it, and that request takes the id the acks below expect.
+static void seedSpecs(OrderManager& manager, const std::vector<std::string>& instruments) {
+    InstrumentRegistry registry;
+    InstrumentSpec spec;
+    spec.tickSize = Price::fromDouble(0.05);
+    spec.contractSize = Qty::fromDouble(1.0);
+    spec.minTradeAmount = Qty::fromDouble(1.0);
+    for (const std::string& instrument : instruments) registry.setSpec(registry.intern(instrument), spec);
+    std::string path = (std::filesystem::temp_directory_path() / "bench_trading_instruments.cache").string();
+    registry.saveSnapshot(path);
+    manager.loadInstrumentCache(path);
+    std::remove(path.c_str());
+}
+
+// --- Order parsing ---------------------------------------------------------
+
+static void BM_Order_FromSimpleString(benchmark::State& state) {
+    const std::string input = "ORD-1 BTC-PERPETUAL Futures buy limit 40 64000.5 strat-7";
+    AllocCounter allocs;
+    for (auto _ : state) {
+        Order order = Order::fromSimpleString(input);
+        benchmark::DoNotOptimize(order.getAmount());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Order_FromSimpleString);
+
+// --- Request building ------------------------------------------------------
+
+static void BM_OrderManager_Subscribe(benchmark::State& state) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    const std::string channel = "book.BTC-PERPETUAL.100ms";
+    AllocCounter allocs;
+    for (auto _ : state) {
+        manager.subscribe(channel);
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderManager_Subscribe);
+
+// placeOrder (encode + track), then its acknowledgement with one fill
+static void BM_OrderManager_PlaceAndAck(benchmark::State& state) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    seedSpecs(manager, {"ETH-PERPETUAL"});
+    Order order = makeOrder("ETH-PERPETUAL");
+    AckBuilder ack;
+    const std::string orderId = "ETH-584849853";
+    int64_t id = 0;
+    LatencySamples latency;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        int64_t started = latency.start();
+        std::future<RpcResult> result = manager.placeOrder(order);
+        ++id;
+        manager.processApiResponse(ack.build(id, orderId, id));
+        latency.stop(started);
+        // The ack completes the order synchronously; if its id missed, waiting would hang
+        if (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready || !result.get().ok) {
+            state.SkipWithError("Order was not acknowledged");
+            break;
+        }
+    }
+    allocs.report(state);
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OrderManager_PlaceAndAck);
+
+// --- Response and notification handling -------------------------------------
+
+static void processRecorded(benchmark::State& state, const std::string& payload) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    LatencySamples latency;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        int64_t started = latency.start();
+        bool handled = manager.processApiResponse(payload);
+        latency.stop(started);
+        benchmark::DoNotOptimize(handled);
+    }
+    allocs.report(state);
+    latency.report(state);
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+static void BM_ProcessApiResponse_BuyResult(benchmark::State& state) { processRecorded(state, buyResult); }
+BENCHMARK(BM_ProcessApiResponse_BuyResult);
+
+static void BM_ProcessApiResponse_CancelResult(benchmark::State& state) { processRecorded(state, cancelResult); }
+BENCHMARK(BM_ProcessApiResponse_CancelResult);
+
+static void BM_ProcessApiResponse_Error(benchmark::State& state) { processRecorded(state, errorResult); }
+BENCHMARK(BM_ProcessApiResponse_Error);
+
+static void processNotification(benchmark::State& state, const std::string& payload, OrderManager& manager) {
+    DeribitMessage message;
+    LatencySamples latency;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        int64_t started = latency.start();
+        decodeMessage(payload, message);
+        bool handled = manager.processSubscription(message);
+        latency.stop(started);
+        benchmark::DoNotOptimize(handled);
+    }
+    allocs.report(state);
+    latency.report(state);
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+static void processNotification(benchmark::State& state, const std::string& payload) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    processNotification(state, payload, manager);
+}
+
+static void BM_ProcessSubscription_Ticker(benchmark::State& state) { processNotification(state, tickerNotification); }
+BENCHMARK(BM_ProcessSubscription_Ticker);
+
+static void BM_ProcessSubscription_BookSnapshot(benchmark::State& state) {
+    processNotification(state, makeBookChange(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_ProcessSubscription_BookSnapshot)->Arg(10)->Arg(100);
+
+// Ticker notification routed through a subscription table of state.range(0) channels
+static void BM_ProcessSubscription_Routed(benchmark::State& state) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    SubscriptionManager subscriptions;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        subscriptions.add("ticker.INSTRUMENT-" + std::to_string(i) + ".100ms");
+    }
+    subscriptions.add("ticker.BTC-PERPETUAL.100ms");
+    manager.setSubscriptions(&subscriptions);
+    processNotification(state, tickerNotification, manager);
+}
+BENCHMARK(BM_ProcessSubscription_Routed)->Arg(10)->Arg(250);
+
+// --- Position queries ------------------------------------------------------
+
+// getCurrentPositions after range(0) orders, each filled on one of up to 1000 instruments
+static void BM_GetCurrentPositions(benchmark::State& state) {
+    OrderManager manager(nullptr, websocketpp::connection_hdl());
+    std::vector<std::string> instruments;
+    for (int i = 0; i < 1000; ++i) instruments.push_back("INST-" + std::to_string(i));
+    seedSpecs(manager, instruments);
+    AckBuilder ack;
+    int64_t orders = state.range(0);
+    for (int64_t id = 1; id <= orders; ++id) {
+        manager.placeOrder(makeOrder("INST-" + std::to_string(id % 1000)));
+        std::string orderId = "ORD-" + std::to_string(id);
+        std::string payload = ack.build(id, orderId, id);
+        // Book the fill on the order's own instrument
+        size_t at = payload.find("ETH-PERPETUAL");
+        payload.replace(at, 13, "INST-" + std::to_string(id % 1000));
+        manager.processApiResponse(payload);
+    }
+    if (manager.pendingRequestCount() != 0) {
+        state.SkipWithError("Acknowledgements missed their orders");
+        return;
+    }
+
+    LatencySamples latency;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        int64_t started = latency.start();
+        auto positions = manager.getCurrentPositions();
+        latency.stop(started);
+        benchmark::DoNotOptimize(positions.size());
+    }
+    allocs.report(state);
+    latency.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetCurrentPositions)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// --- Book analytics --------------------------------------------------------
+
+// Signals for 50 books of range(0) levels a side, as after a tick touching every
+// instrument; range(1) 0 forces the scalar kernels
+static void BM_BookAnalytics_Compute(benchmark::State& state) {
+    size_t levels = static_cast<size_t>(state.range(0));
+    std::vector<std::unique_ptr<OrderBook>> books;
+    for (int b = 0; b < 50; ++b) {
+        auto book = std::make_unique<OrderBook>("BOOK-" + std::to_string(b));
+        book->beginSnapshot(1, 1);
+        for (size_t i = 0; i < levels; ++i) {
+            book->applyLevel(BookSide::Bid, BookAction::New, Price::fromRaw(toFixed(64000.0 - 0.5 * i)),
+                             Qty::fromRaw(toFixed(10.0 * ((i * 7 + b) % 13 + 1))));
+            book->applyLevel(BookSide::Ask, BookAction::New, Price::fromRaw(toFixed(64000.5 + 0.5 * i)),
+                             Qty::fromRaw(toFixed(10.0 * ((i * 5 + b) % 11 + 1))));
+        }
+        book->endUpdate();
+        books.push_back(std::move(book));
+    }
+    BookAnalytics::forceScalar(state.range(1) == 0);
+    state.SetLabel(BookAnalytics::kernels());
+    for (auto _ : state) {
+        for (const auto& book : books) {
+            BookSignals signals = BookAnalytics::compute(*book, levels, 30.0 * levels);
+            benchmark::DoNotOptimize(signals);
+        }
+    }
+    BookAnalytics::forceScalar(false);
+    state.SetItemsProcessed(state.iterations() * books.size());
+}
+BENCHMARK(BM_BookAnalytics_Compute)->Args({10, 0})->Args({10, 1})->Args({100, 0})->Args({100, 1})->Args({1000, 0})->Args({1000, 1});
+
+// --- Pre-trade risk --------------------------------------------------------
+
+// What placeOrder adds before sending: pin the published ledger and orders, look up
+// the instrument's position and resting orders, run every check, and release the
+// in-flight slot and open amount as the response would. Orders rotate over 64 instruments, each
+// with a position, a mid and range(0) resting orders; every limit is on and passes.
+static void BM_RiskGate_Admit(benchmark::State& state) {
+    constexpr InstrumentId Instruments = 64;
+    RiskGate gate;
+    RiskLimits limits;
+    limits.maxOrderQty = Qty::fromDouble(1000.0);
+    limits.maxOrderNotional = 1e8;
+    limits.maxPosition = Qty::fromDouble(100000.0);
+    limits.collarBps = 500;
+    limits.maxOpenOrders = static_cast<uint32_t>(state.range(0)) + 8;
+    gate.setDefaultLimits(limits);
+
+    PositionLedger ledger;
+    OrderStore store;
+    std::vector<CompactOrder> orders(Instruments);
+    for (InstrumentId id = 0; id < Instruments; ++id) {
+        gate.setMid(id, Price::fromDouble(64000.0 + id));
+        ledger.applyTrade(id, id % 2 == 0, Price::fromDouble(64000.0), Qty::fromDouble(10.0 * (id + 1)), 0.0, "BTC");
+        for (int64_t n = 0; n < state.range(0); ++n) {
+            CompactOrder resting;
+            resting.id.assign("R-" + std::to_string(id) + "-" + std::to_string(n));
+            resting.instrument = id;
+            store.insert(resting);
+        }
+        orders[id].instrument = id;
+        orders[id].side = id % 3 == 0 ? OrderSide::Sell : OrderSide::Buy;
+        orders[id].amount = toFixed(10.0);
+        orders[id].price = toFixed(64000.0 + id + (id % 7) * 5.0);
+        orders[id].flags |= CompactOrder::HasPrice;
+    }
+    SnapshotBuffer<PositionLedger> positions;
+    positions.publish([&](PositionLedger& snapshot) { snapshot = ledger; });
+    SnapshotBuffer<OrderStore> resting;
+    resting.publish([&](OrderStore& snapshot) { snapshot = store; });
+
+    LatencySamples latency;
+    AllocCounter allocs;
+    uint64_t rejected = 0;
+    size_t next = 0;
+    for (auto _ : state) {
+        const CompactOrder& order = orders[next++ & (Instruments - 1)];
+        int64_t started = latency.start();
+        SnapshotBuffer<PositionLedger>::Reader ledgerView = positions.read();
+        const Position* position = ledgerView->find(order.instrument);
+        SnapshotBuffer<OrderStore>::Reader ordersView = resting.read();
+        RiskReject verdict = gate.admit(order, position ? position->size : Qty(), ordersView->countIn(order.instrument));
+        latency.stop(started);
+        if (verdict == RiskReject::None)
+            gate.release(order);
+        else
+            ++rejected;
+    }
+    allocs.report(state);
+    latency.report(state);
+    state.counters["rejected"] = static_cast<double>(rejected);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RiskGate_Admit)->Arg(0)->Arg(50);
+
+// --- Latency recording -----------------------------------------------------
+
+// Cost the instrumentation adds to every order round trip
+static void BM_LatencyHistogram_Record(benchmark::State& state) {
+    static LatencyHistogram histogram;
+    int64_t value = 1000;
+    for (auto _ : state) {
+        histogram.record(value);
+        value = (value * 1103515245 + 12345) & 0xFFFFF;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LatencyHistogram_Record)->Threads(1)->Threads(4);
+
+// --- Graph sampling --------------------------------------------------------
+
+static std::vector<double> makeSeries(size_t points) {
+    std::vector<double> series(points);
+    double price = 64000.0;
+    for (size_t i = 0; i < points; ++i) {
+        price += ((i * 7919) % 13) - 6.0;
+        series[i] = price;
+    }
+    return series;
+}
+
+static void BM_GraphUtils_NormalizeData(benchmark::State& state) {
+    std::vector<double> series = makeSeries(static_cast<size_t>(state.range(0)));
+    AllocCounter allocs;
+    for (auto _ : state) {
+        std::vector<int> scaled = GraphUtils::NormalizeData(series, 10);
+        benchmark::DoNotOptimize(scaled.data());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations() * series.size());
+}
+BENCHMARK(BM_GraphUtils_NormalizeData)->Arg(50)->Arg(1000)->Arg(100000);
+
+// What PlotLineGraph's graph function does on every render
+static void BM_GraphUtils_PlotLineGraphSampling(benchmark::State& state) {
+    std::vector<double> series = makeSeries(static_cast<size_t>(state.range(0)));
+    AllocCounter allocs;
+    for (auto _ : state) {
+        std::vector<int> scaled = GraphUtils::NormalizeData(GraphUtils::SampleForWidth(series, 200), 10);
+        benchmark::DoNotOptimize(scaled.data());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GraphUtils_PlotLineGraphSampling)->Arg(1000)->Arg(100000);
+
+static void BM_GraphUtils_PlotLineGraph(benchmark::State& state) {
+    std::vector<double> series = makeSeries(static_cast<size_t>(state.range(0)));
+    AllocCounter allocs;
+    for (auto _ : state) {
+        ftxui::Element graph = GraphUtils::PlotLineGraph(series, "BTC-PERPETUAL");
+        benchmark::DoNotOptimize(graph.get());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GraphUtils_PlotLineGraph)->Arg(1000)->Arg(100000);
+
+// Recording one price into a full history: ring write plus the monotonic min/max queues
+static void BM_PriceSeries_Push(benchmark::State& state) {
+    std::vector<double> prices = makeSeries(4096);
+    PriceSeries series(PriceHistory::DefaultCapacity);
+    for (size_t i = 0; i < series.capacity(); ++i) series.push(prices[i % prices.size()]);
+    size_t i = 0;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        series.push(prices[i++ & 4095]);
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PriceSeries_Push);
+
+// What a live chart's graph function does on every frame: downsample into a reused buffer
+static void BM_PriceSeries_Downsample(benchmark::State& state) {
+    std::vector<double> prices = makeSeries(static_cast<size_t>(state.range(0)));
+    PriceSeries series(PriceHistory::DefaultCapacity);
+    for (double price : prices) series.push(price);
+    std::vector<double> sampled;
+    std::vector<int> scaled;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        series.downsample(200, sampled);
+        SeriesSummary summary = series.summary();
+        GraphUtils::NormalizeInto(sampled, summary.min, summary.max, 10, scaled);
+        benchmark::DoNotOptimize(scaled.data());
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PriceSeries_Downsample)->Arg(1000)->Arg(100000);
+
+// One trade into all four timeframes' candles (memory-mapped anonymously, no files)
+static void BM_CandleStore_AddTrade(benchmark::State& state) {
+    CandleStore store(4096);
+    int64_t timestampMs = 1700000000000;
+    int64_t tradeSeq = 0;
+    AllocCounter allocs;
+    for (auto _ : state) {
+        timestampMs += 37;      // A candle closes every ~27 trades in the 1s timeframe
+        ++tradeSeq;
+        store.addTrade(0, "BTC-PERPETUAL", timestampMs, tradeSeq, Price::fromRaw(toFixed(64000.0) + (tradeSeq & 63)),
+                       Qty::fromRaw(toFixed(10.0)));
+    }
+    allocs.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CandleStore_AddTrade);
+
+// Swallows writes without touching a terminal
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    std::ostream report(std::cout.rdbuf());
+    NullBuffer discard;
+    std::cout.rdbuf(&discard);
+
+    benchmark::ConsoleReporter reporter;
+    reporter.SetOutputStream(&report);
+    reporter.SetErrorStream(&std::cerr);
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    std::cout.rdbuf(report.rdbuf());
+    return 0;
+}
@@ -1,17 +1,157 @@
 #include "menu.h"
+#include "GraphWidget.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <thread>
 
 using namespace ftxui;
 
-void Menu::showInteractiveMenu(OrderManager* manager) {
-    auto screen = ScreenInteractive::Fullscreen();
+// Redraws of the dashboard are capped at this rate however fast the data changes
+static constexpr int DashboardFps = 30;
+static constexpr size_t LadderDepth = 10;
+static constexpr size_t PanelRows = 12;
+// Book signals use the ladder's levels and quote fills of this many minimum trade amounts
+static constexpr double SignalFillLots = 100;
+
+static Element dashboardPanel(const std::string& title, const std::vector<std::string>& rows) {
+    Elements lines;
+    lines.push_back(text(title) | bold | color(Color::Blue));
+    lines.push_back(separator());
+    for (const std::string& row : rows) {
+        lines.push_back(text(row));
+    }
+    return vbox(lines) | border | flex;
+}
+
+// Last traded prices of instrument; the series is read in place when the frame is drawn
+static Element priceChart(OrderManager* manager, const std::string& instrument) {
+    const PriceSeries* series = instrument.empty() ? nullptr : manager->getPriceSeries(instrument);
+    if (!series) return text("Subscribe to ticker.* or trades.* for a price chart") | dim | border;
+    return GraphUtils::PlotPriceMovement(*series, "Last price");
+}
+
+static std::string formatRow(const char* format, ...) {
+    char row[128];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(row, sizeof(row), format, args);
+    va_end(args);
+    return row;
+}
+
+// Currency PnL of a position is in: the base coin of inverse contracts (BTC of BTC-PERPETUAL),
+// the quote of linear ones (USDC of BTC_USDC-PERPETUAL)
+static std::string pnlCurrency(const std::string& instrument, bool inverse) {
+    std::string underlying = instrument.substr(0, instrument.find('-'));
+    size_t separator = underlying.find('_');
+    if (inverse) return underlying.substr(0, separator);
+    return separator == std::string::npos ? underlying : underlying.substr(separator + 1);
+}
+
+void Menu::nextBookInstrument(OrderManager* manager) {
+    std::vector<std::string> instruments = manager->getBookInstruments();
+    if (instruments.empty()) return;
+    std::sort(instruments.begin(), instruments.end());
+    auto it = std::upper_bound(instruments.begin(), instruments.end(), dashboard.bookInstrument);
+    dashboard.bookInstrument = it == instruments.end() ? instruments.front() : *it;
+}
+
+// Rebuild the rows of the given panels from the manager's snapshots. UI thread only.
+void Menu::refreshDashboard(OrderManager* manager, uint32_t panels) {
+    const InstrumentRegistry& instruments = manager->getInstruments();
+
+    if (panels & DirtyFlags::Book) {
+        dashboard.book.clear();
+        if (dashboard.bookInstrument.empty()) nextBookInstrument(manager);
+        BookTop top;
+        dashboard.bookTitle = "Book " + dashboard.bookInstrument;
+        if (dashboard.bookInstrument.empty() || !manager->getBookTop(dashboard.bookInstrument, LadderDepth, top)) {
+            dashboard.bookTitle = "Book";
+            dashboard.book.push_back("Subscribe to a book.* channel");
+        } else if (!top.synced) {
+            dashboard.book.push_back("Resyncing...");
+        } else {
+            dashboard.book.push_back(formatRow("%12s %12s | %-12s %-12s", "Bid size", "Bid", "Ask", "Ask size"));
+            for (size_t i = 0; i < std::max(top.bids.size(), top.asks.size()); ++i) {
+                std::string bidSize = i < top.bids.size() ? top.bids[i].amount.toString() : "";
+                std::string bid = i < top.bids.size() ? top.bids[i].price.toString() : "";
+                std::string ask = i < top.asks.size() ? top.asks[i].price.toString() : "";
+                std::string askSize = i < top.asks.size() ? top.asks[i].amount.toString() : "";
+                dashboard.book.push_back(formatRow("%12s %12s | %-12s %-12s", bidSize.c_str(), bid.c_str(), ask.c_str(),
+                                                   askSize.c_str()));
+            }
+            InstrumentSpec spec;
+            double fillSize = instruments.spec(instruments.find(dashboard.bookInstrument), spec)
+                                  ? spec.minTradeAmount.toDouble() * SignalFillLots : 0.0;
+            BookSignals signals;
+            if (manager->getBookSignals(dashboard.bookInstrument, LadderDepth, fillSize, signals) && signals.valid) {
+                dashboard.book.push_back(formatRow("Imbalance %+.3f  Micro %.2f  Weighted mid %.2f  spread %.2f",
+                                                   signals.imbalance, signals.microprice, signals.weightedMid,
+                                                   signals.weightedSpread));
+                if (fillSize > 0.0) {
+                    dashboard.book.push_back(formatRow("Fill %g: buy @ %.2f  sell @ %.2f  (%s)", fillSize, signals.buyPrice,
+                                                       signals.sellPrice, BookAnalytics::kernels()));
+                }
+            }
+        }
+    }
 
+    if (panels & DirtyFlags::Orders) {
+        dashboard.orders.clear();
+        OrdersSnapshot orders = manager->getOrdersSnapshot();
+        orders->forEach([&](const CompactOrder& order) {
+            if (dashboard.orders.size() >= PanelRows || order.filledAmount >= order.amount) return;
+            std::string instrument(instruments.name(order.instrument));
+            std::string price = order.hasPrice() ? Price::fromRaw(order.price).toString() : "market";
+            dashboard.orders.push_back(formatRow("%-16.*s %-18s %-4s %s/%s @ %s", static_cast<int>(order.id.length),
+                                                 order.id.text, instrument.c_str(),
+                                                 order.side == OrderSide::Buy ? "buy" : "sell",
+                                                 Qty::fromRaw(order.filledAmount).toString().c_str(),
+                                                 Qty::fromRaw(order.amount).toString().c_str(), price.c_str()));
+        });
+        if (dashboard.orders.empty()) dashboard.orders.push_back("No open orders");
+    }
+
+    if (panels & DirtyFlags::Positions) {
+        dashboard.positions.clear();
+        PositionsSnapshot ledger = manager->getPositionsSnapshot();
+        for (size_t slot = 0; slot < ledger->size() && dashboard.positions.size() < PanelRows; ++slot) {
+            const Position& position = ledger->positionAt(slot);
+            std::string instrument(instruments.name(ledger->instrumentAt(slot)));
+            dashboard.positions.push_back(formatRow("%-18s %10s @ %-10s uPnL %.6f %s", instrument.c_str(),
+                                                    position.size.toString().c_str(),
+                                                    position.avgEntryPrice.toString().c_str(), position.unrealizedPnl,
+                                                    pnlCurrency(instrument, position.inverse).c_str()));
+        }
+        if (dashboard.positions.empty()) dashboard.positions.push_back("No positions");
+    }
+
+    if (panels & DirtyFlags::Trades) {
+        dashboard.trades.clear();
+        std::vector<TradePrint> prints;
+        manager->getRecentTrades(PanelRows, prints);
+        for (const TradePrint& print : prints) {
+            std::string instrument(instruments.name(print.instrument));
+            dashboard.trades.push_back(formatRow("%s %-18s %-4s %10s @ %s", print.own ? "*" : " ", instrument.c_str(),
+                                                 print.buy ? "buy" : "sell", print.amount.toString().c_str(),
+                                                 print.price.toString().c_str()));
+        }
+        if (dashboard.trades.empty()) dashboard.trades.push_back("No trades yet");
+    }
+}
+
+void Menu::showInteractiveMenu(OrderManager* manager) {
     while (true) {
         std::vector<std::string> menu_entries = {
-            "Place Order", "Cancel Order", "Modify Order", "View Current Positions",
+            "Place Order", "Cancel Order", "Modify Order", "Place Orders from File", "Mass Cancel", "View Current Positions",
             "Get Order History by Currency", "Get Order History by Instrument", "Stream Market Data",
             "Get Summary by Instrument", "Get Summary by Currency", "Get Ticker Data",
             "Get Contract Size", "Get All Supported Currencies", "Subscribe to Channel",
-            "Unsubscribe from Channel", "Unsubscribe All", "Exit",
+            "Unsubscribe from Channel", "Unsubscribe All", "View Order Book", "Pipeline Stats", "Memory Pools", "Order Latency", "Candles", "Risk Limits", "Exit",
         };
 
         int selected = 0;
@@ -19,6 +159,10 @@ void Menu::showInteractiveMenu(OrderManager* manager) {
         menu_option.on_enter = screen.ExitLoopClosure();
         auto menu = ftxui::Menu(&menu_entries, &selected, menu_option);
 
+        // Panels changed since they were last rebuilt; a dialog may have been open for a while, so start with all
+        std::atomic<uint32_t> stale{DirtyFlags::All};
+        std::atomic<bool> framePending{false};
+
         // Handle escape key
         menu |= CatchEvent([&](Event event) {
             if (event == Event::Character('q') || event == Event::Escape) {
@@ -26,38 +170,87 @@ void Menu::showInteractiveMenu(OrderManager* manager) {
                 screen.ExitLoopClosure()();
                 return true;
             }
+            if (event == Event::Character('b')) {
+                nextBookInstrument(manager);
+                stale.fetch_or(DirtyFlags::Book);
+                return true;
+            }
+            if (event == Event::Character('k')) {
+                manager->haltTrading(!manager->isTradingHalted());
+                return true;
+            }
             return false;
         });
 
         auto renderer = Renderer(menu, [&] {
+            framePending = false;
+            uint32_t panels = stale.exchange(0);
+            if (panels) refreshDashboard(manager, panels);
+
             std::vector<Element> elements;
             elements.push_back(text("Trading System Menu") | bold | color(Color::Blue) | center);
             elements.push_back(separator());
             elements.push_back(menu->Render() | vscroll_indicator | frame | size(HEIGHT, LESS_THAN, 18));
-            
-            return vbox(elements) | border | center;
+            elements.push_back(separator());
+            elements.push_back(text("b: next book  k: kill switch  q: exit") | dim);
+            if (manager->isTradingHalted()) {
+                elements.push_back(text("TRADING HALTED") | bold | color(Color::Red) | center);
+            }
+
+            return hbox({
+                vbox(elements) | border,
+                vbox({dashboardPanel(dashboard.bookTitle, dashboard.book), priceChart(manager, dashboard.bookInstrument),
+                      dashboardPanel("Open Orders", dashboard.orders)}) | flex,
+                vbox({dashboardPanel("Positions", dashboard.positions), dashboardPanel("Recent Trades", dashboard.trades)}) | flex,
+            });
         });
 
+        // Market data only sets flags; this thread turns them into at most one redraw per frame, and
+        // none while the last one is still queued. Rendering itself stays on the UI thread.
+        std::atomic<bool> running{true};
+        std::thread ticker([&] {
+            auto next = std::chrono::steady_clock::now();
+            while (running) {
+                next += std::chrono::microseconds(1000000 / DashboardFps);
+                std::this_thread::sleep_until(next);
+                if (!changes || framePending) continue;
+                uint32_t panels = changes->take();
+                if (!panels) continue;
+                stale.fetch_or(panels);
+                framePending = true;
+                screen.PostEvent(Event::Custom);
+            }
+        });
         screen.Loop(renderer);
+        running = false;
+        ticker.join();
 
         // Process the selected option
         switch (selected) {
             case 0: placeOrderMenuFTXUI(manager); break;
             case 1: cancelOrderMenuFTXUI(manager); break;
             case 2: modifyOrderMenuFTXUI(manager); break;
-            case 3: viewPositionsMenuFTXUI(manager); break;
-            case 4: getOrderHistoryByCurrencyMenuFTXUI(manager); break;
-            case 5: getOrderHistoryByInstrumentMenuFTXUI(manager); break;
-            case 6: streamMarketDataMenuFTXUI(manager); break;
-            case 7: getSummaryByInstrumentMenuFTXUI(manager); break;
-            case 8: getSummaryByCurrencyMenuFTXUI(manager); break;
-            case 9: getTickerDataMenuFTXUI(manager); break;
-            case 10: getContractSizeMenuFTXUI(manager); break;
-            case 11: getAllSupportedCurrenciesMenuFTXUI(manager); break;
-            case 12: subscribeMenuFTXUI(manager); break;
-            case 13: unsubscribeMenuFTXUI(manager); break;
-            case 14: unsubscribeAllMenuFTXUI(manager); break;
-            case 15: 
+            case 3: placeOrdersFromFileMenuFTXUI(manager); break;
+            case 4: massCancelMenuFTXUI(manager); break;
+            case 5: viewPositionsMenuFTXUI(manager); break;
+            case 6: getOrderHistoryByCurrencyMenuFTXUI(manager); break;
+            case 7: getOrderHistoryByInstrumentMenuFTXUI(manager); break;
+            case 8: streamMarketDataMenuFTXUI(manager); break;
+            case 9: getSummaryByInstrumentMenuFTXUI(manager); break;
+            case 10: getSummaryByCurrencyMenuFTXUI(manager); break;
+            case 11: getTickerDataMenuFTXUI(manager); break;
+            case 12: getContractSizeMenuFTXUI(manager); break;
+            case 13: getAllSupportedCurrenciesMenuFTXUI(manager); break;
+            case 14: subscribeMenuFTXUI(manager); break;
+            case 15: unsubscribeMenuFTXUI(manager); break;
+            case 16: unsubscribeAllMenuFTXUI(manager); break;
+            case 17: viewOrderBookMenuFTXUI(manager); break;
+            case 18: viewPipelineStatsMenuFTXUI(); break;
+            case 19: viewMemoryStatsMenuFTXUI(manager); break;
+            case 20: viewLatencyStatsMenuFTXUI(); break;
+            case 21: viewCandlesMenuFTXUI(manager); break;
+            case 22: riskLimitsMenuFTXUI(manager); break;
+            case 23:
                 return;
         }
     }
@@ -65,7 +258,6 @@ void Menu::showInteractiveMenu(OrderManager* manager) {
 
 // Helper function for input dialogs
 std::string Menu::showInputDialog(const std::string& title, const std::string& prompt) {
-    auto screen = ScreenInteractive::Fullscreen();
     std::string input;
     bool submit = false;
     bool cancel = false;
@@ -100,7 +292,6 @@ std::string Menu::showInputDialog(const std::string& title, const std::string& p
 
 // Helper function for message dialogs
 void Menu::showMessageDialog(const std::string& message, ftxui::Color msg_color) {
-    auto screen = ScreenInteractive::Fullscreen();
     auto ok_button = Button("OK", [&] { screen.Exit(); });
 
     auto renderer = Renderer(ok_button, [&] {
@@ -115,6 +306,20 @@ elements.push_back(text(message) | color(msg_color) | center);
     screen.Loop(renderer);
 }
 
+void Menu::showAckDialog(std::future<RpcResult>& ack, const std::string& action) {
+    if (ack.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+        showMessageDialog(action + " sent, awaiting acknowledgement", Color::Yellow);
+        return;
+    }
+    RpcResult result = ack.get();
+    if (result.ok) {
+        std::string detail = result.orderId.empty() ? "" : ": " + result.orderId + " (" + result.orderState + ")";
+        showMessageDialog(action + " acknowledged" + detail, Color::Green);
+    } else {
+        showMessageDialog(action + " rejected: " + result.errorMessage, Color::Red);
+    }
+}
+
 // FTXUI version of placeOrderMenu
 void Menu::placeOrderMenuFTXUI(OrderManager* manager) {
     if (!manager) {
@@ -152,13 +357,86 @@ void Menu::placeOrderMenuFTXUI(OrderManager* manager) {
         InstrumentType instrumentType = parseInstrumentType(instrTypeStr);
         
         Order order(orderId, instrumentName, instrumentType, side, orderTypeStr, amount, price, std::nullopt, std::nullopt, label);
-        manager->placeOrder(order);
-        showMessageDialog("Order placed successfully!", Color::Green);
+        auto ack = manager->placeOrder(order);
+        showAckDialog(ack, "Order");
     } catch (const std::exception& e) {
         showMessageDialog("Error: " + std::string(e.what()), Color::Red);
     }
 }
 
+// Load orders from a file (one per line, space or comma separated) and send them as one batch
+void Menu::placeOrdersFromFileMenuFTXUI(OrderManager* manager) {
+    if (!manager) {
+        showMessageDialog("Manager is null!", Color::Red);
+        return;
+    }
+
+    std::string path = showInputDialog("Place Orders from File", "File (id instrument type side order_type amount price label)");
+    if (path.empty()) return;
+
+    std::vector<std::string> errors;
+    std::vector<Order> orders = Order::fromFile(path, errors);
+    if (orders.empty()) {
+        showMessageDialog(errors.empty() ? "No orders in " + path : errors.front(), Color::Red);
+        return;
+    }
+    if (!errors.empty()) {
+        std::string confirm = showInputDialog("Place Orders from File",
+                                              std::to_string(errors.size()) + " lines skipped (first: " + errors.front() +
+                                                  "). Send the other " + std::to_string(orders.size()) + "? (y/n)");
+        if (confirm != "y" && confirm != "Y") return;
+    }
+
+    std::vector<std::future<RpcResult>> acks = manager->placeOrders(orders);
+
+    // Wait up to two seconds in total for the batch to be acknowledged
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    size_t accepted = 0, rejected = 0, pending = 0;
+    std::string firstError;
+    for (std::future<RpcResult>& ack : acks) {
+        if (ack.wait_until(deadline) != std::future_status::ready) {
+            ++pending;
+            continue;
+        }
+        RpcResult result = ack.get();
+        if (result.ok) {
+            ++accepted;
+        } else {
+            if (firstError.empty()) firstError = result.errorMessage;
+            ++rejected;
+        }
+    }
+
+    std::string summary = std::to_string(acks.size()) + " orders sent: " + std::to_string(accepted) + " acknowledged, " +
+                          std::to_string(rejected) + " rejected, " + std::to_string(pending) + " awaiting acknowledgement";
+    if (!firstError.empty()) summary += "\nFirst rejection: " + firstError;
+    showMessageDialog(summary, rejected ? Color::Yellow : Color::Green);
+}
+
+// Cancel every order of an instrument, or every order with a label
+void Menu::massCancelMenuFTXUI(OrderManager* manager) {
+    if (!manager) {
+        showMessageDialog("Manager is null!", Color::Red);
+        return;
+    }
+
+    std::string target = showInputDialog("Mass Cancel", "Instrument name, or label:<label>");
+    if (target.empty()) return;
+
+    std::future<RpcResult> ack = target.compare(0, 6, "label:") == 0 ? manager->cancelByLabel(target.substr(6))
+                                                                      : manager->cancelAllByInstrument(target);
+    if (ack.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+        showMessageDialog("Mass cancel sent, awaiting acknowledgement", Color::Yellow);
+        return;
+    }
+    RpcResult result = ack.get();
+    if (result.ok) {
+        showMessageDialog(std::to_string(result.cancelledCount) + " orders cancelled", Color::Green);
+    } else {
+        showMessageDialog("Mass cancel rejected: " + result.errorMessage, Color::Red);
+    }
+}
+
 // FTXUI version of cancelOrderMenu
 void Menu::cancelOrderMenuFTXUI(OrderManager* manager) {
     if (!manager) {
@@ -168,8 +446,8 @@ void Menu::cancelOrderMenuFTXUI(OrderManager* manager) {
 
     std::string orderId = showInputDialog("Cancel Order", "Order ID to cancel");
     if (!orderId.empty()) {
-        manager->cancelOrder(orderId);
-        showMessageDialog("Order cancellation requested!", Color::Yellow);
+        auto ack = manager->cancelOrder(orderId);
+        showAckDialog(ack, "Cancellation");
     }
 }
 
@@ -203,8 +481,8 @@ void Menu::modifyOrderMenuFTXUI(OrderManager* manager) {
         bool post_only = (postOnlyStr == "true" || postOnlyStr == "1");
         bool reduce_only = (reduceOnlyStr == "true" || reduceOnlyStr == "1");
 
-        manager->modifyOrder(orderId, newPrice, newAmount, advanced, post_only, reduce_only);
-        showMessageDialog("Order modification requested!", Color::Yellow);
+        auto ack = manager->modifyOrder(orderId, newPrice, newAmount, advanced, post_only, reduce_only);
+        showAckDialog(ack, "Modification");
     } catch (const std::exception& e) {
         showMessageDialog("Error: " + std::string(e.what()), Color::Red);
     }
@@ -217,13 +495,22 @@ void Menu::viewPositionsMenuFTXUI(OrderManager* manager) {
         return;
     }
 
-    auto positions = manager->getCurrentPositions();
+    auto ledger = manager->getPositionsSnapshot();
     std::string positionsText = "Current Positions:\n";
-    for (const auto& pair : positions) {
-        positionsText += pair.first + ": " + std::to_string(pair.second) + "\n";
+    for (size_t slot = 0; slot < ledger->size(); ++slot) {
+        const Position& position = ledger->positionAt(slot);
+        std::string instrument(manager->getInstruments().name(ledger->instrumentAt(slot)));
+        std::string currency = " " + pnlCurrency(instrument, position.inverse);
+        positionsText += instrument + ": " + position.size.toString() +
+                         " @ " + position.avgEntryPrice.toString() +
+                         "  uPnL " + std::to_string(position.unrealizedPnl) + currency +
+                         "  rPnL " + std::to_string(position.realizedPnl) + currency + "\n";
+    }
+    for (const FeeTotal& fee : ledger->feesByCurrency()) {
+        positionsText += "Fees " + fee.currency + ": " + std::to_string(fee.total) + "\n";
     }
     
-    if (positions.empty()) {
+    if (ledger->size() == 0) {
         positionsText = "No current positions";
     }
     
@@ -322,10 +609,23 @@ void Menu::getContractSizeMenuFTXUI(OrderManager* manager) {
     }
 
     std::string instrument = showInputDialog("Contract Size", "Instrument (e.g., BTC-PERPETUAL)");
-    if (!instrument.empty()) {
-        manager->getContractSize(instrument);
-        showMessageDialog("Contract size request sent for: " + instrument, Color::Green);
+    if (instrument.empty()) return;
+
+    std::future<RpcResult> ack = manager->getContractSize(instrument);
+    if (ack.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+        showMessageDialog("Contract size request sent for: " + instrument, Color::Yellow);
+        return;
     }
+    RpcResult result = ack.get();
+    const InstrumentRegistry& instruments = manager->getInstruments();
+    InstrumentSpec spec;
+    if (!result.ok || !instruments.spec(instruments.find(instrument), spec)) {
+        showMessageDialog("No contract size for " + instrument + ": " + result.errorMessage, Color::Red);
+        return;
+    }
+    showMessageDialog(instrument + "\nTick size: " + spec.tickSize.toString() +
+                      "\nContract size: " + spec.contractSize.toString() +
+                      "\nMin trade amount: " + spec.minTradeAmount.toString(), Color::White);
 }
 
 // FTXUI version of getAllSupportedCurrenciesMenu
@@ -339,6 +639,19 @@ void Menu::getAllSupportedCurrenciesMenuFTXUI(OrderManager* manager) {
     showMessageDialog("Request sent for all supported currencies", Color::Green);
 }
 
+// Channel names separated by spaces or commas
+static std::vector<std::string> splitChannels(const std::string& text) {
+    std::vector<std::string> channels;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of(" ,", start);
+        if (end == std::string::npos) end = text.size();
+        if (end > start) channels.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return channels;
+}
+
 // FTXUI version of subscribeMenu
 void Menu::subscribeMenuFTXUI(OrderManager* manager) {
     if (!manager) {
@@ -346,10 +659,14 @@ void Menu::subscribeMenuFTXUI(OrderManager* manager) {
         return;
     }
 
-    std::string channel = showInputDialog("Subscribe", "Channel to Subscribe (e.g., ticker.BTC-PERPETUAL.raw)");
-    if (!channel.empty()) {
-        manager->subscribe(channel);
-        showMessageDialog("Subscribed to: " + channel, Color::Green);
+    std::string input = showInputDialog("Subscribe", "Channels to Subscribe, separated by spaces (e.g., ticker.BTC-PERPETUAL.raw)");
+    std::vector<std::string> channels = splitChannels(input);
+    if (channels.size() == 1) {
+        manager->subscribe(channels[0]);
+        showMessageDialog("Subscribed to: " + channels[0], Color::Green);
+    } else if (!channels.empty()) {
+        manager->subscribe(channels);
+        showMessageDialog("Subscribed to " + std::to_string(channels.size()) + " channels", Color::Green);
     }
 }
 
@@ -378,6 +695,274 @@ void Menu::unsubscribeAllMenuFTXUI(OrderManager* manager) {
     showMessageDialog("Unsubscribed from all channels", Color::Yellow);
 }
 
+// Shows the top of the local book kept from book.* subscriptions
+void Menu::viewOrderBookMenuFTXUI(OrderManager* manager) {
+    if (!manager) {
+        showMessageDialog("Manager is null!", Color::Red);
+        return;
+    }
+
+    std::string instrument = showInputDialog("Order Book", "Instrument (e.g., BTC-PERPETUAL)");
+    if (instrument.empty()) return;
+
+    BookTop top;
+    if (!manager->getBookTop(instrument, 10, top)) {
+        showMessageDialog("No book for " + instrument + ". Subscribe to book." + instrument + ".100ms first.", Color::Yellow);
+        return;
+    }
+    if (!top.synced) {
+        showMessageDialog("Book for " + instrument + " is resyncing, try again shortly.", Color::Yellow);
+        return;
+    }
+
+    std::string bookText = instrument + " (change_id " + std::to_string(top.changeId) + ")\n";
+    if (!top.bids.empty() && !top.asks.empty()) {
+        bookText += "Spread: " + (top.asks[0].price - top.bids[0].price).toString() + "\n";
+    }
+    size_t rows = std::max(top.bids.size(), top.asks.size());
+    for (size_t i = 0; i < rows; ++i) {
+        std::string bid = i < top.bids.size() ? top.bids[i].amount.toString() + " @ " + top.bids[i].price.toString() : "-";
+        std::string ask = i < top.asks.size() ? top.asks[i].price.toString() + " x " + top.asks[i].amount.toString() : "-";
+        bookText += bid + "  |  " + ask + "\n";
+    }
+
+    showMessageDialog(bookText, Color::White);
+}
+
+// Queue depth and per-stage latency of the receive pipeline
+void Menu::viewPipelineStatsMenuFTXUI() {
+    if (!pipeline) {
+        showMessageDialog("Pipeline is not running", Color::Red);
+        return;
+    }
+
+    PipelineStats stats = pipeline->stats();
+    std::string statsText = "Receive Pipeline:\n";
+    statsText += "Received: " + std::to_string(stats.received) + "  Dispatched: " + std::to_string(stats.dispatched) + "\n";
+    statsText += "Queue depth (control/market): " + std::to_string(stats.controlDepth) + "/" + std::to_string(stats.marketDepth) +
+                 "  High water: " + std::to_string(stats.highWater) + "\n";
+    statsText += "Producer stalls: " + std::to_string(stats.producerStalls) + "\n";
+    statsText += "Queue wait avg/max (us): " + std::to_string(stats.avgQueueNs / 1000.0) + " / " + std::to_string(stats.maxQueueNs / 1000.0) + "\n";
+    statsText += "Dispatch avg/max (us): " + std::to_string(stats.avgDispatchNs / 1000.0) + " / " + std::to_string(stats.maxDispatchNs / 1000.0) + "\n";
+
+    showMessageDialog(statsText, Color::White);
+}
+
+static std::string poolStatsText(const std::string& name, const PoolStats& stats) {
+    std::string text = name + ": " + std::to_string(stats.live) + " live / " + std::to_string(stats.highWater) +
+                       " touched / " + std::to_string(stats.capacity) + " slots in " + std::to_string(stats.chunks) + " chunks\n";
+    text += "  Acquired: " + std::to_string(stats.acquired) + "  Recycled: " + std::to_string(stats.recycled) +
+            "  Released: " + std::to_string(stats.released) + "\n";
+    text += "  Fragmentation: " + std::to_string(stats.fragmentation() * 100.0) + "%\n";
+    return text;
+}
+
+void Menu::viewMemoryStatsMenuFTXUI(OrderManager* manager) {
+    OrdersSnapshot orders = manager->getOrdersSnapshot();
+    std::string statsText = "Order Store (snapshot v" + std::to_string(orders.version()) + "):\n";
+    statsText += poolStatsText("Orders", orders->orderStats());
+    statsText += poolStatsText("Fills", orders->fillStats());
+    statsText += "Index buckets: " + std::to_string(orders->indexBuckets()) + "\n";
+
+    showMessageDialog(statsText, Color::White);
+}
+
+// Pre-trade limits of one instrument, or the defaults; empty answers keep the current value
+void Menu::riskLimitsMenuFTXUI(OrderManager* manager) {
+    std::string instrument = showInputDialog("Risk Limits", "Instrument (empty: defaults for all instruments)");
+    RiskLimits limits = instrument.empty() ? manager->getRiskGate().defaultLimits() : manager->getRiskLimits(instrument);
+
+    // Each field shows its current value; 0 turns the check off
+    auto ask = [&](const std::string& prompt, double current) {
+        std::string answer = showInputDialog("Risk Limits", prompt + " (now " + formatRow("%g", current) + ", 0: off)");
+        return answer.empty() ? current : std::stod(answer);
+    };
+    try {
+        limits.maxOrderQty = Qty::fromDouble(ask("Max order amount", limits.maxOrderQty.toDouble()));
+        limits.maxOrderNotional = ask("Max order notional", limits.maxOrderNotional);
+        limits.maxPosition = Qty::fromDouble(ask("Max absolute position", limits.maxPosition.toDouble()));
+        limits.collarBps = static_cast<int32_t>(ask("Price collar around mid, bps", limits.collarBps));
+        limits.maxOpenOrders = static_cast<uint32_t>(ask("Max open orders", limits.maxOpenOrders));
+    } catch (const std::exception& e) {
+        showMessageDialog("Error: " + std::string(e.what()), Color::Red);
+        return;
+    }
+    if (instrument.empty()) {
+        manager->setRiskLimits(limits);
+    } else if (!manager->setRiskLimits(instrument, limits)) {
+        showMessageDialog("Instrument registry is full", Color::Red);
+        return;
+    }
+
+    const RiskGate& gate = manager->getRiskGate();
+    std::string summary = std::string("Limits set for ") + (instrument.empty() ? "all instruments" : instrument) + "\n";
+    summary += std::string("Kill switch: ") + (gate.isHalted() ? "ON" : "off") + " (k on the main menu)\n";
+    summary += "Rejected so far:\n";
+    for (int reason = static_cast<int>(RiskReject::Halted); reason < static_cast<int>(RiskReject::Count); ++reason) {
+        summary += formatRow("  %-56s %8llu\n", riskRejectText(static_cast<RiskReject>(reason)),
+                             static_cast<unsigned long long>(gate.rejectCount(static_cast<RiskReject>(reason))));
+    }
+    showMessageDialog(summary, Color::White);
+}
+
+// Percentiles of each stage of order round trips, refreshed while open
+void Menu::viewLatencyStatsMenuFTXUI() {
+    if (!latency) {
+        showMessageDialog("Latency is not being recorded", Color::Red);
+        return;
+    }
+
+    auto formatUs = [](uint64_t ns) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.1f", ns / 1000.0);
+        return std::string(text);
+    };
+
+    auto renderer = Renderer([&] {
+        std::vector<std::vector<std::string>> rows = {{"Stage", "Count", "p50 us", "p99 us", "p99.9 us", "Max us"}};
+        for (int i = 0; i < static_cast<int>(LatencyStage::Count); ++i) {
+            LatencyStage stage = static_cast<LatencyStage>(i);
+            LatencySummary s = latency->summary(stage);
+            rows.push_back({latencyStageName(stage), std::to_string(s.count), formatUs(s.p50Ns), formatUs(s.p99Ns),
+                            formatUs(s.p999Ns), formatUs(s.maxNs)});
+        }
+
+        Elements lines;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            Elements cells;
+            for (size_t c = 0; c < rows[r].size(); ++c) {
+                Element cell = text(rows[r][c]);
+                cell = c == 0 ? cell | size(WIDTH, EQUAL, 12) : align_right(cell) | size(WIDTH, EQUAL, 10);
+                cells.push_back(r == 0 ? cell | bold : cell);
+            }
+            lines.push_back(hbox(cells));
+            if (r == 0 || r + 1 == rows.size() - 1) lines.push_back(separator());
+        }
+        if (link) {
+            LinkStats stats = link->stats(MessagePipeline::nowNs());
+            char linkText[160];
+            std::snprintf(linkText, sizeof(linkText), "Link RTT %lld us (min %lld, avg %lld +- %lld)  exchange %lld us",
+                          static_cast<long long>(stats.lastRttUs), static_cast<long long>(stats.minRttUs),
+                          static_cast<long long>(stats.smoothedRttUs), static_cast<long long>(stats.jitterUs),
+                          static_cast<long long>(stats.exchangeUs));
+            lines.push_back(text(linkText));
+            std::snprintf(linkText, sizeof(linkText), "Clock offset %+lld us  last frame %lld ms ago  %lld probes",
+                          static_cast<long long>(stats.clockOffsetUs), static_cast<long long>(stats.silentMs),
+                          static_cast<long long>(stats.samples));
+            lines.push_back(text(linkText) | (stats.stale ? color(Color::Red) : color(Color::White)));
+            lines.push_back(separator());
+        }
+        lines.push_back(text("r: reset   q/Esc: back") | dim);
+
+        return vbox({
+            text("Order Round Trip Latency") | bold | color(Color::Blue) | center,
+            separator(),
+            vbox(lines),
+        }) | border | center;
+    });
+
+    auto component = CatchEvent(renderer, [&](Event event) {
+        if (event == Event::Character('r')) {
+            latency->reset();
+            return true;
+        }
+        if (event == Event::Character('q') || event == Event::Escape) {
+            screen.ExitLoopClosure()();
+            return true;
+        }
+        return false;
+    });
+
+    // Redraw twice a second so the numbers follow live traffic
+    std::atomic<bool> refreshing{true};
+    std::thread refresher([&] {
+        while (refreshing) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            screen.PostEvent(Event::Custom);
+        }
+    });
+    screen.Loop(component);
+    refreshing = false;
+    refresher.join();
+}
+
+// Latest candles of an instrument, read straight from the candle store while open
+void Menu::viewCandlesMenuFTXUI(OrderManager* manager) {
+    std::string instrument = showInputDialog("Candles", "Instrument (e.g., BTC-PERPETUAL)");
+    if (instrument.empty()) return;
+    std::string frame = showInputDialog("Candles", "Timeframe (1s, 1m, 5m, 1h)");
+    Timeframe timeframe = Timeframe::Minute;
+    for (int i = 0; i < static_cast<int>(Timeframe::Count); ++i) {
+        if (frame == timeframeName(static_cast<Timeframe>(i))) timeframe = static_cast<Timeframe>(i);
+    }
+
+    constexpr size_t TableRows = 15;
+    constexpr size_t ChartCandles = 240;
+    std::vector<double> closes;     // Reused each frame; the chart reads it when drawn
+    auto candleRow = [](int64_t openTimeMs, double open, double high, double low, double close, double volume,
+                        double vwap, uint32_t trades) {
+        std::time_t seconds = static_cast<std::time_t>(openTimeMs / 1000);
+        char time[16];
+        std::strftime(time, sizeof(time), "%H:%M:%S", std::gmtime(&seconds));
+        return formatRow("%-9s %12.2f %12.2f %12.2f %12.2f %14.0f %12.2f %6u", time, open, high, low, close, volume,
+                         vwap, trades);
+    };
+
+    auto renderer = Renderer([&] {
+        Elements lines;
+        lines.push_back(text(formatRow("%-9s %12s %12s %12s %12s %14s %12s %6s", "Open (UTC)", "Open", "High", "Low",
+                                       "Close", "Volume", "VWAP", "Trades")) | bold);
+        lines.push_back(separator());
+        closes.clear();
+        bool found = manager->readCandles(instrument, timeframe, [&](const CandleColumns& finished, const Candle* current) {
+            // Newest first: the one in progress, then finished ones from the end of the columns
+            if (current) {
+                lines.push_back(text(candleRow(current->openTimeMs, current->open, current->high, current->low,
+                                               current->close, current->volume, current->vwap, current->trades)) |
+                                color(Color::Yellow));
+            }
+            for (size_t i = finished.count; i > 0 && lines.size() < TableRows + 2; --i) {
+                size_t c = i - 1;
+                lines.push_back(text(candleRow(finished.openTimeMs[c], finished.open[c], finished.high[c], finished.low[c],
+                                               finished.close[c], finished.volume[c], finished.vwap[c], finished.trades[c])));
+            }
+            size_t first = finished.count > ChartCandles ? finished.count - ChartCandles : 0;
+            closes.assign(finished.close + first, finished.close + finished.count);
+            if (current) closes.push_back(current->close);
+        });
+        if (!found) lines.push_back(text("No trades seen for " + instrument + ". Subscribe to trades." + instrument + ".100ms."));
+
+        return vbox({
+            text(instrument + " " + timeframeName(timeframe) + " candles") | bold | color(Color::Blue) | center,
+            separator(),
+            vbox(lines),
+            separator(),
+            GraphUtils::PlotLineGraph(closes, "Close", 50, 8),
+            text("q/Esc: back") | dim,
+        }) | border | center;
+    });
+
+    auto component = CatchEvent(renderer, [&](Event event) {
+        if (event == Event::Character('q') || event == Event::Escape) {
+            screen.ExitLoopClosure()();
+            return true;
+        }
+        return false;
+    });
+
+    // The current candle moves with every trade; once a second is plenty for a table
+    std::atomic<bool> refreshing{true};
+    std::thread refresher([&] {
+        while (refreshing) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            screen.PostEvent(Event::Custom);
+        }
+    });
+    screen.Loop(component);
+    refreshing = false;
+    refresher.join();
+}
+
 //original stuff cuz me too lazy
 void Menu::displayMenu() {
     std::cout << "1. Place Order\n";
@@ -1,6 +1,10 @@
 #pragma once
 #include<iostream>
 #include "OrderManager.h"
+#include "MessagePipeline.h"
+#include "LatencyStats.h"
+#include "LinkMonitor.h"
+#include "DirtyFlags.h"
 #include "FTXUI/include/ftxui/component/component.hpp"
 #include "FTXUI/include/ftxui/component/screen_interactive.hpp"
 // Menu interface
@@ -8,12 +12,19 @@
 class Menu {
 public:
     void showInteractiveMenu(OrderManager* manager);
+    void attachPipeline(MessagePipeline* messagePipeline) { pipeline = messagePipeline; }
+    void attachLatencyStats(LatencyStats* stats) { latency = stats; }
+    void attachLinkMonitor(LinkMonitor* monitor) { link = monitor; }
+    // Panels redraw when these say their data changed; without them they only follow key presses
+    void attachDirtyFlags(DirtyFlags* flags) { changes = flags; }
     void displayMenu();  // Keep old method for compatibility
     
     // FTXUI versions
     void placeOrderMenuFTXUI(OrderManager* manager);
     void cancelOrderMenuFTXUI(OrderManager* manager);
     void modifyOrderMenuFTXUI(OrderManager* manager);
+    void placeOrdersFromFileMenuFTXUI(OrderManager* manager);
+    void massCancelMenuFTXUI(OrderManager* manager);
     void viewPositionsMenuFTXUI(OrderManager* manager);
     void getOrderHistoryByCurrencyMenuFTXUI(OrderManager* manager);
     void getOrderHistoryByInstrumentMenuFTXUI(OrderManager* manager);
@@ -26,6 +37,12 @@ public:
     void subscribeMenuFTXUI(OrderManager* manager);
     void unsubscribeMenuFTXUI(OrderManager* manager);
     void unsubscribeAllMenuFTXUI(OrderManager* manager);
+    void viewOrderBookMenuFTXUI(OrderManager* manager);
+    void viewPipelineStatsMenuFTXUI();
+    void viewMemoryStatsMenuFTXUI(OrderManager* manager);
+    void viewLatencyStatsMenuFTXUI();
+    void viewCandlesMenuFTXUI(OrderManager* manager);
+    void riskLimitsMenuFTXUI(OrderManager* manager);
 
     // Original methods (for backward compatibility)
     void placeOrderMenu(OrderManager* manager);
@@ -45,6 +62,26 @@ public:
     void unsubscribeAllMenu(OrderManager* manager);
 
 private:
+    MessagePipeline* pipeline = nullptr;
+    LatencyStats* latency = nullptr;
+    LinkMonitor* link = nullptr;
+    DirtyFlags* changes = nullptr;
+
+    // One screen for the whole session: the menu, its dialogs and the dashboard all draw on it
+    ftxui::ScreenInteractive screen = ftxui::ScreenInteractive::Fullscreen();
+
+    // Dashboard panels beside the menu, as text rows rebuilt only when their data changes
+    struct Dashboard {
+        std::vector<std::string> book, orders, positions, trades;
+        std::string bookInstrument;   // Empty: the first instrument with a book
+        std::string bookTitle;
+    } dashboard;
+    void refreshDashboard(OrderManager* manager, uint32_t panels);
+    // Show the next instrument with a local book in the ladder
+    void nextBookInstrument(OrderManager* manager);
+
     std::string showInputDialog(const std::string& title, const std::string& prompt);
     void showMessageDialog(const std::string& message, ftxui::Color color = ftxui::Color::White);
+    // Wait briefly for the exchange's answer to an order request and show it
+    void showAckDialog(std::future<RpcResult>& ack, const std::string& action);
 };
\ No newline at end of file
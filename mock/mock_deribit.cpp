@@ -0,0 +1,760 @@
+// Local stand-in for the Deribit JSON-RPC websocket API, for end-to-end and
+// load testing without outside services.
+//
+// Answers public/auth, private/buy|sell|edit|cancel, private/cancel_all_by_instrument,
+// private/cancel_by_label, private/get_open_orders_by_currency, private/get_positions,
+// private/enable_cancel_on_disconnect, (public|private)/subscribe, unsubscribe,
+// public/test and public/set_heartbeat (test_request every interval). Market orders fill at once
+// against a synthetic price; limit orders rest until edited or cancelled. Every
+// subscribed book/ticker/trades channel receives synthetic notifications at a
+// combined rate of --rate messages per second per connection, driven from a
+// 1 ms timer. Book channels start with a snapshot and then chain changes by
+// prev_change_id, like the real feed.
+//
+//   make mock-cert mock_deribit
+//   ./mock_deribit --port 8443 --rate 100000
+//   ./trading_app --endpoint wss://localhost:8443/ws/api/v2
+#include <websocketpp/config/asio.hpp>
+#include <websocketpp/server.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MessageDecoder.h"
+
+typedef websocketpp::server<websocketpp::config::asio_tls> server;
+typedef websocketpp::lib::shared_ptr<websocketpp::lib::asio::ssl::context> context_ptr;
+
+namespace {
+
+constexpr int BookDepth = 20;
+constexpr size_t MaxBufferedBytes = 8 << 20;   // Skip notifications for a client this far behind
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// xorshift64: cheap and deterministic
+struct Random {
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    int below(int n) { return static_cast<int>(next() % static_cast<uint64_t>(n)); }
+};
+
+// Writes JSON into a reused buffer
+class JsonOut {
+public:
+    std::string text;
+
+    JsonOut() { text.reserve(4096); }
+    void clear() { text.clear(); }
+    JsonOut& raw(std::string_view s) { text.append(s); return *this; }
+    JsonOut& str(std::string_view s) { text.push_back('"'); text.append(s); text.push_back('"'); return *this; }
+    JsonOut& num(int64_t value) {
+        char digits[24];
+        text.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+        return *this;
+    }
+    JsonOut& num(double value) {
+        char digits[32];
+        text.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+        return *this;
+    }
+};
+
+struct MockOrder {
+    std::string id;
+    std::string instrument;
+    std::string label;
+    std::string orderType;
+    bool buy = true;
+    double amount = 0.0;
+    double price = 0.0;
+    double filled = 0.0;
+    double averagePrice = 0.0;
+    std::string state = "open";
+    int64_t created = 0;
+    websocketpp::connection_hdl owner;      // Session that placed it
+};
+
+struct MockPosition {
+    double size = 0.0;
+    double averagePrice = 0.0;
+};
+
+// Synthetic market of one instrument
+struct Market {
+    std::string name;
+    double mid = 50000.0;
+    double tick = 0.5;
+    double contractSize = 10.0;
+    double minTradeAmount = 10.0;
+    double bidAmount[BookDepth];
+    double askAmount[BookDepth];
+    int64_t changeId = 1;
+    int64_t tradeSeq = 1;
+    int64_t tradeId = 1;
+
+    explicit Market(std::string instrument) : name(std::move(instrument)) {
+        if (name.compare(0, 3, "ETH") == 0) mid = 3000.0, tick = 0.05, contractSize = 1.0, minTradeAmount = 1.0;
+        for (int i = 0; i < BookDepth; ++i) bidAmount[i] = askAmount[i] = 1000.0 + 100.0 * i;
+    }
+    double bidPrice(int level) const { return mid - tick * (level + 1); }
+    double askPrice(int level) const { return mid + tick * (level + 1); }
+};
+
+enum class StreamKind { Book, Ticker, Trades, UserTrades, Other };
+
+struct Stream {
+    StreamKind kind = StreamKind::Other;
+    std::string channel;
+    Market* market = nullptr;
+    bool snapshotSent = false;
+};
+
+struct Session {
+    std::vector<Stream> streams;
+    size_t nextStream = 0;
+    bool cancelOnDisconnect = false;
+    int64_t heartbeatUs = 0;          // public/set_heartbeat interval; 0 when off
+    int64_t lastHeartbeatUs = 0;
+    uint64_t sent = 0;
+    uint64_t skipped = 0;
+};
+
+class MockDeribit {
+public:
+    MockDeribit(uint16_t port, uint64_t rate, std::string cert, std::string key)
+        : port(port), rate(rate), certFile(std::move(cert)), keyFile(std::move(key)) {}
+
+    void run() {
+        endpoint.clear_access_channels(websocketpp::log::alevel::all);
+        endpoint.set_error_channels(websocketpp::log::elevel::rerror | websocketpp::log::elevel::fatal);
+        endpoint.init_asio();
+        endpoint.set_reuse_addr(true);
+        endpoint.set_tls_init_handler([this](websocketpp::connection_hdl) { return tlsInit(); });
+        endpoint.set_open_handler([this](websocketpp::connection_hdl hdl) { sessions[hdl]; });
+        endpoint.set_close_handler([this](websocketpp::connection_hdl hdl) { closeSession(hdl); });
+        endpoint.set_message_handler([this](websocketpp::connection_hdl hdl, server::message_ptr msg) {
+            handleRequest(hdl, msg->get_payload());
+        });
+        endpoint.listen(port);
+        endpoint.start_accept();
+        scheduleTick();
+        std::cout << "Mock Deribit listening on wss://localhost:" << port << "/ws/api/v2, "
+                  << rate << " notifications/s per connection" << std::endl;
+        endpoint.run();
+    }
+
+private:
+    server endpoint;
+    uint16_t port;
+    uint64_t rate;
+    std::string certFile;
+    std::string keyFile;
+    std::map<websocketpp::connection_hdl, Session, std::owner_less<websocketpp::connection_hdl>> sessions;
+    std::unordered_map<std::string, Market> markets;
+    std::unordered_map<std::string, MockOrder> orders;
+    std::map<std::string, MockPosition> positions;
+    int64_t nextOrderId = 1;
+    Random random;
+    JsonOut out;
+    JsonOut notification;
+
+    // Rate bookkeeping
+    int64_t lastTickUs = 0;
+    double owed = 0.0;
+    int64_t lastReportUs = 0;
+    uint64_t requestsHandled = 0;
+
+    context_ptr tlsInit() {
+        namespace ssl = websocketpp::lib::asio::ssl;
+        context_ptr ctx = websocketpp::lib::make_shared<ssl::context>(ssl::context::sslv23);
+        try {
+            ctx->set_options(ssl::context::default_workarounds | ssl::context::no_sslv2 | ssl::context::no_sslv3);
+            ctx->use_certificate_chain_file(certFile);
+            ctx->use_private_key_file(keyFile, ssl::context::pem);
+        } catch (std::exception& e) {
+            std::cerr << "TLS setup failed (run make mock-cert?): " << e.what() << std::endl;
+        }
+        return ctx;
+    }
+
+    void closeSession(websocketpp::connection_hdl hdl) {
+        auto session = sessions.find(hdl);
+        if (session == sessions.end()) return;
+        if (session->second.cancelOnDisconnect) {
+            std::owner_less<websocketpp::connection_hdl> before;
+            for (auto it = orders.begin(); it != orders.end();) {
+                bool own = !before(it->second.owner, hdl) && !before(hdl, it->second.owner);
+                it = own ? orders.erase(it) : std::next(it);
+            }
+        }
+        sessions.erase(session);
+    }
+
+    // currency "any" matches every instrument
+    static bool inCurrency(std::string_view instrument, std::string_view currency) {
+        return currency.empty() || currency == "any" ||
+               (instrument.compare(0, currency.size(), currency) == 0 && instrument.size() > currency.size() &&
+                instrument[currency.size()] == '-');
+    }
+
+    void applyFill(const std::string& instrument, bool buy, double price, double amount) {
+        MockPosition& position = positions[instrument];
+        double signedAmount = buy ? amount : -amount;
+        double size = position.size + signedAmount;
+        if (size == 0.0) {
+            position.averagePrice = 0.0;
+        } else if (position.size == 0.0 || (position.size > 0) != (size > 0)) {
+            position.averagePrice = price;
+        } else if ((position.size > 0) == buy) {
+            position.averagePrice = (position.averagePrice * std::abs(position.size) + price * amount) / std::abs(size);
+        }
+        position.size = size;
+    }
+
+    Market& market(std::string_view instrument) {
+        auto it = markets.find(std::string(instrument));
+        if (it == markets.end()) it = markets.emplace(std::string(instrument), Market(std::string(instrument))).first;
+        return it->second;
+    }
+
+    void send(websocketpp::connection_hdl hdl, const std::string& payload) {
+        websocketpp::lib::error_code ec;
+        endpoint.send(hdl, payload.data(), payload.size(), websocketpp::frame::opcode::text, ec);
+    }
+
+    void beginResponse(int64_t id) {
+        out.clear();
+        out.raw(R"({"jsonrpc":"2.0","id":)").num(id).raw(R"(,"result":)");
+    }
+
+    void endResponse(websocketpp::connection_hdl hdl, int64_t usIn) {
+        int64_t usOut = nowUs();
+        out.raw(R"(,"usIn":)").num(usIn).raw(R"(,"usOut":)").num(usOut).raw(R"(,"usDiff":)").num(usOut - usIn)
+            .raw(R"(,"testnet":true})");
+        send(hdl, out.text);
+    }
+
+    void sendError(websocketpp::connection_hdl hdl, int64_t id, int64_t code, std::string_view message, int64_t usIn) {
+        out.clear();
+        out.raw(R"({"jsonrpc":"2.0","id":)").num(id).raw(R"(,"error":{"message":)").str(message)
+            .raw(R"(,"code":)").num(code).raw("}");
+        endResponse(hdl, usIn);
+    }
+
+    void writeOrder(JsonOut& json, const MockOrder& order) {
+        json.raw(R"({"order_id":)").str(order.id)
+            .raw(R"(,"instrument_name":)").str(order.instrument)
+            .raw(R"(,"direction":)").str(order.buy ? "buy" : "sell")
+            .raw(R"(,"order_type":)").str(order.orderType)
+            .raw(R"(,"order_state":)").str(order.state)
+            .raw(R"(,"label":)").str(order.label)
+            .raw(R"(,"amount":)").num(order.amount)
+            .raw(R"(,"filled_amount":)").num(order.filled)
+            .raw(R"(,"price":)").num(order.price)
+            .raw(R"(,"average_price":)").num(order.averagePrice)
+            .raw(R"(,"time_in_force":"good_til_cancelled","post_only":false,"reduce_only":false,"api":true)")
+            .raw(R"(,"creation_timestamp":)").num(order.created)
+            .raw(R"(,"last_update_timestamp":)").num(nowUs() / 1000)
+            .raw("}");
+    }
+
+    void writeInstrument(const Market& spec) {
+        out.raw(R"({"instrument_name":)").str(spec.name)
+            .raw(R"(,"kind":"future","settlement_period":"perpetual","expiration_timestamp":32503708800000,"tick_size":)").num(spec.tick)
+            .raw(R"(,"contract_size":)").num(spec.contractSize)
+            .raw(R"(,"min_trade_amount":)").num(spec.minTradeAmount)
+            .raw(R"(,"strike":null,"option_type":null})");
+    }
+
+    void writeTrade(JsonOut& json, Market& market, const MockOrder* order, bool buy, double price, double amount) {
+        json.raw(R"({"trade_seq":)").num(market.tradeSeq++)
+            .raw(R"(,"trade_id":)").str(market.name.substr(0, market.name.find('-')) + "-" + std::to_string(market.tradeId++))
+            .raw(R"(,"timestamp":)").num(nowUs() / 1000)
+            .raw(R"(,"instrument_name":)").str(market.name)
+            .raw(R"(,"direction":)").str(buy ? "buy" : "sell")
+            .raw(R"(,"price":)").num(price)
+            .raw(R"(,"amount":)").num(amount)
+            .raw(R"(,"mark_price":)").num(market.mid)
+            .raw(R"(,"index_price":)").num(market.mid)
+            .raw(R"(,"tick_direction":0,"liquidity":"T")");
+        if (order) {
+            json.raw(R"(,"order_id":)").str(order->id)
+                .raw(R"(,"order_type":)").str(order->orderType)
+                .raw(R"(,"label":)").str(order->label)
+                .raw(R"(,"fee":)").num(amount * 0.0005)
+                .raw(R"(,"fee_currency":)").str(market.name.substr(0, market.name.find('-')));
+        }
+        json.raw("}");
+    }
+
+    // Request fields the mock looks at
+    struct Request {
+        int64_t id = 0;
+        std::string_view method;
+        std::string_view instrument;
+        std::string_view orderId;
+        std::string_view type;
+        std::string_view label;
+        std::string_view currency;
+        std::vector<std::string_view> channels;
+        double amount = 0.0;
+        double price = 0.0;
+        bool hasPrice = false;
+        int64_t interval = 0;
+    };
+
+    static bool parseRequest(std::string_view payload, Request& request) {
+        JsonCursor cur(payload);
+        std::string_view key, params;
+        if (!cur.beginObject()) return false;
+        while (cur.nextMember(key)) {
+            if (key == "id") cur.readInt(request.id);
+            else if (key == "method") cur.readString(request.method);
+            else if (key == "params") cur.readRaw(params);
+            else cur.skipValue();
+        }
+        if (!cur.ok() || params.empty()) return cur.ok();
+
+        JsonCursor fields(params);
+        if (!fields.beginObject()) return false;
+        while (fields.nextMember(key)) {
+            if (key == "instrument_name") fields.readString(request.instrument);
+            else if (key == "order_id") fields.readString(request.orderId);
+            else if (key == "type") fields.readString(request.type);
+            else if (key == "label") fields.readString(request.label);
+            else if (key == "currency") fields.readString(request.currency);
+            else if (key == "amount") fields.readDouble(request.amount);
+            else if (key == "interval") fields.readInt(request.interval);
+            else if (key == "price") request.hasPrice = fields.readDouble(request.price);
+            else if (key == "channels") {
+                std::string_view channel;
+                fields.beginArray();
+                while (fields.nextElement()) {
+                    if (fields.readString(channel)) request.channels.push_back(channel);
+                }
+            } else fields.skipValue();
+        }
+        return fields.ok();
+    }
+
+    void handleRequest(websocketpp::connection_hdl hdl, const std::string& payload) {
+        int64_t usIn = nowUs();
+        Request request;
+        if (!parseRequest(payload, request)) {
+            sendError(hdl, 0, -32700, "Parse error", usIn);
+            return;
+        }
+        ++requestsHandled;
+        std::string_view method = request.method;
+
+        if (method == "public/auth") {
+            beginResponse(request.id);
+            out.raw(R"({"access_token":"mock-access-token","expires_in":31536000,"refresh_token":"mock-refresh-token","scope":"connection mainaccount trade:read_write","token_type":"bearer"})");
+            endResponse(hdl, usIn);
+        } else if (method == "private/buy" || method == "private/sell") {
+            placeOrder(hdl, request, method == "private/buy", usIn);
+        } else if (method == "private/edit") {
+            editOrder(hdl, request, usIn);
+        } else if (method == "private/cancel") {
+            cancelOrder(hdl, request, usIn);
+        } else if (method == "private/cancel_all_by_instrument" || method == "private/cancel_by_label") {
+            bool byLabel = method == "private/cancel_by_label";
+            int64_t cancelled = 0;
+            for (auto it = orders.begin(); it != orders.end();) {
+                if (byLabel ? it->second.label == request.label : it->second.instrument == request.instrument) {
+                    it = orders.erase(it);
+                    ++cancelled;
+                } else {
+                    ++it;
+                }
+            }
+            beginResponse(request.id);
+            out.num(cancelled);
+            endResponse(hdl, usIn);
+        } else if (method == "public/subscribe" || method == "private/subscribe") {
+            subscribe(hdl, request, usIn);
+        } else if (method == "public/unsubscribe" || method == "private/unsubscribe") {
+            unsubscribe(hdl, request, usIn);
+        } else if (method == "public/unsubscribe_all" || method == "private/unsubscribe_all") {
+            sessions[hdl].streams.clear();
+            beginResponse(request.id);
+            out.raw(R"("ok")");
+            endResponse(hdl, usIn);
+        } else if (method == "public/get_instrument") {
+            beginResponse(request.id);
+            writeInstrument(market(request.instrument));
+            endResponse(hdl, usIn);
+        } else if (method == "public/get_instruments") {
+            // Perpetuals only; currency "any" lists both
+            beginResponse(request.id);
+            out.raw("[");
+            bool first = true;
+            for (const char* name : {"BTC-PERPETUAL", "ETH-PERPETUAL"}) {
+                if (request.currency != "any" && std::string_view(name).compare(0, request.currency.size(), request.currency) != 0) continue;
+                if (!first) out.raw(",");
+                first = false;
+                writeInstrument(market(name));
+            }
+            out.raw("]");
+            endResponse(hdl, usIn);
+        } else if (method == "private/get_open_orders_by_currency") {
+            beginResponse(request.id);
+            out.raw("[");
+            bool first = true;
+            for (const auto& [id, order] : orders) {
+                if (!inCurrency(order.instrument, request.currency)) continue;
+                if (!first) out.raw(",");
+                first = false;
+                writeOrder(out, order);
+            }
+            out.raw("]");
+            endResponse(hdl, usIn);
+        } else if (method == "private/get_positions") {
+            beginResponse(request.id);
+            out.raw("[");
+            bool first = true;
+            for (const auto& [instrument, position] : positions) {
+                if (position.size == 0.0 || !inCurrency(instrument, request.currency)) continue;
+                if (!first) out.raw(",");
+                first = false;
+                out.raw(R"({"instrument_name":)").str(instrument)
+                    .raw(R"(,"kind":"future","direction":)").str(position.size > 0 ? "buy" : "sell")
+                    .raw(R"(,"size":)").num(position.size)
+                    .raw(R"(,"average_price":)").num(position.averagePrice)
+                    .raw(R"(,"mark_price":)").num(market(instrument).mid)
+                    .raw("}");
+            }
+            out.raw("]");
+            endResponse(hdl, usIn);
+        } else if (method == "private/enable_cancel_on_disconnect" || method == "private/disable_cancel_on_disconnect") {
+            sessions[hdl].cancelOnDisconnect = method == "private/enable_cancel_on_disconnect";
+            beginResponse(request.id);
+            out.raw(R"("ok")");
+            endResponse(hdl, usIn);
+        } else if (method == "public/test") {
+            beginResponse(request.id);
+            out.raw(R"({"version":"1.2.26"})");
+            endResponse(hdl, usIn);
+        } else if (method == "public/set_heartbeat" || method == "public/disable_heartbeat") {
+            Session& session = sessions[hdl];
+            session.heartbeatUs = method == "public/set_heartbeat" ? std::max<int64_t>(request.interval, 10) * 1000000 : 0;
+            session.lastHeartbeatUs = usIn;
+            beginResponse(request.id);
+            out.raw(R"("ok")");
+            endResponse(hdl, usIn);
+        } else {
+            sendError(hdl, request.id, -32601, "Method not found", usIn);
+        }
+    }
+
+    void placeOrder(websocketpp::connection_hdl hdl, const Request& request, bool buy, int64_t usIn) {
+        if (request.instrument.empty() || request.amount <= 0.0) {
+            sendError(hdl, request.id, -32602, "Invalid params", usIn);
+            return;
+        }
+        Market& book = market(request.instrument);
+        MockOrder order;
+        order.id = std::string(request.instrument.substr(0, request.instrument.find('-'))) + "-MOCK-" + std::to_string(nextOrderId++);
+        order.instrument.assign(request.instrument);
+        order.label.assign(request.label);
+        order.orderType.assign(request.type.empty() ? "limit" : request.type);
+        order.buy = buy;
+        order.amount = request.amount;
+        order.price = request.hasPrice ? request.price : (buy ? book.askPrice(0) : book.bidPrice(0));
+        order.created = nowUs() / 1000;
+        order.owner = hdl;
+
+        // Market orders and limits through the touch fill in full at the touch
+        bool fills = order.orderType == "market" ||
+                     (buy ? order.price >= book.askPrice(0) : order.price <= book.bidPrice(0));
+        double fillPrice = buy ? book.askPrice(0) : book.bidPrice(0);
+        if (fills) {
+            order.filled = order.amount;
+            order.averagePrice = fillPrice;
+            order.state = "filled";
+        }
+
+        beginResponse(request.id);
+        out.raw(R"({"order":)");
+        writeOrder(out, order);
+        out.raw(R"(,"trades":[)");
+        if (fills) {
+            JsonOut tradeJson;
+            writeTrade(tradeJson, book, &order, buy, fillPrice, order.amount);
+            applyFill(order.instrument, buy, fillPrice, order.amount);
+            out.raw(tradeJson.text);
+            notifyUserTrade(hdl, book, tradeJson.text);
+        }
+        out.raw("]}");
+        endResponse(hdl, usIn);
+
+        if (!fills) orders.emplace(order.id, std::move(order));
+    }
+
+    void editOrder(websocketpp::connection_hdl hdl, const Request& request, int64_t usIn) {
+        auto it = orders.find(std::string(request.orderId));
+        if (it == orders.end()) {
+            sendError(hdl, request.id, 11044, "not_open_order", usIn);
+            return;
+        }
+        MockOrder& order = it->second;
+        if (request.amount > 0.0) order.amount = request.amount;
+        if (request.hasPrice) order.price = request.price;
+        beginResponse(request.id);
+        out.raw(R"({"order":)");
+        writeOrder(out, order);
+        out.raw(R"(,"trades":[]})");
+        endResponse(hdl, usIn);
+    }
+
+    void cancelOrder(websocketpp::connection_hdl hdl, const Request& request, int64_t usIn) {
+        auto it = orders.find(std::string(request.orderId));
+        if (it == orders.end()) {
+            sendError(hdl, request.id, 11044, "not_open_order", usIn);
+            return;
+        }
+        it->second.state = "cancelled";
+        beginResponse(request.id);
+        writeOrder(out, it->second);
+        endResponse(hdl, usIn);
+        orders.erase(it);
+    }
+
+    static StreamKind kindOf(std::string_view channel) {
+        if (channel.compare(0, 5, "book.") == 0) return StreamKind::Book;
+        if (channel.compare(0, 7, "ticker.") == 0) return StreamKind::Ticker;
+        if (channel.compare(0, 7, "trades.") == 0) return StreamKind::Trades;
+        if (channel.compare(0, 12, "user.trades.") == 0) return StreamKind::UserTrades;
+        return StreamKind::Other;
+    }
+
+    // book.BTC-PERPETUAL.100ms -> BTC-PERPETUAL
+    static std::string_view instrumentOf(std::string_view channel, StreamKind kind) {
+        size_t start = channel.find('.') + 1;
+        if (kind == StreamKind::UserTrades) start = channel.find('.', start) + 1;
+        size_t end = channel.find('.', start);
+        return channel.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    }
+
+    void subscribe(websocketpp::connection_hdl hdl, const Request& request, int64_t usIn) {
+        Session& session = sessions[hdl];
+        beginResponse(request.id);
+        out.raw("[");
+        bool first = true;
+        for (std::string_view channel : request.channels) {
+            Stream stream;
+            stream.kind = kindOf(channel);
+            stream.channel.assign(channel);
+            if (stream.kind != StreamKind::Other) stream.market = &market(instrumentOf(channel, stream.kind));
+            session.streams.push_back(std::move(stream));
+            if (!first) out.raw(",");
+            out.str(channel);
+            first = false;
+        }
+        out.raw("]");
+        endResponse(hdl, usIn);
+    }
+
+    void unsubscribe(websocketpp::connection_hdl hdl, const Request& request, int64_t usIn) {
+        Session& session = sessions[hdl];
+        for (std::string_view channel : request.channels) {
+            for (size_t i = 0; i < session.streams.size(); ++i) {
+                if (session.streams[i].channel == channel) {
+                    session.streams.erase(session.streams.begin() + i);
+                    break;
+                }
+            }
+        }
+        beginResponse(request.id);
+        out.raw("[");
+        for (size_t i = 0; i < request.channels.size(); ++i) {
+            if (i) out.raw(",");
+            out.str(request.channels[i]);
+        }
+        out.raw("]");
+        endResponse(hdl, usIn);
+    }
+
+    void notifyUserTrade(websocketpp::connection_hdl hdl, Market& book, const std::string& tradeJson) {
+        Session& session = sessions[hdl];
+        for (Stream& stream : session.streams) {
+            if (stream.kind != StreamKind::UserTrades || stream.market != &book) continue;
+            notification.clear();
+            notification.raw(R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":)").str(stream.channel)
+                .raw(R"(,"data":[)").raw(tradeJson).raw("]}}");
+            send(hdl, notification.text);
+        }
+    }
+
+    // Build the next notification of a market data stream into `notification`
+    void buildNotification(Stream& stream) {
+        Market& book = *stream.market;
+        notification.clear();
+        notification.raw(R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":)").str(stream.channel)
+            .raw(R"(,"data":)");
+        int64_t timestamp = nowUs() / 1000;
+
+        if (stream.kind == StreamKind::Book) {
+            if (!stream.snapshotSent) {
+                notification.raw(R"({"type":"snapshot","timestamp":)").num(timestamp)
+                    .raw(R"(,"instrument_name":)").str(book.name).raw(R"(,"change_id":)").num(book.changeId).raw(R"(,"bids":[)");
+                for (int i = 0; i < BookDepth; ++i) {
+                    notification.raw(i ? "," : "").raw(R"(["new",)").num(book.bidPrice(i)).raw(",").num(book.bidAmount[i]).raw("]");
+                }
+                notification.raw(R"(],"asks":[)");
+                for (int i = 0; i < BookDepth; ++i) {
+                    notification.raw(i ? "," : "").raw(R"(["new",)").num(book.askPrice(i)).raw(",").num(book.askAmount[i]).raw("]");
+                }
+                notification.raw("]}}}");
+                stream.snapshotSent = true;
+                return;
+            }
+            // One level changes size on each side
+            int bidLevel = random.below(BookDepth);
+            int askLevel = random.below(BookDepth);
+            book.bidAmount[bidLevel] = 100.0 + random.below(5000);
+            book.askAmount[askLevel] = 100.0 + random.below(5000);
+            int64_t prev = book.changeId++;
+            notification.raw(R"({"type":"change","timestamp":)").num(timestamp)
+                .raw(R"(,"instrument_name":)").str(book.name)
+                .raw(R"(,"prev_change_id":)").num(prev).raw(R"(,"change_id":)").num(book.changeId)
+                .raw(R"(,"bids":[["change",)").num(book.bidPrice(bidLevel)).raw(",").num(book.bidAmount[bidLevel])
+                .raw(R"(]],"asks":[["change",)").num(book.askPrice(askLevel)).raw(",").num(book.askAmount[askLevel])
+                .raw("]]}}}");
+        } else if (stream.kind == StreamKind::Ticker) {
+            notification.raw(R"({"timestamp":)").num(timestamp)
+                .raw(R"(,"instrument_name":)").str(book.name)
+                .raw(R"(,"state":"open","mark_price":)").num(book.mid)
+                .raw(R"(,"index_price":)").num(book.mid)
+                .raw(R"(,"last_price":)").num(book.mid)
+                .raw(R"(,"best_bid_price":)").num(book.bidPrice(0)).raw(R"(,"best_bid_amount":)").num(book.bidAmount[0])
+                .raw(R"(,"best_ask_price":)").num(book.askPrice(0)).raw(R"(,"best_ask_amount":)").num(book.askAmount[0])
+                .raw("}}}");
+        } else {
+            bool buy = random.below(2) == 0;
+            notification.raw("[");
+            writeTrade(notification, book, nullptr, buy, buy ? book.askPrice(0) : book.bidPrice(0), 10.0 * (1 + random.below(10)));
+            notification.raw("]}}");
+        }
+    }
+
+    void tick() {
+        int64_t now = nowUs();
+        if (lastTickUs == 0) lastTickUs = now;
+        owed += static_cast<double>(rate) * (now - lastTickUs) / 1e6;
+        lastTickUs = now;
+        uint64_t budget = static_cast<uint64_t>(owed);
+        owed -= budget;
+
+        // Random walk the mids once per tick
+        for (auto& entry : markets) {
+            Market& book = entry.second;
+            book.mid += book.tick * (random.below(3) - 1);
+        }
+
+        for (auto& entry : sessions) {
+            Session& session = entry.second;
+            // Deribit alternates plain heartbeats with test_requests; the mock always asks
+            if (session.heartbeatUs && now - session.lastHeartbeatUs >= session.heartbeatUs) {
+                session.lastHeartbeatUs = now;
+                send(entry.first, R"({"jsonrpc":"2.0","method":"heartbeat","params":{"type":"test_request"}})");
+            }
+            size_t marketStreams = 0;
+            for (const Stream& stream : session.streams) {
+                if (stream.kind == StreamKind::Book || stream.kind == StreamKind::Ticker || stream.kind == StreamKind::Trades) ++marketStreams;
+            }
+            if (marketStreams == 0) continue;
+
+            websocketpp::lib::error_code ec;
+            server::connection_ptr con = endpoint.get_con_from_hdl(entry.first, ec);
+            if (ec || !con) continue;
+
+            for (uint64_t sent = 0; sent < budget;) {
+                Stream& stream = session.streams[session.nextStream++ % session.streams.size()];
+                if (stream.kind == StreamKind::UserTrades || stream.kind == StreamKind::Other) continue;
+                ++sent;
+                // A client that can't keep up loses notifications rather than growing our queue
+                if (con->get_buffered_amount() > MaxBufferedBytes) {
+                    ++session.skipped;
+                    continue;
+                }
+                buildNotification(stream);
+                send(entry.first, notification.text);
+                ++session.sent;
+            }
+        }
+
+        if (now - lastReportUs >= 1000000) {
+            report(now);
+        }
+        scheduleTick();
+    }
+
+    void report(int64_t now) {
+        double seconds = lastReportUs == 0 ? 1.0 : (now - lastReportUs) / 1e6;
+        for (auto& entry : sessions) {
+            Session& session = entry.second;
+            if (session.sent == 0 && session.skipped == 0) continue;
+            std::cout << "conn: " << static_cast<uint64_t>(session.sent / seconds) << " msg/s sent, "
+                      << static_cast<uint64_t>(session.skipped / seconds) << " msg/s skipped (client behind)" << std::endl;
+            session.sent = 0;
+            session.skipped = 0;
+        }
+        if (requestsHandled) {
+            std::cout << "requests: " << static_cast<uint64_t>(requestsHandled / seconds) << "/s, open orders: " << orders.size() << std::endl;
+            requestsHandled = 0;
+        }
+        lastReportUs = now;
+    }
+
+    void scheduleTick() {
+        endpoint.set_timer(1, [this](websocketpp::lib::error_code const& ec) {
+            if (!ec) tick();
+        });
+    }
+};
+
+}
+
+//   --port N     listen port (8443)
+//   --rate N     notifications per second per connection (100000)
+//   --cert FILE  --key FILE   TLS certificate and key (mock/cert.pem, mock/key.pem)
+int main(int argc, char* argv[]) {
+    uint16_t port = 8443;
+    uint64_t rate = 100000;
+    std::string cert = "mock/cert.pem", key = "mock/key.pem";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--port") port = static_cast<uint16_t>(std::atoi(argv[i + 1]));
+        else if (flag == "--rate") rate = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (flag == "--cert") cert = argv[i + 1];
+        else if (flag == "--key") key = argv[i + 1];
+        else std::cerr << "Unknown option " << flag << std::endl;
+    }
+
+    try {
+        MockDeribit mock(port, rate, cert, key);
+        mock.run();
+    } catch (websocketpp::exception const& e) {
+        std::cerr << "Mock server failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,14 +3,25 @@
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <thread>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <optional>
+#include <random>
 #include <unordered_map>
 #include <vector>
 #include "Order.h"
 #include "Authenticator.h"
+#include "MessageDecoder.h"
+#include "MessagePipeline.h"
+#include "FrameLog.h"
+#include "LatencyStats.h"
+#include "LinkMonitor.h"
+#include "DirtyFlags.h"
+#include "Logger.h"
+#include "SubscriptionManager.h"
 #include "types.hpp"
 #include "menu.h"
 
@@ -30,20 +41,131 @@ bool connectionOpen = false;
 
 OrderManager* manager = nullptr;
 
+void dispatch_frame(InboundFrame& frame);
+MessagePipeline pipeline(&dispatch_frame);
+FrameLogWriter capture; // Open when started with --capture
+LatencyStats latency;   // Order round trips, shown in the menu and printed on exit
+SubscriptionManager subscriptions; // Channels wanted, restored on every new connection
+std::string instrumentCachePath = "instruments.cache"; // Instrument specs kept between runs
+std::string candleDirectory = "candles";                 // Finished candles kept between runs
+std::string endpointUri;                // Where connections (and reconnections) go
+std::atomic<bool> shuttingDown{false};  // Set on exit so a closing connection isn't replaced
+int reconnectAttempt = 0;               // Failed attempts since the last open; I/O thread only
+websocketpp::connection_hdl currentConnection; // I/O thread only
+// The exchange heartbeats every HeartbeatSeconds and we probe every ProbeIntervalMs, so a
+// healthy link is never quiet for long; LinkStaleMs of silence means it is gone
+constexpr int HeartbeatSeconds = 10;
+constexpr long ProbeIntervalMs = 5000;
+constexpr long LinkStaleMs = 15000;
+LinkMonitor linkMonitor(LinkStaleMs);   // RTT and clock offset, shown with order latency
+DirtyFlags displayChanges;              // Dashboard panels with new data, set by the dispatcher
+// websocketpp writes its own logs to streams; send them through the logger instead of the terminal
+LogStream websocketAccessLog(LogLevel::Info, "websocketpp");
+LogStream websocketErrorLog(LogLevel::Warn, "websocketpp");
+
+void connect_endpoint(client* c);
+
+// Exponential backoff from 250 ms to 30 s, with +-25% jitter so restarted clients don't reconnect in step
+static long reconnectDelayMs(int attempt) {
+    static std::mt19937 random(std::random_device{}());
+    long base = std::min(30000L, 250L << std::min(attempt, 7));
+    std::uniform_int_distribution<long> jitter(-base / 4, base / 4);
+    return base + jitter(random);
+}
+
+void schedule_reconnect(client* c) {
+    if (shuttingDown) {
+        return;
+    }
+    long delayMs = reconnectDelayMs(reconnectAttempt++);
+    LOG_WARN("Reconnecting in {} ms (attempt {})", delayMs, reconnectAttempt);
+    c->set_timer(delayMs, [c](const websocketpp::lib::error_code& ec) {
+        if (!ec && !shuttingDown) {
+            connect_endpoint(c);
+        }
+    });
+}
+
+// I/O thread: probe the link every ProbeIntervalMs, and drop it when it has gone silent
+void schedule_probe(client* c, websocketpp::connection_hdl hdl) {
+    c->set_timer(ProbeIntervalMs, [c, hdl](const websocketpp::lib::error_code& ec) {
+        if (ec || shuttingDown || hdl.owner_before(currentConnection) || currentConnection.owner_before(hdl)) {
+            return; // Timer cancelled, or this connection has been replaced
+        }
+        int64_t nowNs = MessagePipeline::nowNs();
+        if (linkMonitor.isStale(nowNs)) {
+            LOG_WARN("No frames for {} ms, dropping the connection", linkMonitor.stats(nowNs).silentMs);
+            websocketpp::lib::error_code closeEc;
+            c->close(hdl, websocketpp::close::status::going_away, "stale link", closeEc);
+            return; // on_close reconnects
+        }
+        linkMonitor.probeSent(manager->sendTest(), nowNs);
+        schedule_probe(c, hdl);
+    });
+}
+
+void connect_endpoint(client* c) {
+    websocketpp::lib::error_code ec;
+    client::connection_ptr con = c->get_connection(endpointUri, ec);
+    if (ec) {
+        LOG_ERROR("Could not create connection because: {}", ec.message());
+        schedule_reconnect(c);
+        return;
+    }
+    c->connect(con);
+}
+
 // WebSocket event handlers
 void on_open(websocketpp::connection_hdl hdl, client* c) {
-    std::cout << "WebSocket connection opened!" << std::endl;
+    LOG_INFO("WebSocket connection opened");
     websocketpp::lib::error_code ec;
     client::connection_ptr con = c->get_con_from_hdl(hdl, ec);
 
     if (ec) {
-        std::cout << "Failed to get connection pointer: " << ec.message() << std::endl;
+        LOG_ERROR("Failed to get connection pointer: {}", ec.message());
         return;
     }
+    reconnectAttempt = 0;
+    currentConnection = hdl;
+    linkMonitor.reset(MessagePipeline::nowNs());
     Authenticator auth;
-    manager = new OrderManager(c, hdl);
-    // Authenticate
-    auth.send_authcall(c, hdl);
+    manager->attachConnection(c, hdl);
+    // Authenticate. Requests on a connection are answered in order, so everything
+    // below runs on the authenticated session.
+    auth.send_authcall(c, hdl, manager->nextRequestId());
+    manager->enableCancelOnDisconnect([](const RpcResult& result) {
+        if (!result.ok) {
+            LOG_WARN("Could not enable cancel on disconnect: {}", result.errorMessage);
+        }
+    });
+    manager->setSubscriptions(&subscriptions);
+    manager->setHeartbeat(HeartbeatSeconds);
+    schedule_probe(c, hdl);
+
+    // Whatever happened while we were away (fills, cancels, orders from other sessions)
+    manager->reconcileOrders([](const RpcResult& result) {
+        if (!result.ok) {
+            LOG_WARN("Could not reconcile orders: {}", result.errorMessage);
+        } else {
+            LOG_INFO("Orders reconciled, {} corrected", result.reconciledCount);
+        }
+    });
+    manager->reconcilePositions([](const RpcResult& result) {
+        if (!result.ok) {
+            LOG_WARN("Could not reconcile positions: {}", result.errorMessage);
+        } else {
+            LOG_INFO("Positions reconciled, {} corrected", result.reconciledCount);
+        }
+    });
+
+    OrderManager* loading = manager;
+    manager->loadInstruments("any", [loading](const RpcResult& result) {
+        if (!result.ok) {
+            LOG_WARN("Could not load instruments: {}", result.errorMessage);
+        } else if (loading->saveInstrumentCache(instrumentCachePath)) {
+            LOG_INFO("Loaded {} instruments, saved to {}", result.instrumentCount, instrumentCachePath);
+        }
+    });
 
     // Notify the menu thread that the connection is open
     {
@@ -53,36 +175,80 @@ void on_open(websocketpp::connection_hdl hdl, client* c) {
     cv.notify_one();
 }
 
-void on_message(websocketpp::connection_hdl hdl, client::message_ptr msg) {
-    std::string payload = msg->get_payload();
-    try {
-        auto jsonData = nlohmann::json::parse(payload);
-
-        if (jsonData.contains("result")) {
-            if (manager) {
-                manager->processApiResponse(payload);
-            } else {
-                std::cerr << "Manager is not initialized!" << std::endl;
-            }
+// Runs on the dispatcher thread for every received frame
+void dispatch_frame(InboundFrame& frame) {
+    ReceiveTimes received;
+    received.rxNs = frame.rxNs;
+    received.dequeuedNs = MessagePipeline::nowNs();
+    const std::string& payload = frame.payload;
+    if (capture.isOpen()) {
+        capture.append(FrameDirection::Inbound, frame.rxNs, payload);
+    }
+    DeribitMessage message;
+    if (!decodeMessage(payload, message)) {
+        LOG_ERROR("JSON parsing error: malformed message");
+        return;
+    }
+    received.decodedNs = MessagePipeline::nowNs();
+    if (message.usOut > message.usIn && message.usIn > 0) {
+        received.exchangeNs = (message.usOut - message.usIn) * 1000;
+    }
+
+    // Market data notifications are far too frequent to print
+    if (message.kind == MessageKind::Subscription) {
+        if (manager) {
+            manager->processSubscription(message);
+        }
+        return;
+    }
+
+    // Our own link probes (public/test) stop here
+    if (message.kind == MessageKind::Result && message.hasId &&
+        linkMonitor.probeAnswered(message.id, frame.rxNs, message.usIn, message.usOut)) {
+        return;
+    }
+
+    if (message.kind == MessageKind::Result || message.kind == MessageKind::Error) {
+        if (manager) {
+            manager->processApiResponse(message, received);
+        } else {
+            LOG_ERROR("Manager is not initialized");
         }
+    }
+    if (message.kind == MessageKind::Error) {
+        LOG_WARN("API error {}: {}", message.errorCode, message.errorMessage);
+    }
+
+    // For other messages, process as needed
+    LOG_DEBUG("Message received: {}", payload);
+}
 
-        // For other messages, process as needed
-        std::cout << "Message received: " << jsonData.dump(4) << "\n";
-    } catch (const nlohmann::json::exception& e) {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
+void on_message(websocketpp::connection_hdl hdl, client::message_ptr msg) {
+    // Only hand the payload over; decoding and handlers run on the dispatcher thread
+    InboundFrame frame;
+    frame.rxNs = MessagePipeline::nowNs();
+    frame.payload = std::move(msg->get_raw_payload());
+    linkMonitor.frameReceived(frame.rxNs);
+    // The exchange drops connections that leave a test_request unanswered; answer it right here
+    if (LinkMonitor::isTestRequest(frame.payload) && manager) {
+        linkMonitor.probeSent(manager->sendTest(), frame.rxNs);
     }
+    pipeline.push(std::move(frame));
 }
 
-void on_fail(websocketpp::connection_hdl hdl) {
-    std::cout << "WebSocket connection failed!" << std::endl;
+void on_fail(websocketpp::connection_hdl hdl, client* c) {
+    LOG_ERROR("WebSocket connection failed");
+    schedule_reconnect(c);
 }
 
-void on_close(websocketpp::connection_hdl hdl) {
-    std::cout << "WebSocket connection closed!" << std::endl;
+void on_close(websocketpp::connection_hdl hdl, client* c) {
+    LOG_INFO("WebSocket connection closed");
 
+    // Let the dispatcher finish with everything already received, then fail what is still in flight.
+    // Orders, positions and books stay; the next connection reconciles them.
+    pipeline.flush();
     if (manager) {
-        delete manager;
-        manager = nullptr;
+        manager->detachConnection();
     }
 
     // Notify the menu thread that the connection is closed
@@ -90,6 +256,7 @@ void on_close(websocketpp::connection_hdl hdl) {
         std::lock_guard<std::mutex> lock(mtx);
         connectionOpen = false;
     }
+    schedule_reconnect(c);
 }
 
 context_ptr on_tls_init(const char* hostname, websocketpp::connection_hdl) {
@@ -100,38 +267,134 @@ context_ptr on_tls_init(const char* hostname, websocketpp::connection_hdl) {
                          boost::asio::ssl::context::no_sslv3 |
                          boost::asio::ssl::context::single_dh_use);
     } catch (std::exception& e) {
-        std::cout << "TLS Initialization Error: " << e.what() << std::endl;
+        LOG_ERROR("TLS Initialization Error: {}", e.what());
     }
 
     return ctx;
 }
 
+// Offline run: feed a capture through the dispatcher into a manager with no connection,
+// then print throughput and the resulting books so runs can be compared.
+int run_replay(const std::string& path, double speed) {
+    manager = new OrderManager(nullptr, websocketpp::connection_hdl());
+    if (capture.isOpen()) {
+        manager->setCapture(&capture);
+    }
+
+    ReplayStats stats;
+    bool replayed = replayFrameLog(path, pipeline, speed, stats);
+    pipeline.stop();
+    if (replayed) {
+        double seconds = stats.elapsedNs / 1e9;
+        PipelineStats pipelineStats = pipeline.stats();
+        std::cout << "Replayed " << stats.frames << " frames (" << stats.bytes << " bytes) in " << seconds << " s: "
+                  << (seconds > 0 ? stats.frames / seconds : 0) << " frames/s, "
+                  << (seconds > 0 ? stats.bytes / seconds / 1e6 : 0) << " MB/s\n";
+        std::cout << "Queue wait avg/max (us): " << pipelineStats.avgQueueNs / 1000.0 << " / " << pipelineStats.maxQueueNs / 1000.0
+                  << "  Dispatch avg/max (us): " << pipelineStats.avgDispatchNs / 1000.0 << " / " << pipelineStats.maxDispatchNs / 1000.0 << "\n";
+
+        for (const std::string& instrument : manager->getBookInstruments()) {
+            BookTop top;
+            manager->getBookTop(instrument, 1, top);
+            std::cout << instrument << " change_id " << top.changeId << (top.synced ? "" : " (out of sync)");
+            if (!top.bids.empty()) std::cout << " bid " << top.bids[0].amount.toString() << " @ " << top.bids[0].price.toString();
+            if (!top.asks.empty()) std::cout << " ask " << top.asks[0].amount.toString() << " @ " << top.asks[0].price.toString();
+            std::cout << "\n";
+        }
+    }
+
+    delete manager;
+    manager = nullptr;
+    return replayed ? 0 : 1;
+}
 
 // Main function
+//   --capture FILE   record every frame sent and received to FILE
+//   --replay FILE    run FILE offline instead of connecting
+//   --speed X        replay pacing: 0 (default) as fast as possible, 1 as recorded, 2 twice as fast, ...
+//   --endpoint URI   websocket endpoint, e.g. wss://localhost:8443/ws/api/v2 for mock_deribit
+//                    (default: $DERIBIT_WS_URL, then the Deribit testnet)
+//   --log FILE       log file (default trading.log); $LOG_LEVEL sets the level (trace .. error, default info)
+//   --instruments FILE  instrument spec cache (default instruments.cache)
 int main(int argc, char* argv[]) {
+    const char* endpointEnv = std::getenv("DERIBIT_WS_URL");
+    std::string uri = endpointEnv ? endpointEnv : "wss://test.deribit.com/ws/api/v2";
+    std::string capturePath, replayPath, logPath = "trading.log";
+    double replaySpeed = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag == "--capture") capturePath = argv[i + 1];
+        else if (flag == "--replay") replayPath = argv[i + 1];
+        else if (flag == "--speed") replaySpeed = std::atof(argv[i + 1]);
+        else if (flag == "--endpoint") uri = argv[i + 1];
+        else if (flag == "--log") logPath = argv[i + 1];
+        else if (flag == "--instruments") instrumentCachePath = argv[i + 1];
+        else std::cerr << "Unknown option " << flag << std::endl;
+    }
+    if (!capturePath.empty() && !capture.open(capturePath)) {
+        return 1;
+    }
+    const char* logLevel = std::getenv("LOG_LEVEL");
+    if (logLevel) {
+        logger().setLevel(parseLogLevel(logLevel));
+    }
+    logger().start(logPath);
+    logger().setThreadName("main");
+
     client c;
-    std::string hostname = "test.deribit.com/ws/api/v2";
-    std::string uri = "wss://" + hostname;
+    // Host part of the URI, for the TLS handler
+    std::string hostname = uri.substr(uri.find("://") == std::string::npos ? 0 : uri.find("://") + 3);
+    hostname = hostname.substr(0, hostname.find_first_of(":/"));
     Menu menu;
+    menu.attachPipeline(&pipeline);
+    menu.attachLatencyStats(&latency);
+    menu.attachLinkMonitor(&linkMonitor);
+    menu.attachDirtyFlags(&displayChanges);
+
+    // DISPATCH_CPU pins the message dispatcher thread to a core
+    const char* dispatchCpu = std::getenv("DISPATCH_CPU");
+    pipeline.start(dispatchCpu ? std::atoi(dispatchCpu) : -1);
+    if (!replayPath.empty()) {
+        return run_replay(replayPath, replaySpeed);
+    }
     try {
-        c.set_access_channels(websocketpp::log::alevel::all);
-        c.clear_access_channels(websocketpp::log::alevel::frame_payload);
-        c.set_error_channels(websocketpp::log::elevel::all);
+        // Connection lifecycle only: per-frame access logging cost more than the frames themselves
+        c.clear_access_channels(websocketpp::log::alevel::all);
+        c.set_access_channels(websocketpp::log::alevel::connect | websocketpp::log::alevel::disconnect |
+                              websocketpp::log::alevel::fail);
+        c.set_error_channels(websocketpp::log::elevel::warn | websocketpp::log::elevel::rerror |
+                             websocketpp::log::elevel::fatal);
+        c.get_alog().set_ostream(&websocketAccessLog);
+        c.get_elog().set_ostream(&websocketErrorLog);
         c.init_asio();
 
+        // One manager for the whole run: it keeps its state across reconnects
+        manager = new OrderManager(&c, websocketpp::connection_hdl());
+        if (capture.isOpen()) {
+            manager->setCapture(&capture);
+        }
+        manager->setLatencyStats(&latency);
+        manager->setDirtyFlags(&displayChanges);
+        // Specs from the last run let orders be rounded straight away; the refresh replaces them
+        size_t cached = manager->loadInstrumentCache(instrumentCachePath);
+        LOG_INFO("Loaded {} instruments from {}", cached, instrumentCachePath);
+        manager->setCandleDirectory(candleDirectory);
+
         c.set_message_handler(&on_message);
         c.set_tls_init_handler(bind(&on_tls_init, hostname.c_str(), ::_1));
         c.set_open_handler(bind(&on_open, ::_1, &c));
-        c.set_fail_handler(bind(&on_fail, ::_1));
-        c.set_close_handler([](websocketpp::connection_hdl hdl) {
-            on_close(hdl);
+        c.set_fail_handler(bind(&on_fail, ::_1, &c));
+        c.set_close_handler([&c](websocketpp::connection_hdl hdl) {
+            on_close(hdl, &c);
         });
 
-        c.set_error_channels(websocketpp::log::elevel::all);  // Enable detailed error logging
         websocketpp::lib::error_code ec;
+        endpointUri = uri;
         client::connection_ptr con = c.get_connection(uri, ec);
         if (ec) {
-            std::cout << "Could not create connection because: " << ec.message() << std::endl;
+            LOG_ERROR("Could not create connection because: {}", ec.message());
+            logger().stop();
+            std::cerr << "Could not create connection because: " << ec.message() << std::endl;
             return 0;
         }
         c.connect(con);
@@ -145,6 +408,7 @@ int main(int argc, char* argv[]) {
             menu.showInteractiveMenu(manager);
             websocketpp::lib::error_code ec;
 
+            shuttingDown = true;
             c.stop();
             // while (true) {
             //     menu.displayMenu();
@@ -213,11 +477,16 @@ int main(int argc, char* argv[]) {
 
         c.run();
         menuThread.join();
+        pipeline.stop();
         if (manager) {
     delete manager;
     manager = nullptr;
 }
+        logger().stop();
+        std::cout << "Order round trip latency:\n";
+        latency.dump(std::cout);
     } catch (websocketpp::exception const& e) {
+        logger().stop();
         std::cout << "WebSocket Exception: " << e.what() << std::endl;
     }
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
+#include<cstdint>
 #include<string>
+#include<string_view>
 #include<stdexcept>
 
 // OrderType enum
-enum class OrderType {
+enum class OrderType : uint8_t {
     limit,
     stop_limit,
     take_limit,
@@ -15,13 +17,27 @@ enum class OrderType {
 };
 
 // InstrumentType enum
-enum class InstrumentType {
+enum class InstrumentType : uint8_t {
     Spot,
     Futures,
     Options
 };
 
 
+// OrderSide enum
+enum class OrderSide : uint8_t {
+    Buy,
+    Sell
+};
+
+// TriggerType enum (stop/take orders)
+enum class TriggerType : uint8_t {
+    None,
+    LastPrice,
+    MarkPrice,
+    IndexPrice
+};
+
 // Parse InstrumentType
 inline InstrumentType parseInstrumentType(const std::string& type) {
     if (type == "Spot") return InstrumentType::Spot;
@@ -80,3 +96,34 @@ inline OrderType stringToOrderType(const std::string& str) {
 
     throw std::invalid_argument("Invalid order type: " + str);
 }
+
+// Parse OrderSide ("buy"/"sell")
+inline OrderSide parseOrderSide(std::string_view side) {
+    if (side == "buy") return OrderSide::Buy;
+    if (side == "sell") return OrderSide::Sell;
+
+    throw std::invalid_argument("Invalid order side: " + std::string(side));
+}
+
+// OrderSide to string
+inline const char* orderSideToString(OrderSide side) {
+    return side == OrderSide::Buy ? "buy" : "sell";
+}
+
+// Parse TriggerType; anything unknown is None
+inline TriggerType parseTriggerType(std::string_view trigger) {
+    if (trigger == "last_price") return TriggerType::LastPrice;
+    if (trigger == "mark_price") return TriggerType::MarkPrice;
+    if (trigger == "index_price") return TriggerType::IndexPrice;
+    return TriggerType::None;
+}
+
+// TriggerType to string ("" for None)
+inline const char* triggerTypeToString(TriggerType trigger) {
+    switch (trigger) {
+        case TriggerType::LastPrice: return "last_price";
+        case TriggerType::MarkPrice: return "mark_price";
+        case TriggerType::IndexPrice: return "index_price";
+        default: return "";
+    }
+}